@@ -0,0 +1,194 @@
+#include "Bench.h"
+
+#if defined(WINDOWS)
+	#include <winsock2.h>
+	typedef SOCKET Socket;
+	typedef int socklen_t;
+	#define CloseSocket closesocket
+#else
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <unistd.h>
+	typedef int Socket;
+	#define CloseSocket close
+#endif
+
+namespace {
+
+std::atomic<uint64_t> s_heapAllocations(0);
+
+}
+
+// Every bench counts its allocations, it costs an atomic add per new
+void *operator new(size_t size)
+{
+	s_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	if(auto memory = malloc(size ? size : 1))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *memory) NOEXCEPT
+{
+	free(memory);
+}
+
+namespace Copy {
+	namespace Bench {
+
+/**
+ * Now - Seconds on a steady clock
+ */
+double Now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Fill - Fills size bytes at data with random bytes
+ */
+void Random::Fill(void *data, size_t size)
+{
+	auto bytes = static_cast<uint8_t *>(data);
+	for(; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+	{
+		auto value = Next();
+		memcpy(bytes, &value, sizeof(value));
+	}
+
+	auto value = Next();
+	memcpy(bytes, &value, size);
+}
+
+/**
+ * Server - Starts listening on an ephemeral loopback port
+ */
+Server::Server(Handler handler, uint32_t latency) :
+	m_handler(std::move(handler)), m_latency(latency)
+{
+#if defined(WINDOWS)
+	static std::once_flag s_started;
+	std::call_once(s_started, []()
+		{
+			WSADATA wsaData;
+			WSAStartup(MAKEWORD(2, 2), &wsaData);
+		});
+#endif
+
+	auto listener = socket(AF_INET, SOCK_STREAM, 0);
+	m_socket = static_cast<intptr_t>(listener);
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	socklen_t size = sizeof(address);
+	if(bind(listener, reinterpret_cast<sockaddr *>(&address), size) || listen(listener, 128) ||
+		getsockname(listener, reinterpret_cast<sockaddr *>(&address), &size))
+		throw std::logic_error("Failed to start the bench server");
+
+	m_port = ntohs(address.sin_port);
+	std::thread([this]() { Accept(); }).detach();
+}
+
+void Server::Accept()
+{
+	while(true)
+	{
+		auto client = accept(static_cast<Socket>(m_socket), nullptr, nullptr);
+		if(client == static_cast<Socket>(-1))
+			return;
+
+		std::thread([this, client]() { Serve(static_cast<intptr_t>(client)); }).detach();
+	}
+}
+
+void Server::Serve(intptr_t socket)
+{
+	auto client = static_cast<Socket>(socket);
+
+	std::string request;
+	std::vector<char> buffer(64 * 1024);
+	bool continued = false;
+	while(true)
+	{
+		// Wait for the headers and however much body they announce
+		auto headerEnd = request.find("\r\n\r\n");
+		if(headerEnd != std::string::npos)
+		{
+			size_t bodySize = 0;
+			auto length = request.find("Content-Length:");
+			if(length != std::string::npos && length < headerEnd)
+				bodySize = strtoul(request.c_str() + length + 15, nullptr, 10);
+
+			// curl holds back large bodies until it's told to go ahead
+			auto expect = request.find("Expect: 100-continue");
+			if(!continued && expect != std::string::npos && expect < headerEnd)
+			{
+				static const char proceed[] = "HTTP/1.1 100 Continue\r\n\r\n";
+				send(client, proceed, sizeof(proceed) - 1, 0);
+				continued = true;
+			}
+
+			if(request.size() >= headerEnd + 4 + bodySize)
+			{
+				auto pathStart = request.find(' ') + 1;
+				auto path = request.substr(pathStart, request.find(' ', pathStart) - pathStart);
+				auto body = m_handler(path, request.substr(headerEnd + 4, bodySize));
+
+				request.erase(0, headerEnd + 4 + bodySize);
+				continued = false;
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(m_latency));
+
+				auto reply = "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+				for(size_t sent = 0; sent < reply.size();)
+				{
+					auto wrote = send(client, reply.data() + sent, static_cast<int>(reply.size() - sent), 0);
+					if(wrote <= 0)
+						break;
+					sent += wrote;
+				}
+				continue;
+			}
+		}
+
+		auto read = recv(client, buffer.data(), static_cast<int>(buffer.size()), 0);
+		if(read <= 0)
+			break;
+
+		request.append(buffer.data(), read);
+	}
+
+	CloseSocket(client);
+}
+
+/**
+ * GetResidentSize - Reads the resident and shared page counts from /proc
+ */
+uint64_t GetResidentSize(bool anonymous)
+{
+#if defined(__linux__)
+	std::ifstream statm("/proc/self/statm");
+
+	uint64_t size = 0, resident = 0, shared = 0;
+	if(!(statm >> size >> resident >> shared))
+		return 0;
+
+	return (anonymous ? resident - shared : resident) * sysconf(_SC_PAGESIZE);
+#else
+	(void)anonymous;
+	return 0;
+#endif
+}
+
+uint64_t GetHeapAllocations()
+{
+	return s_heapAllocations.load(std::memory_order_relaxed);
+}
+
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "CloudApi/Common.h"
+
+namespace Copy {
+	namespace Bench {
+
+double Now();
+
+/**
+ * Best - Runs func runs times and returns the fastest run in milliseconds
+ */
+template<class F>
+double Best(uint32_t runs, F func)
+{
+	double best = std::numeric_limits<double>::max();
+	for(uint32_t i = 0; i < runs; i++)
+	{
+		auto start = Now();
+		func();
+		best = std::min(best, Now() - start);
+	}
+
+	return best * 1000;
+}
+
+/**
+ * Sink - Keeps the compiler from dropping work whose result isn't otherwise used
+ */
+template<class T>
+void Sink(const T &value)
+{
+	static volatile uint64_t s_sink;
+	s_sink = s_sink + static_cast<uint64_t>(value);
+}
+
+/**
+ * Random - A small fixed seed generator (splitmix64), so every run of a
+ * benchmark works on the same data
+ */
+class Random
+{
+public:
+	Random(uint64_t seed = 0x9E3779B97F4A7C15ull) : m_state(seed) {}
+
+	uint64_t Next()
+	{
+		auto value = (m_state += 0x9E3779B97F4A7C15ull);
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+	void Fill(void *data, size_t size);
+
+protected:
+	uint64_t m_state;
+};
+
+/**
+ * Server - A keep alive http server on 127.0.0.1 for benchmarks to post to.
+ * Each connection gets a thread of its own, every request is answered with
+ * whatever handler returns for its path and body after latency
+ */
+class Server
+{
+public:
+	typedef std::function<std::string (const std::string &path, const std::string &body)> Handler;
+
+	Server(Handler handler, uint32_t latency = 0);
+
+	std::string GetAddress() const { return "http://127.0.0.1:" + std::to_string(m_port); }
+
+protected:
+	Server(const Server &);
+	Server & operator = (const Server &);
+
+	void Accept();
+	void Serve(intptr_t client);
+
+	Handler m_handler;
+	uint32_t m_latency;
+	intptr_t m_socket;
+	uint16_t m_port = 0;
+};
+
+/**
+ * GetResidentSize - Bytes of the process in memory, anonymous leaves out pages
+ * mapped from files. Both are 0 where this isn't measured
+ */
+uint64_t GetResidentSize(bool anonymous = false);
+
+/**
+ * GetHeapAllocations - Calls to operator new so far, from any thread
+ */
+uint64_t GetHeapAllocations();
+
+	}
+}
@@ -0,0 +1,139 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Runs the buffer traffic of an upload over and over: a block is read, cut
+ * into parts, the parts are packed into a send body that keeps the part list
+ * alive, as SendParts does, and a reply comes back in the pieces curl
+ * delivers. After the first pass every buffer, the body's segment list among
+ * them, should come off the pool's free lists, what's left on the heap is the
+ * shared part list made once a pass. The same traffic on std::vector buffers,
+ * the way Data used to hold its bytes, is shown alongside
+ *
+ * Usage: BufferPoolBench [MB per pass] [passes]
+ */
+namespace {
+
+static const size_t BLOCK_SIZE = 4 * 1024 * 1024;
+static const size_t PART_SIZE = 1024 * 1024;
+static const size_t REPLY_SIZE = 128 * 1024;
+static const size_t PIECE_SIZE = 16 * 1024;
+
+class PartsApi : public CloudApi
+{
+public:
+	PartsApi() : CloudApi(Config()) {}
+
+	using CloudApi::BinaryPackPartsRequest;
+};
+
+/**
+ * PooledPass - The upload's buffers as Data
+ */
+void PooledPass(PartsApi &api, const std::vector<uint8_t> &source, const std::vector<uint8_t> &piece)
+{
+	auto sharedParts = std::make_shared<std::vector<CloudApi::PartInfo>>();
+	auto &parts = *sharedParts;
+	for(size_t offset = 0; offset < source.size(); offset += BLOCK_SIZE)
+	{
+		Data block(BLOCK_SIZE);
+		block.Copy(BLOCK_SIZE, source.data() + offset);
+
+		parts.resize(BLOCK_SIZE / PART_SIZE);
+		for(size_t i = 0; i < parts.size(); i++)
+		{
+			parts[i].data = block.Slice(i * PART_SIZE, PART_SIZE);
+			parts[i].size = PART_SIZE;
+		}
+
+		auto body = api.BinaryPackPartsRequest(parts, 0, true);
+		body.KeepAlive(sharedParts);
+		Sink(body.Size());
+
+		Data reply;
+		for(size_t read = 0; read < REPLY_SIZE; read += PIECE_SIZE)
+			reply.Append(PIECE_SIZE, piece.data());
+		Sink(reply.Size());
+
+		parts.clear();
+	}
+}
+
+/**
+ * VectorPass - The same traffic the way it went when Data was a vector,
+ * zero filled on resize and a part was a copy of its bytes
+ */
+void VectorPass(const std::vector<uint8_t> &source, const std::vector<uint8_t> &piece)
+{
+	for(size_t offset = 0; offset < source.size(); offset += BLOCK_SIZE)
+	{
+		std::vector<uint8_t> block(BLOCK_SIZE);
+		memcpy(block.data(), source.data() + offset, BLOCK_SIZE);
+
+		std::vector<std::vector<uint8_t>> parts;
+		for(size_t partOffset = 0; partOffset < BLOCK_SIZE; partOffset += PART_SIZE)
+			parts.push_back(std::vector<uint8_t>(block.begin() + partOffset, block.begin() + partOffset + PART_SIZE));
+
+		std::vector<uint8_t> body;
+		for(auto &part : parts)
+			body.insert(body.end(), part.begin(), part.end());
+		Sink(body.size());
+
+		std::vector<uint8_t> reply;
+		for(size_t read = 0; read < REPLY_SIZE; read += PIECE_SIZE)
+		{
+			reply.resize(reply.size() + PIECE_SIZE);
+			memcpy(reply.data() + reply.size() - PIECE_SIZE, piece.data(), PIECE_SIZE);
+		}
+		Sink(reply.size());
+	}
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t size = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 64) * 1024 * 1024;
+	uint32_t passes = argc > 2 ? atoi(argv[2]) : 5;
+	size -= size % BLOCK_SIZE;
+
+	std::vector<uint8_t> source(size), piece(PIECE_SIZE);
+	Random().Fill(source.data(), source.size());
+	Random(1).Fill(piece.data(), piece.size());
+
+	PartsApi api;
+
+	std::cout << size / (1024 * 1024) << "MB per pass in " << BLOCK_SIZE / (1024 * 1024) << "MB blocks" << std::endl;
+	std::cout << std::setw(6) << "pass" << std::setw(14) << "pool allocs" << std::setw(14) << "pool reuses"
+		<< std::setw(10) << "new" << std::setw(10) << "ms" << std::setw(14) << "vector new" << std::setw(12) << "vector ms" << std::endl;
+
+	for(uint32_t pass = 1; pass <= passes; pass++)
+	{
+		auto before = BufferPool::Get().GetStats();
+		auto heapBefore = GetHeapAllocations();
+		auto start = Now();
+
+		PooledPass(api, source, piece);
+
+		auto ms = (Now() - start) * 1000;
+		auto heap = GetHeapAllocations() - heapBefore;
+		auto after = BufferPool::Get().GetStats();
+
+		heapBefore = GetHeapAllocations();
+		start = Now();
+
+		VectorPass(source, piece);
+
+		auto vectorMs = (Now() - start) * 1000;
+		auto vectorHeap = GetHeapAllocations() - heapBefore;
+
+		std::cout << std::setw(6) << pass << std::setw(14) << after.allocations - before.allocations
+			<< std::setw(14) << after.reuses - before.reuses << std::setw(10) << heap
+			<< std::fixed << std::setprecision(1) << std::setw(10) << ms
+			<< std::setw(14) << vectorHeap << std::setw(12) << vectorMs << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,154 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Chunks random data with FastCdc, then edits it and chunks it again to see
+ * how much of the edited stream lands in parts that were already sent. Fixed
+ * size parts, which is how files used to be cut, are measured the same way
+ *
+ * Usage: ChunkerBench [MB]
+ */
+namespace {
+
+static const size_t READ_SIZE = 8 * 1024 * 1024;
+static const size_t FIXED_PART_SIZE = 1024 * 1024;
+
+struct Part
+{
+	Fingerprint fingerprint;
+	uint64_t size;
+};
+
+/**
+ * ChunkCdc - Feeds data to a chunker in reads the size the example uses
+ */
+std::vector<Part> ChunkCdc(const std::vector<uint8_t> &data, const Chunker::Config &config)
+{
+	std::vector<Part> parts;
+	CloudApi::PartCallback collect = [&](CloudApi::PartInfo &part)
+		{
+			Part collected = { part.fingerprint, part.size };
+			parts.push_back(collected);
+		};
+
+	Chunker::FastCdc chunker(config);
+	for(size_t offset = 0; offset < data.size(); offset += READ_SIZE)
+		chunker.Feed(data.data() + offset, std::min(READ_SIZE, data.size() - offset), collect);
+	chunker.Finish(collect);
+
+	return parts;
+}
+
+std::vector<Part> ChunkFixed(const std::vector<uint8_t> &data)
+{
+	std::vector<Part> parts;
+	for(size_t offset = 0; offset < data.size(); offset += FIXED_PART_SIZE)
+	{
+		auto size = std::min(FIXED_PART_SIZE, data.size() - offset);
+
+		FingerprintContext context;
+		context.Update(data.data() + offset, size);
+
+		Part part = { context.Final(), size };
+		parts.push_back(part);
+	}
+
+	return parts;
+}
+
+/**
+ * Reused - Percent of the bytes in edited that are in parts original has
+ */
+double Reused(const std::vector<Part> &original, const std::vector<Part> &edited)
+{
+	std::unordered_set<Fingerprint> sent;
+	for(auto &part : original)
+		sent.insert(part.fingerprint);
+
+	uint64_t reused = 0, total = 0;
+	for(auto &part : edited)
+	{
+		total += part.size;
+		if(sent.count(part.fingerprint))
+			reused += part.size;
+	}
+
+	return total ? reused * 100.0 / total : 0;
+}
+
+void Insert(std::vector<uint8_t> &data)
+{
+	data.insert(data.begin() + data.size() / 10, 0x5A);
+}
+
+void Overwrite(std::vector<uint8_t> &data)
+{
+	Random(1).Fill(data.data() + data.size() / 2, 5000);
+}
+
+void Delete(std::vector<uint8_t> &data)
+{
+	auto offset = data.size() * 8 / 10;
+	data.erase(data.begin() + offset, data.begin() + offset + 12345);
+}
+
+void All(std::vector<uint8_t> &data)
+{
+	Insert(data);
+	Overwrite(data);
+	Delete(data);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t size = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+
+	std::vector<uint8_t> data(size);
+	Random().Fill(data.data(), data.size());
+
+	// Boundaries alone, without fingerprinting the parts
+	Chunker::Config scanOnly;
+	scanOnly.fingerprint = false;
+
+	size_t partCount = 0;
+	auto ms = Best(3, [&]() { partCount = ChunkCdc(data, scanOnly).size(); });
+	std::cout << size / (1024 * 1024) << "MB, default " << scanOnly.minSize / 1024 << "K/" << scanOnly.avgSize / 1024
+		<< "K/" << scanOnly.maxSize / 1024 << "K sizes, " << partCount << " parts" << std::endl;
+	std::cout << "Chunking " << std::fixed << std::setprecision(0) << size / (1024.0 * 1024.0) / (ms / 1000) << "MB/s" << std::endl;
+
+	auto originalCdc = ChunkCdc(data, Chunker::Config());
+	auto originalFixed = ChunkFixed(data);
+
+	struct Edit
+	{
+		const char *name;
+		void (*apply)(std::vector<uint8_t> &data);
+	};
+
+	static const Edit edits[] =
+	{
+		{ "1 byte insert", Insert },
+		{ "5000 byte overwrite", Overwrite },
+		{ "12345 byte delete", Delete },
+		{ "all three", All },
+	};
+
+	std::cout << std::endl << "Bytes in parts already sent after an edit" << std::endl;
+	std::cout << std::setw(22) << "edit" << std::setw(10) << "FastCdc" << std::setw(10) << "fixed" << std::endl;
+
+	for(auto &edit : edits)
+	{
+		auto edited = data;
+		edit.apply(edited);
+
+		std::cout << std::setw(22) << edit.name << std::setprecision(1)
+			<< std::setw(9) << Reused(originalCdc, ChunkCdc(edited, Chunker::Config())) << "%"
+			<< std::setw(9) << Reused(originalFixed, ChunkFixed(edited)) << "%" << std::endl;
+	}
+
+	return 0;
+}
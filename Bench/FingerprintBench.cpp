@@ -0,0 +1,99 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Fingerprints the same bytes cut into parts of different sizes. The two pass
+ * md5 then sha1 that CreateFingerprint used to run is compared with
+ * FingerprintContext, handed each part whole and in the 16KB pieces curl
+ * delivers. Parts past the cache size are where the single pass pays off
+ *
+ * Usage: FingerprintBench [total MB]
+ */
+namespace {
+
+/**
+ * TwoPass - The old fingerprint, all of data through md5 then all of it again
+ * through sha1
+ */
+Fingerprint TwoPass(const uint8_t *data, size_t size)
+{
+	Fingerprint fingerprint;
+
+	MD5_CTX md5;
+	MD5_Init(&md5);
+	MD5_Update(&md5, data, size);
+	MD5_Final(fingerprint.GetMd5(), &md5);
+
+	SHA_CTX sha1;
+	SHA1_Init(&sha1);
+	SHA1_Update(&sha1, data, size);
+	SHA1_Final(fingerprint.GetSha1(), &sha1);
+
+	return fingerprint;
+}
+
+Fingerprint SinglePass(const uint8_t *data, size_t size)
+{
+	FingerprintContext context;
+	context.Update(data, size);
+	return context.Final();
+}
+
+Fingerprint Streamed(const uint8_t *data, size_t size)
+{
+	static const size_t PIECE_SIZE = 16 * 1024;
+
+	FingerprintContext context;
+	for(size_t offset = 0; offset < size; offset += PIECE_SIZE)
+		context.Update(data + offset, std::min(PIECE_SIZE, size - offset));
+
+	return context.Final();
+}
+
+/**
+ * Throughput - MB/s of fingerprint over every part of partSize in data
+ */
+double Throughput(const std::vector<uint8_t> &data, size_t partSize, Fingerprint (*fingerprint)(const uint8_t *, size_t))
+{
+	auto ms = Best(3, [&]()
+		{
+			for(size_t offset = 0; offset + partSize <= data.size(); offset += partSize)
+				Sink(fingerprint(data.data() + offset, partSize).Hash());
+		});
+
+	return (data.size() / partSize * partSize) / (1024.0 * 1024.0) / (ms / 1000);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t total = (argc > 1 ? strtoul(argv[1], nullptr, 10) : 256) * 1024 * 1024;
+
+	std::vector<uint8_t> data(total);
+	Random().Fill(data.data(), data.size());
+
+	// Both ways have to agree before their speed means anything
+	if(TwoPass(data.data(), 1024 * 1024) != SinglePass(data.data(), 1024 * 1024) ||
+		TwoPass(data.data(), 1024 * 1024) != Streamed(data.data(), 1024 * 1024))
+		throw std::logic_error("Fingerprints don't match");
+
+	std::cout << total / (1024 * 1024) << "MB of random data, MB/s" << std::endl;
+	std::cout << std::setw(10) << "part" << std::setw(12) << "two pass" << std::setw(14) << "single pass" << std::setw(12) << "streamed" << std::endl;
+
+	static const size_t partSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024, 64 * 1024 * 1024 };
+	for(auto partSize : partSizes)
+	{
+		if(partSize > total)
+			break;
+
+		std::cout << std::setw(8) << partSize / 1024 << "KB" << std::fixed << std::setprecision(0)
+			<< std::setw(12) << Throughput(data, partSize, TwoPass)
+			<< std::setw(14) << Throughput(data, partSize, SinglePass)
+			<< std::setw(12) << Throughput(data, partSize, Streamed) << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,94 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Requests from any number of threads sharing one HandlePool, against a local
+ * keep alive server that holds every reply for a fixed latency. The pool is
+ * compared with the single handle CloudApi used to have, which every thread
+ * took turns on
+ *
+ * Usage: HandlePoolBench [latency ms] [seconds per run]
+ */
+namespace {
+
+/**
+ * Post - Sends one empty post on curl
+ */
+void Post(CURL *curl, const std::string &url)
+{
+	Http::Request request;
+	request.url = url;
+	request.Perform(curl);
+}
+
+/**
+ * Run - Calls post from threads threads for seconds, returns requests per
+ * second
+ */
+double Run(uint32_t threads, double seconds, const std::function<void ()> &post)
+{
+	std::atomic<uint64_t> requests(0);
+	auto end = Now() + seconds;
+	auto start = Now();
+
+	std::vector<std::thread> workers;
+	for(uint32_t i = 0; i < threads; i++)
+	{
+		workers.push_back(std::thread([&]()
+			{
+				while(Now() < end)
+				{
+					post();
+					requests++;
+				}
+			}));
+	}
+
+	for(auto &worker : workers)
+		worker.join();
+
+	return requests / (Now() - start);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t latency = argc > 1 ? atoi(argv[1]) : 10;
+	double seconds = argc > 2 ? atof(argv[2]) : 2;
+
+	Server server([](const std::string &, const std::string &) { return "ok"; }, latency);
+	auto url = server.GetAddress() + "/jsonrpc";
+
+	Http::HandlePool pool;
+
+	// The old CloudApi, one handle that every caller locked
+	std::mutex sharedLock;
+	auto shared = pool.Acquire();
+
+	std::cout << "Server latency " << latency << "ms, " << seconds << "s per run" << std::endl;
+	std::cout << std::setw(8) << "threads" << std::setw(16) << "shared req/s" << std::setw(16) << "pooled req/s" << std::endl;
+
+	for(uint32_t threads = 1; threads <= 16; threads *= 2)
+	{
+		auto single = Run(threads, seconds, [&]()
+			{
+				std::lock_guard<std::mutex> lock(sharedLock);
+				Post(shared, url);
+			});
+
+		auto pooled = Run(threads, seconds, [&]()
+			{
+				auto handle = pool.Checkout();
+				Post(handle.Get(), url);
+			});
+
+		std::cout << std::setw(8) << threads << std::fixed << std::setprecision(0)
+			<< std::setw(16) << single << std::setw(16) << pooled << std::endl;
+	}
+
+	pool.Release(shared);
+	return 0;
+}
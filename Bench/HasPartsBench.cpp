@@ -0,0 +1,139 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Matches generated has_object_parts replies against the parts asked about.
+ * The reply lists every part in a shuffled order and one in ten is missing
+ * from the cloud. ParseHasPartsReply's fingerprint index is compared with the
+ * pairwise hex compare it replaced, which is only run up to 10k parts
+ *
+ * Usage: HasPartsBench [largest part count]
+ */
+namespace {
+
+class PartsApi : public CloudApi
+{
+public:
+	PartsApi() : CloudApi(Config()) {}
+
+	using CloudApi::PART_ITEM;
+	using CloudApi::BinaryPackPartsRequest;
+	using CloudApi::BinaryParsePartsReply;
+	using CloudApi::GetFingerprints;
+	using CloudApi::ParseHasPartsReply;
+};
+
+/**
+ * MakeReply - Packs a reply listing every part in parts, a part the cloud
+ * doesn't have is listed with a size of 0
+ */
+Data MakeReply(PartsApi &api, const std::vector<CloudApi::PartInfo> &parts, Random &random)
+{
+	std::vector<CloudApi::PartInfo> listed(parts.size());
+	for(size_t i = 0; i < parts.size(); i++)
+	{
+		listed[i].fingerprint = parts[i].fingerprint;
+		listed[i].size = random.Next() % 10 ? parts[i].size : 0;
+	}
+
+	for(size_t i = listed.size(); i > 1; i--)
+		std::swap(listed[i - 1], listed[random.Next() % i]);
+
+	auto body = api.BinaryPackPartsRequest(listed, 0, false);
+	return body.GetStorage();
+}
+
+/**
+ * MatchPairwise - The old matching, every part's hex fingerprint is compared
+ * with every item in the reply until one matches
+ */
+size_t MatchPairwise(PartsApi &api, Data &reply, const std::vector<CloudApi::PartInfo> &parts)
+{
+	std::vector<PartsApi::PART_ITEM *> items;
+	api.BinaryParsePartsReply(reply, &items);
+
+	size_t needed = 0;
+	for(auto &part : parts)
+	{
+		auto hex = part.fingerprint.ToHex();
+		for(auto item : items)
+		{
+			if(hex == item->fingerprint)
+			{
+				if(!item->partSize || item->errorCode)
+					needed++;
+				break;
+			}
+		}
+	}
+
+	return needed;
+}
+
+/**
+ * Time - Best of runs of match on a fresh copy of reply each time, as parsing
+ * swaps the reply's byte order in place
+ */
+double Time(uint32_t runs, const Data &reply, const std::function<size_t (Data &reply)> &match, size_t &needed)
+{
+	double best = std::numeric_limits<double>::max();
+	for(uint32_t i = 0; i < runs; i++)
+	{
+		Data copy(reply.Size());
+		copy.Copy(reply.Size(), reply.Cast<uint8_t>());
+
+		auto start = Now();
+		needed = match(copy);
+		best = std::min(best, Now() - start);
+	}
+
+	return best * 1000;
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t largest = argc > 1 ? strtoul(argv[1], nullptr, 10) : 100000;
+
+	PartsApi api;
+	Random random;
+
+	std::cout << std::setw(8) << "parts" << std::setw(14) << "index ms" << std::setw(14) << "pairwise ms" << std::setw(10) << "needed" << std::endl;
+
+	for(size_t count = 1000; count <= largest; count *= 10)
+	{
+		std::vector<CloudApi::PartInfo> parts(count);
+		for(auto &part : parts)
+		{
+			random.Fill(part.fingerprint.GetBytes(), Fingerprint::SIZE);
+			part.size = 1024 * 1024;
+		}
+
+		auto reply = MakeReply(api, parts, random);
+		auto fingerprints = api.GetFingerprints(parts);
+
+		size_t needed = 0;
+		auto indexed = Time(5, reply, [&](Data &copy) { return api.ParseHasPartsReply(copy, fingerprints).needed.size(); }, needed);
+
+		std::cout << std::setw(8) << count << std::fixed << std::setprecision(2) << std::setw(14) << indexed;
+
+		if(count <= 10000)
+		{
+			size_t pairwiseNeeded = 0;
+			auto pairwise = Time(1, reply, [&](Data &copy) { return MatchPairwise(api, copy, parts); }, pairwiseNeeded);
+			if(pairwiseNeeded != needed)
+				throw std::logic_error("Pairwise and indexed matching disagree");
+
+			std::cout << std::setw(14) << pairwise;
+		}
+		else
+			std::cout << std::setw(14) << "-";
+
+		std::cout << std::setw(10) << needed << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,162 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Parses a generated list_objects reply three ways: into a JSON::Value tree,
+ * the way ParseJsonReply still reads replies, through ParseJsonDocument and
+ * ParseListReply, which reads each child with ParseCloudObj, and through
+ * ListReplyParser, which binds children straight from the reader's events as
+ * the reply is fed in the 64KB pieces curl hands over. Time is the fastest of
+ * five runs, new is operator new calls per parse
+ *
+ * Usage: ListBench [children]
+ */
+namespace {
+
+static const size_t PIECE_SIZE = 64 * 1024;
+
+class ListApi : public CloudApi
+{
+public:
+	ListApi() : CloudApi(Config()) {}
+
+	using CloudApi::ListReplyParser;
+	using CloudApi::ParseJsonDocument;
+	using CloudApi::ParseListReply;
+};
+
+/**
+ * MakeListing - A page of children the way list_objects sends them, numbers
+ * mostly as strings, one in four a directory, files with three parts and a
+ * few fields nothing reads
+ */
+std::string MakeListing(size_t children)
+{
+	Random random;
+
+	auto hex = [&random]()
+		{
+			static const char digits[] = "0123456789abcdef";
+			std::string fingerprint;
+			for(size_t i = 0; i < Fingerprint::HEX_SIZE; i++)
+				fingerprint += digits[random.Next() % 16];
+			return fingerprint;
+		};
+
+	std::ostringstream reply;
+	reply << "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"result\":{\"list_watermark\":" << children << ",\"more_items\":\"0\","
+		"\"object\":{\"path\":\"/bench\",\"type\":\"dir\",\"object_id\":\"1\"},\"children\":[";
+
+	for(size_t i = 0; i < children; i++)
+	{
+		auto dir = i % 4 == 0;
+		auto modified = 1400000000 + i;
+
+		reply << (i ? "," : "") << "{\"path\":\"/bench/" << (dir ? "folder_" : "file_") << i << (dir ? "" : ".dat") << "\","
+			<< "\"type\":\"" << (dir ? "dir" : "file") << "\",\"object_id\":\"" << i + 2 << "\","
+			<< "\"created_time\":" << modified << ",\"modified_time\":\"" << modified << "\",\"removed_time\":0,"
+			<< "\"share_id\":\"0\",\"public_link\":null,\"thumb\":false,\"stub\":{\"a\":[1,2,3],\"b\":\"unused\"},"
+			<< "\"attributes\":{\"mode\":420,\"uid\":1000}";
+
+		if(dir)
+			reply << ",\"children_count\":\"" << i % 50 << "\"}";
+		else
+		{
+			reply << ",\"size\":\"" << 3 * 1024 * 1024 << "\",\"revisions\":[{\"revision_id\":\"1\",\"parts\":[";
+			for(uint32_t part = 0; part < 3; part++)
+			{
+				reply << (part ? "," : "") << "{\"fingerprint\":\"" << hex() << "\",\"offset\":\"" << part * 1024 * 1024
+					<< "\",\"size\":\"" << 1024 * 1024 << "\"}";
+			}
+			reply << "]}]}";
+		}
+	}
+
+	reply << "]}}";
+	return reply.str();
+}
+
+/**
+ * Run - Best of five runs of parse, with the operator new calls one of them made
+ */
+double Run(const std::function<void ()> &parse, uint64_t &allocations)
+{
+	auto before = GetHeapAllocations();
+	parse();
+	allocations = GetHeapAllocations() - before;
+
+	return Best(5, parse);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t children = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000;
+
+	auto listing = MakeListing(children);
+	Data reply(listing);
+
+	ListApi api;
+
+	auto document = [&]()
+		{
+			std::map<std::string, std::string> headerFields;
+			auto parsed = api.ParseJsonDocument(reply, headerFields);
+
+			CloudApi::ListConfig config;
+			return api.ParseListReply(config, parsed->GetRoot().At("result"));
+		};
+
+	auto bound = [&]()
+		{
+			CloudApi::ListResult result;
+			ListApi::ListReplyParser parser(Http::HeaderFields(), true,
+				[&result](CloudApi::CloudObj &obj) { result.children.push_back(std::move(obj)); });
+
+			for(size_t offset = 0; offset < listing.size(); offset += PIECE_SIZE)
+				parser.Feed(reinterpret_cast<const uint8_t *>(listing.data()) + offset, std::min(PIECE_SIZE, listing.size() - offset));
+
+			auto finished = parser.Finish();
+			result.root = std::move(finished.root);
+			return result;
+		};
+
+	// Both have to read the same listing before their speed means anything
+	auto expected = document(), actual = bound();
+	if(expected.children.size() != children || actual.children.size() != children || expected.root.path != actual.root.path)
+		throw std::logic_error("Listings don't match");
+
+	for(size_t i = 0; i < children; i++)
+	{
+		auto &left = expected.children[i], &right = actual.children[i];
+		if(left.path != right.path || left.type != right.type || left.id != right.id || left.modifiedTime != right.modifiedTime ||
+			left.childCount != right.childCount || left.size != right.size || left.parts.size() != right.parts.size() ||
+			(!left.parts.empty() && left.parts.back().fingerprint != right.parts.back().fingerprint))
+			throw std::logic_error("Child " + std::to_string(i) + " doesn't match");
+	}
+
+	std::cout << children << " children, " << listing.size() / 1024 << "KB" << std::endl;
+	std::cout << std::setw(28) << "parse" << std::setw(10) << "ms" << std::setw(10) << "MB/s" << std::setw(12) << "new" << std::endl;
+
+	auto print = [&](const char *name, double ms, uint64_t allocations)
+		{
+			std::cout << std::setw(28) << name << std::fixed << std::setprecision(2) << std::setw(10) << ms
+				<< std::setprecision(0) << std::setw(10) << listing.size() / (1024.0 * 1024.0) / (ms / 1000)
+				<< std::setw(12) << allocations << std::endl;
+		};
+
+	uint64_t allocations = 0;
+	auto ms = Run([&]() { Sink(JSON::Parse(listing.data(), listing.size()) != nullptr); }, allocations);
+	print("JSON::Parse (tree only)", ms, allocations);
+
+	ms = Run([&]() { Sink(document().children.size()); }, allocations);
+	print("Document + ParseCloudObj", ms, allocations);
+
+	ms = Run([&]() { Sink(bound().children.size()); }, allocations);
+	print("ListReplyParser", ms, allocations);
+
+	return 0;
+}
@@ -0,0 +1,114 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Builds Value trees from one json object with a lot of members, with the
+ * names in order, reversed and shuffled, through every path that makes an
+ * Object member by member: JSON::Parse, Value::Parse, the streaming Reader
+ * feeding a ValueBuilder and a Document copied out with ToValue. Members out
+ * of order must not cost more than sorting them once
+ *
+ * Usage: ObjectBench [largest member count]
+ */
+namespace {
+
+enum Order
+{
+	ORDER_SORTED,
+	ORDER_REVERSED,
+	ORDER_SHUFFLED,
+};
+
+std::string MakeObject(size_t members, Order order)
+{
+	std::vector<size_t> names(members);
+	for(size_t i = 0; i < members; i++)
+		names[i] = i;
+
+	if(order == ORDER_REVERSED)
+		std::reverse(names.begin(), names.end());
+	else if(order == ORDER_SHUFFLED)
+	{
+		Random random;
+		for(size_t i = names.size(); i > 1; i--)
+			std::swap(names[i - 1], names[random.Next() % i]);
+	}
+
+	std::ostringstream object;
+	object << "{";
+	for(size_t i = 0; i < members; i++)
+		object << (i ? "," : "") << "\"member_" << std::setw(8) << std::setfill('0') << names[i] << "\":" << names[i];
+	object << "}";
+
+	return object.str();
+}
+
+void CheckObject(const JSON::ValuePtr &value, size_t members)
+{
+	auto &object = value->AsObject();
+	if(object.Size() != members || object.Get<uint64_t>("member_00000000") != 0 || object.begin()->key != "member_00000000")
+		throw std::logic_error("Object was misread");
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t largest = argc > 1 ? strtoul(argv[1], nullptr, 10) : 32768;
+
+	typedef std::function<JSON::ValuePtr (const std::string &json)> Parse;
+	static const struct
+	{
+		const char *name;
+		Parse parse;
+	} parsers[] =
+	{
+		{ "JSON::Parse", [](const std::string &json) { return JSON::Parse(json.data(), json.size()); } },
+		{ "Value::Parse", [](const std::string &json)
+			{
+				auto data = json.c_str();
+				return JSON::Value::Parse(&data);
+			} },
+		{ "ValueBuilder", [](const std::string &json)
+			{
+				JSON::ValueBuilder builder;
+				JSON::Reader reader(builder);
+				reader.Feed(json.data(), json.size());
+				reader.Finish();
+				return builder.Take();
+			} },
+		{ "Node::ToValue", [](const std::string &json)
+			{
+				JSON::Document document{Data(json)};
+				return document.GetRoot().ToValue();
+			} },
+	};
+
+	static const char *orders[] = { "sorted", "reversed", "shuffled" };
+
+	std::cout << std::setw(16) << "ms" << std::setw(10) << "members";
+	for(auto order : orders)
+		std::cout << std::setw(10) << order;
+	std::cout << std::endl;
+
+	for(auto &parser : parsers)
+	{
+		for(size_t members = 2048; members <= largest; members *= 4)
+		{
+			std::cout << std::setw(16) << parser.name << std::setw(10) << members;
+			for(auto order : { ORDER_SORTED, ORDER_REVERSED, ORDER_SHUFFLED })
+			{
+				auto json = MakeObject(members, order);
+				CheckObject(parser.parse(json), members);
+
+				auto ms = Best(3, [&]() { Sink(parser.parse(json)->AsObject().Size()); });
+				std::cout << std::fixed << std::setprecision(1) << std::setw(10) << ms;
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,239 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Runs the U8 module over a corpus of generated international filenames
+ * (Cyrillic, CJK, Hangul, Greek, Arabic, Hebrew, Devanagari, Thai and emoji,
+ * each behind a short ascii prefix). IsValid and StringLength are timed on the
+ * whole corpus and a filename at a time, next to the byte at a time walk they
+ * replaced. Then a list reply with every filename \u escaped, the way the
+ * cloud sends them, is parsed with Value::Parse at growing sizes, the time per
+ * MB stays flat now that escapes only look at their own digits
+ *
+ * Usage: U8Bench [filenames]
+ */
+namespace {
+
+struct Script
+{
+	const char *name;
+	uint32_t first, last;
+};
+
+static const Script s_scripts[] =
+{
+	{ "Cyrillic", 0x0410, 0x044F },
+	{ "CJK", 0x4E00, 0x9FFF },
+	{ "Hangul", 0xAC00, 0xD7A3 },
+	{ "Greek", 0x0391, 0x03C9 },
+	{ "Arabic", 0x0627, 0x064A },
+	{ "Hebrew", 0x05D0, 0x05EA },
+	{ "Devanagari", 0x0905, 0x0939 },
+	{ "Thai", 0x0E01, 0x0E2E },
+	{ "Emoji", 0x1F600, 0x1F64F },
+};
+
+/**
+ * Corpus - Filenames as utf8 and as the json string bodies the cloud would
+ * send for them
+ */
+struct Corpus
+{
+	std::vector<std::string> names;
+	std::vector<std::string> escaped;
+	std::string joined;					// Every name back to back
+};
+
+void Escape(uint32_t codepoint, std::string &escaped)
+{
+	char digits[16];
+	if(codepoint >= 0x10000)
+	{
+		codepoint -= 0x10000;
+		snprintf(digits, sizeof(digits), "\\u%04X", 0xD800 + (codepoint >> 10));
+		escaped += digits;
+		codepoint = 0xDC00 + (codepoint & 0x3FF);
+	}
+
+	snprintf(digits, sizeof(digits), "\\u%04X", codepoint);
+	escaped += digits;
+}
+
+Corpus MakeCorpus(size_t count)
+{
+	Random random;
+	Corpus corpus;
+
+	for(size_t i = 0; i < count; i++)
+	{
+		auto &script = s_scripts[i % (sizeof(s_scripts) / sizeof(s_scripts[0]))];
+
+		std::string name = "doc_" + std::to_string(i) + "_";
+		auto escaped = name;
+
+		auto length = 4 + random.Next() % 12;
+		for(uint64_t chr = 0; chr < length; chr++)
+		{
+			auto codepoint = script.first + static_cast<uint32_t>(random.Next() % (script.last - script.first + 1));
+			U8::Append(codepoint, name);
+			Escape(codepoint, escaped);
+		}
+
+		name += ".txt";
+		escaped += ".txt";
+
+		corpus.joined += name;
+		corpus.names.push_back(std::move(name));
+		corpus.escaped.push_back(std::move(escaped));
+	}
+
+	return corpus;
+}
+
+std::string MakeListing(const Corpus &corpus, size_t children)
+{
+	std::string reply = "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"result\":{\"list_watermark\":1,\"more_items\":\"0\",\"children\":[";
+	for(size_t i = 0; i < children; i++)
+	{
+		reply += i ? ",{\"path\":\"/intl/" : "{\"path\":\"/intl/";
+		reply += corpus.escaped[i % corpus.escaped.size()];
+		reply += "\",\"type\":\"file\",\"size\":\"" + std::to_string(i * 1000) + "\"}";
+	}
+
+	return reply + "]}}";
+}
+
+/**
+ * CharSize - The lead byte table the module used to step through strings with
+ */
+uint32_t CharSize(uint8_t lead)
+{
+	return lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+}
+
+/**
+ * WalkIsValid - The old validation, a character at a time
+ */
+bool WalkIsValid(const char *str, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(str);
+	for(size_t i = 0; i < size;)
+	{
+		auto lead = bytes[i];
+		if(lead < 0x80)
+		{
+			i++;
+			continue;
+		}
+
+		if(lead < 0xC2 || lead > 0xF4)
+			return false;
+
+		auto charSize = CharSize(lead);
+		if(i + charSize > size)
+			return false;
+
+		uint32_t codepoint = lead & (0x7F >> charSize);
+		for(uint32_t j = 1; j < charSize; j++)
+		{
+			if((bytes[i + j] & 0xC0) != 0x80)
+				return false;
+			codepoint = (codepoint << 6) | (bytes[i + j] & 0x3F);
+		}
+
+		static const uint32_t smallest[] = { 0, 0, 0x80, 0x800, 0x10000 };
+		if(codepoint < smallest[charSize] || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+			return false;
+
+		i += charSize;
+	}
+
+	return true;
+}
+
+size_t WalkLength(const char *str, size_t size)
+{
+	size_t length = 0;
+	for(size_t i = 0; i < size; i += CharSize(static_cast<uint8_t>(str[i])))
+		length++;
+
+	return length;
+}
+
+/**
+ * Rate - GB/s of size bytes done in ms
+ */
+double Rate(size_t size, double ms)
+{
+	return size / (1024.0 * 1024.0 * 1024.0) / (ms / 1000);
+}
+
+}
+
+int main(int argc, char **argv)
+{
+	size_t count = argc > 1 ? strtoul(argv[1], nullptr, 10) : 20000;
+
+	auto corpus = MakeCorpus(count);
+	auto &joined = corpus.joined;
+
+	// Both ways have to agree before their speed means anything
+	if(!U8::IsValid(joined.data(), joined.size()) || !WalkIsValid(joined.data(), joined.size()) ||
+		U8::StringLength(joined.data(), joined.size()) != WalkLength(joined.data(), joined.size()))
+		throw std::logic_error("U8 and the character walk disagree on the corpus");
+
+	std::cout << count << " filenames, " << joined.size() / 1024 << "KB, " << U8::StringLength(joined.data(), joined.size())
+		<< " characters, " << U8::GetKernelName() << " kernel" << std::endl;
+	std::cout << std::setw(24) << "GB/s" << std::setw(10) << "walk" << std::setw(10) << "U8" << std::endl;
+
+	auto print = [&](const char *name, double walk, double u8)
+		{
+			std::cout << std::setw(24) << name << std::fixed << std::setprecision(2)
+				<< std::setw(10) << Rate(joined.size(), walk) << std::setw(10) << Rate(joined.size(), u8) << std::endl;
+		};
+
+	print("IsValid, whole corpus",
+		Best(20, [&]() { Sink(WalkIsValid(joined.data(), joined.size())); }),
+		Best(20, [&]() { Sink(U8::IsValid(joined.data(), joined.size())); }));
+
+	print("IsValid, each name",
+		Best(20, [&]() { for(auto &name : corpus.names) Sink(WalkIsValid(name.data(), name.size())); }),
+		Best(20, [&]() { for(auto &name : corpus.names) Sink(U8::IsValid(name.data(), name.size())); }));
+
+	print("StringLength, whole",
+		Best(20, [&]() { Sink(WalkLength(joined.data(), joined.size())); }),
+		Best(20, [&]() { Sink(U8::StringLength(joined.data(), joined.size())); }));
+
+	print("StringLength, each name",
+		Best(20, [&]() { for(auto &name : corpus.names) Sink(WalkLength(name.data(), name.size())); }),
+		Best(20, [&]() { for(auto &name : corpus.names) Sink(U8::StringLength(name.data(), name.size())); }));
+
+	// The escaped reply has to decode to the same tree the document parser builds
+	auto largest = MakeListing(corpus, count);
+	auto cursor = largest.c_str();
+	if(JSON::Value::Parse(&cursor)->Stringify() != JSON::Parse(largest.data(), largest.size())->Stringify())
+		throw std::logic_error("Value::Parse and JSON::Parse disagree on the escaped listing");
+
+	std::cout << std::endl << "Value::Parse of the \\u escaped listing" << std::endl;
+	std::cout << std::setw(10) << "children" << std::setw(10) << "KB" << std::setw(10) << "ms" << std::setw(10) << "ms/MB" << std::endl;
+
+	for(size_t children = count / 16; children <= count; children *= 2)
+	{
+		auto listing = MakeListing(corpus, children);
+		auto ms = Best(3, [&]()
+			{
+				auto data = listing.c_str();
+				Sink(JSON::Value::Parse(&data) != nullptr);
+			});
+
+		std::cout << std::setw(10) << children << std::setw(10) << listing.size() / 1024 << std::fixed << std::setprecision(2)
+			<< std::setw(10) << ms << std::setw(10) << ms / (listing.size() / (1024.0 * 1024.0)) << std::endl;
+
+		if(!children)
+			break;
+	}
+
+	return 0;
+}
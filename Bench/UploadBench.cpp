@@ -0,0 +1,168 @@
+#include "Bench.h"
+
+using namespace Copy;
+using namespace Copy::Bench;
+
+/**
+ * Uploads a file of random data through UploadPipeline to a local server that
+ * claims to be missing every part, once with the file mapped and once read
+ * through the request queue. Peak resident memory over the start of each run
+ * is sampled as it goes, anonymous memory is the part that isn't page cache
+ * and is what mapping the file saves. The mapped run goes first so the read
+ * run's buffers, which the buffer pool keeps, don't count against it
+ *
+ * Usage: UploadBench [MB] [temp file]
+ */
+namespace {
+
+class PartsApi : public CloudApi
+{
+public:
+	PartsApi(const Config &config) : CloudApi(config) {}
+
+	using CloudApi::PARTS_HEADER;
+	using CloudApi::PART_ITEM;
+};
+
+/**
+ * HasPartsReply - Echoes the parts asked about back with a size of 0, so all
+ * of them get sent
+ */
+std::string HasPartsReply(std::string body)
+{
+	for(auto offset = sizeof(PartsApi::PARTS_HEADER); offset + sizeof(PartsApi::PART_ITEM) <= body.size(); offset += sizeof(PartsApi::PART_ITEM))
+		memset(&body[offset + offsetof(PartsApi::PART_ITEM, partSize)], 0, sizeof(uint32_t));
+
+	return body;
+}
+
+/**
+ * SendPartsReply - Lists every part sent without its data
+ */
+std::string SendPartsReply(const std::string &body)
+{
+	std::string reply = body.substr(0, sizeof(PartsApi::PARTS_HEADER));
+
+	uint32_t partCount = 0;
+	for(size_t offset = sizeof(PartsApi::PARTS_HEADER); offset + sizeof(PartsApi::PART_ITEM) <= body.size();)
+	{
+		PartsApi::PART_ITEM item;
+		memcpy(&item, body.data() + offset, sizeof(item));
+		offset += NET32_CPU(item.dataSize);
+
+		item.dataSize = CPU32_NET(sizeof(item));
+		item.payloadSize = 0;
+		reply.append(reinterpret_cast<const char *>(&item), sizeof(item));
+		partCount++;
+	}
+
+	PartsApi::PARTS_HEADER header;
+	memcpy(&header, reply.data(), sizeof(header));
+	header.bodySize = CPU32_NET(static_cast<uint32_t>(reply.size() - sizeof(header)));
+	header.partCount = CPU32_NET(partCount);
+	memcpy(&reply[0], &header, sizeof(header));
+
+	return reply;
+}
+
+std::string Reply(const std::string &path, const std::string &body)
+{
+	if(path == "/has_object_parts")
+		return HasPartsReply(body);
+	else if(path == "/send_object_parts")
+		return SendPartsReply(body);
+
+	return "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"result\":{}}";
+}
+
+/**
+ * Peak - Samples resident memory on a thread of its own until it's destroyed
+ */
+class Peak
+{
+public:
+	Peak() :
+		m_resident(GetResidentSize()), m_anonymous(GetResidentSize(true)),
+		m_baseResident(m_resident), m_baseAnonymous(m_anonymous)
+	{
+		m_thread = std::thread([this]()
+			{
+				while(!m_done)
+				{
+					m_resident = std::max<uint64_t>(m_resident, GetResidentSize());
+					m_anonymous = std::max<uint64_t>(m_anonymous, GetResidentSize(true));
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				}
+			});
+	}
+
+	~Peak()
+	{
+		m_done = true;
+		m_thread.join();
+	}
+
+	// Growth over when sampling started, in MB
+	double Resident() const { return (m_resident - m_baseResident) / (1024.0 * 1024.0); }
+	double Anonymous() const { return (m_anonymous - m_baseAnonymous) / (1024.0 * 1024.0); }
+
+protected:
+	Peak(const Peak &);
+	Peak & operator = (const Peak &);
+
+	std::atomic<bool> m_done{false};
+	std::atomic<uint64_t> m_resident;
+	std::atomic<uint64_t> m_anonymous;
+	uint64_t m_baseResident;
+	uint64_t m_baseAnonymous;
+	std::thread m_thread;
+};
+
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t size = (argc > 1 ? strtoull(argv[1], nullptr, 10) : 512) * 1024 * 1024;
+	std::string path = argc > 2 ? argv[2] : "UploadBench.tmp";
+
+	{
+		std::ofstream file(path, std::ios::binary);
+		std::vector<uint8_t> block(8 * 1024 * 1024);
+		Random random;
+		for(uint64_t written = 0; written < size; written += block.size())
+		{
+			random.Fill(block.data(), block.size());
+			file.write(reinterpret_cast<const char *>(block.data()), std::min<uint64_t>(block.size(), size - written));
+		}
+
+		if(!file)
+			throw std::logic_error("Failed to write " + path);
+	}
+
+	Server server(Reply);
+
+	CloudApi::Config config;
+	config.address = server.GetAddress();
+	PartsApi api(config);
+
+	std::cout << size / (1024 * 1024) << "MB file, peak growth while uploading" << std::endl;
+	std::cout << std::setw(8) << "mode" << std::setw(10) << "seconds" << std::setw(14) << "resident MB" << std::setw(15) << "anonymous MB" << std::endl;
+
+	for(auto mapFile : { true, false })
+	{
+		Transfer::UploadPipeline::Config pipelineConfig;
+		pipelineConfig.mapFile = mapFile;
+		Transfer::UploadPipeline pipeline(api, pipelineConfig);
+
+		Peak peak;
+		auto start = Now();
+		pipeline.Upload(path, "/UploadBench");
+		auto seconds = Now() - start;
+
+		std::cout << std::setw(8) << (mapFile ? "mapped" : "read") << std::fixed << std::setprecision(2) << std::setw(10) << seconds
+			<< std::setprecision(0) << std::setw(14) << peak.Resident() << std::setw(15) << peak.Anonymous() << std::endl;
+	}
+
+	std::remove(path.c_str());
+	return 0;
+}
@@ -0,0 +1,235 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Chunker;
+
+/**
+ * FastCdc - Throws if the sizes don't satisfy minSize <= avgSize <= maxSize
+ */
+FastCdc::FastCdc(const Config &config) :
+	m_config(config)
+{
+	if(!m_config.minSize || m_config.minSize > m_config.avgSize || m_config.avgSize > m_config.maxSize)
+		throw std::logic_error("FastCdc: part sizes must satisfy 0 < minSize <= avgSize <= maxSize");
+
+	uint32_t bits = 0;
+	while(m_config.avgSize >> (bits + 1))
+		bits++;
+
+	// Boundaries are taken from the top bits of the hash, they depend on the
+	// last 64 bytes where the low bits only see the last few. Two bits either
+	// side of the average is the paper's normalization level 2
+	auto topBits = [](uint32_t count) { return count ? ~0ULL << (64 - std::min<uint32_t>(count, 63)) : 0ULL; };
+	m_smallMask = topBits(bits + 2);
+	m_largeMask = topBits(bits > 2 ? bits - 2 : 1);
+}
+
+/**
+ * GetGearTable - 256 random words mixed into the hash for each byte value. The
+ * table decides where every boundary falls, changing it would change every
+ * fingerprint and throw away all the dedupe against parts already in the cloud
+ */
+const uint64_t *FastCdc::GetGearTable()
+{
+	static const auto table = []()
+		{
+			// splitmix64 from a fixed seed
+			std::array<uint64_t, 256> table;
+			uint64_t state = 0x436f707943444331ULL;
+			for(auto &entry : table)
+			{
+				auto z = (state += 0x9e3779b97f4a7c15ULL);
+				z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+				z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+				entry = z ^ (z >> 31);
+			}
+			return table;
+		}();
+
+	return table.data();
+}
+
+/**
+ * Scan - Runs the hash over as much of data as belongs to the current part
+ * Returns the number of bytes taken, boundary is set if the part ends there
+ */
+size_t FastCdc::Scan(const uint8_t *data, size_t size, bool &boundary)
+{
+	auto gear = GetGearTable();
+	auto hash = m_hash;
+	size_t i = 0;
+
+	// Nothing under the minimum size can be a boundary, so it isn't hashed at all
+	if(m_length < m_config.minSize)
+		i = static_cast<size_t>(std::min<uint64_t>(m_config.minSize - m_length, size));
+
+	// Hashes up to the part length limit with mask, stopping at the first boundary
+	auto scanTo = [&](uint64_t limit, uint64_t mask)
+		{
+			auto end = static_cast<size_t>(std::min<uint64_t>(size, limit > m_length ? limit - m_length : 0));
+			for(; i < end; i++)
+			{
+				hash = (hash << 1) + gear[data[i]];
+				if(!(hash & mask))
+				{
+					i++;
+					return true;
+				}
+			}
+
+			return false;
+		};
+
+	boundary = scanTo(m_config.avgSize, m_smallMask) || scanTo(m_config.maxSize, m_largeMask) ||
+		m_length + i >= m_config.maxSize;
+
+	m_hash = hash;
+	m_length += i;
+	return i;
+}
+
+/**
+ * Emit - Closes off the part being built and adds it to parts
+ */
+void FastCdc::Emit(std::vector<CloudApi::PartInfo> &parts)
+{
+	CloudApi::PartInfo part;
+	part.data = std::move(m_pending);
+	part.size = m_length;
+	part.offset = m_offset;
+	parts.push_back(std::move(part));
+
+	m_pending = Data();
+	m_offset += m_length;
+	m_length = 0;
+	m_hash = 0;
+}
+
+/**
+ * FingerprintParts - Fingerprints everything one call produced together so
+ * the parts share SIMD lanes
+ */
+void FastCdc::FingerprintParts(std::vector<CloudApi::PartInfo> &parts)
+{
+	if(!m_config.fingerprint || parts.empty())
+		return;
+
+	std::vector<const uint8_t *> data;
+	std::vector<size_t> sizes;
+	std::vector<Fingerprint> fingerprints(parts.size());
+	for(auto &part : parts)
+	{
+		const auto &partData = part.data;
+		data.push_back(partData.Cast<uint8_t>());
+		sizes.push_back(partData.Size());
+	}
+
+	CreateFingerprints(data.data(), sizes.data(), parts.size(), fingerprints.data());
+	for(size_t i = 0; i < parts.size(); i++)
+		parts[i].fingerprint = fingerprints[i];
+}
+
+/**
+ * Feed - Takes the next size bytes of the stream
+ * Returns the parts they completed, the bytes after the last boundary are
+ * held until more data or Finish comes along
+ */
+std::vector<CloudApi::PartInfo> FastCdc::Feed(const void *data, size_t size)
+{
+	std::vector<CloudApi::PartInfo> parts;
+	auto bytes = static_cast<const uint8_t *>(data);
+
+	while(size)
+	{
+		bool boundary;
+		auto taken = Scan(bytes, size, boundary);
+		m_pending.Append(taken, bytes);
+
+		bytes += taken;
+		size -= taken;
+
+		if(boundary)
+			Emit(parts);
+	}
+
+	FingerprintParts(parts);
+	return parts;
+}
+
+/**
+ * Feed - Takes the next piece of the stream, parts that start in data are
+ * slices of it rather than copies
+ * Returns the parts it completed
+ */
+std::vector<CloudApi::PartInfo> FastCdc::Feed(const Data &data)
+{
+	std::vector<CloudApi::PartInfo> parts;
+	auto bytes = data.Cast<uint8_t>();
+	size_t offset = 0;
+
+	while(offset < data.Size())
+	{
+		bool boundary;
+		auto taken = Scan(bytes + offset, data.Size() - offset, boundary);
+
+		// A part carried over from earlier data is joined up in a copy, unless
+		// both are neighbouring views of the same memory
+		if(m_pending.IsEmpty())
+			m_pending = data.Slice(offset, taken);
+		else if(!m_pending.Extend(data.Slice(offset, taken)))
+			m_pending.Append(taken, bytes + offset);
+
+		offset += taken;
+
+		if(boundary)
+			Emit(parts);
+	}
+
+	FingerprintParts(parts);
+	return parts;
+}
+
+/**
+ * Finish - Ends the stream
+ * Returns the last part if there are bytes left over, the chunker is then
+ * ready for a new stream
+ */
+std::vector<CloudApi::PartInfo> FastCdc::Finish()
+{
+	std::vector<CloudApi::PartInfo> parts;
+	if(m_length)
+		Emit(parts);
+
+	FingerprintParts(parts);
+	Reset();
+	return parts;
+}
+
+void FastCdc::Feed(const void *data, size_t size, const CloudApi::PartCallback &callback)
+{
+	for(auto &part : Feed(data, size))
+		callback(part);
+}
+
+void FastCdc::Feed(const Data &data, const CloudApi::PartCallback &callback)
+{
+	for(auto &part : Feed(data))
+		callback(part);
+}
+
+void FastCdc::Finish(const CloudApi::PartCallback &callback)
+{
+	for(auto &part : Finish())
+		callback(part);
+}
+
+/**
+ * Reset - Drops any partial part and starts over at offset 0
+ */
+void FastCdc::Reset()
+{
+	m_pending = Data();
+	m_hash = 0;
+	m_length = 0;
+	m_offset = 0;
+}
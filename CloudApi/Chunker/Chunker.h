@@ -0,0 +1,72 @@
+#pragma once
+
+namespace Copy {
+	namespace Chunker {
+
+// Part size limits, boundaries come from the content so sizes fall between
+// minSize and maxSize and bunch up around avgSize
+struct Config
+{
+	uint32_t minSize = 256 * 1024;
+	uint32_t avgSize = 1024 * 1024;		// Rounded down to a power of two
+	uint32_t maxSize = 4 * 1024 * 1024;
+	bool fingerprint = true;			// Fingerprint parts before handing them out
+};
+
+/**
+ * FastCdc - Splits a stream into parts at content defined boundaries using a
+ * gear rolling hash (FastCDC with normalized chunking). An edit only moves the
+ * boundaries next to it, so every other part keeps its fingerprint and doesn't
+ * have to be sent again. Bytes can be fed in pieces of any size, parts come out
+ * through the callback with their data, size and offset in the stream filled in.
+ * A part that lies within one Data fed in is a slice of it, so parts of a view
+ * (a mapped file, say) are views too and nothing is copied
+ */
+class FastCdc
+{
+public:
+	FastCdc(const Config &config = Config());
+
+	void Feed(const void *data, size_t size, const CloudApi::PartCallback &callback);
+	void Feed(const Data &data, const CloudApi::PartCallback &callback);
+	void Finish(const CloudApi::PartCallback &callback);
+	void Reset();
+
+	std::vector<CloudApi::PartInfo> Feed(const void *data, size_t size);
+	std::vector<CloudApi::PartInfo> Feed(const Data &data);
+	std::vector<CloudApi::PartInfo> Finish();
+
+	uint64_t GetOffset() const { return m_offset + m_length; }
+	const Config &GetConfig() const { return m_config; }
+
+protected:
+	static const uint64_t *GetGearTable();
+
+	size_t Scan(const uint8_t *data, size_t size, bool &boundary);
+	void Emit(std::vector<CloudApi::PartInfo> &parts);
+	void FingerprintParts(std::vector<CloudApi::PartInfo> &parts);
+
+	Config m_config;
+	uint64_t m_smallMask;		// Harder to hit, used below the average size
+	uint64_t m_largeMask;		// Easier to hit, used above it
+
+	uint64_t m_hash = 0;
+	uint64_t m_length = 0;		// Bytes in the part being built
+	uint64_t m_offset = 0;		// Where it starts in the stream
+	Data m_pending;
+};
+
+/**
+ * Split - Splits a whole buffer into parts
+ */
+inline std::vector<CloudApi::PartInfo> Split(const Data &data, const Config &config = Config())
+{
+	FastCdc chunker(config);
+	auto parts = chunker.Feed(data);
+	auto last = chunker.Finish();
+	std::move(last.begin(), last.end(), std::back_inserter(parts));
+	return parts;
+}
+
+	}
+}
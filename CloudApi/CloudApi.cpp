@@ -2,33 +2,128 @@
 
 using namespace Copy;
 
-std::once_flag CloudApi::s_hasInitializedCurl;
+namespace {
+
+template<typename T>
+void FulfillPromise(std::promise<T> &promise, const std::function<T (Http::Request &)> &complete, Http::Request &request)
+{
+	promise.set_value(complete(request));
+}
+
+void FulfillPromise(std::promise<void> &promise, const std::function<void (Http::Request &)> &complete, Http::Request &request)
+{
+	complete(request);
+	promise.set_value();
+}
+
+/**
+ * TakePartData - Moves a single part's data out of a streamed reply
+ */
+void TakePartData(CloudApi::PartInfo &part, CloudApi::PartInfo &received)
+{
+	if(received.errorCode)
+	{
+		throw CloudApi::CloudException(CloudApi::PART_NOT_FOUND, std::string("Unable to locate ") +
+			part.fingerprint.ToHex() + " " + received.errorDesc);
+	}
+
+	part.data = std::move(received.data);
+	part.errorCode = 0;
+}
+
+/**
+ * ReadFingerprint - Decodes a part's hex fingerprint from where it sits in the
+ * reply, only an escaped string is copied out first
+ */
+void ReadFingerprint(const JSON::Node &node, Fingerprint &fingerprint)
+{
+	if(node.IsEscaped())
+	{
+		auto hex = node.AsString();
+		if(!Fingerprint::FromHex(hex.data(), hex.size(), fingerprint))
+			throw CloudApi::CloudException(CloudApi::CLOUD_RESPONSE_FAILURE, std::string("Invalid part fingerprint ") + hex);
+	}
+	else if(!Fingerprint::FromHex(node.GetStringData(), node.GetStringSize(), fingerprint))
+	{
+		throw CloudApi::CloudException(CloudApi::CLOUD_RESPONSE_FAILURE, std::string("Invalid part fingerprint ") +
+			std::string(node.GetStringData(), node.GetStringSize()));
+	}
+}
+
+// The update_objects item CreateFile sends, it points at the caller's parts
+struct CreateFileItem
+{
+	std::string action;
+	std::string objectType;
+	const std::vector<CloudApi::PartInfo> &parts;
+	const std::string &path;
+	uint64_t size;
+};
+
+struct CreateFileParams
+{
+	std::vector<CreateFileItem> meta;
+};
+
+}
+
+namespace Copy {
+	namespace JSON {
+
+// Members are bound in name order, the order an Object would write them in
+template<>
+struct Binding<CloudApi::PartInfo>
+{
+	template<class Visitor, class Bound>
+	static void Fields(Visitor &visitor, Bound &part)
+	{
+		visitor(Key("fingerprint"), part.fingerprint);
+		visitor(Key("offset"), part.offset, FIELD_NUMBER_STRING);
+		visitor(Key("size"), part.size, FIELD_NUMBER_STRING);
+	}
+};
+
+template<>
+struct Binding<CreateFileItem>
+{
+	template<class Visitor, class Bound>
+	static void Fields(Visitor &visitor, Bound &item)
+	{
+		visitor(Key("action"), item.action);
+		visitor(Key("object_type"), item.objectType);
+		visitor(Key("parts"), item.parts);
+		visitor(Key("path"), item.path);
+		visitor(Key("size"), item.size, FIELD_NUMBER_STRING);
+	}
+};
+
+template<>
+struct Binding<CreateFileParams>
+{
+	template<class Visitor, class Bound>
+	static void Fields(Visitor &visitor, Bound &params)
+	{
+		visitor(Key("meta"), params.meta);
+	}
+};
+
+	}
+}
 
 /**
  * CloudApi - Constructs the cloud api instance, the Config structure
  * contains all the required configuration options
  */
 CloudApi::CloudApi(Config param) :
-	m_config(param), m_oauthConsumer(param.consumerKey, param.consumerSecret),
+	m_config(param), m_handles(param.maxIdleHandles), m_oauthConsumer(param.consumerKey, param.consumerSecret),
 	m_oauthToken(param.accessToken, param.accessTokenSecret)
 {
-	std::call_once(s_hasInitializedCurl, []() { curl_global_init(CURL_GLOBAL_ALL); });
-
-	m_curl = curl_easy_init();
-
-	// Don't let signals mess us up! This prevents SIGALARM signal handlers to crash
-	// on longjumps in the dns timeout code in hostip.c
-	curl_easy_setopt(m_curl, CURLOPT_NOSIGNAL, 1);
-
-	// Some SSL handshakes (e.g. w/ antivirus scanning) bomb out if we don't explicitly set this.
-	// openSSL 1.0.1c bug? https://code.google.com/p/plowshare/issues/detail?id=731
-	curl_easy_setopt(m_curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1);
-	curl_easy_setopt(m_curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
 }
 
 CloudApi::~CloudApi()
 {
-	curl_easy_cleanup(m_curl);
+	// Stop the async engine first, its callbacks refer back to us
+	m_engine.reset();
 }
 
 /**
@@ -36,66 +131,242 @@ CloudApi::~CloudApi()
  */
 void CloudApi::GetPart(PartInfo &part, uint64_t shareId)
 {
-	std::vector<PartInfo> parts;
-	parts.push_back(part);
+	GetParts(std::vector<PartInfo>(1, part), [&part](PartInfo &received) { TakePartData(part, received); }, shareId);
+}
+
+/**
+ * GetParts - Fetches the data of any number of parts, they are split into requests of
+ * at most maxPartsRequestSize bytes with up to maxPartsRequestsInFlight running at once
+ */
+void CloudApi::GetParts(std::vector<PartInfo> &parts, uint64_t shareId)
+{
+	std::list<std::future<void>> requests;
+	std::exception_ptr error;
+
+	auto wait = [&requests, &error]()
+		{
+			try
+			{
+				requests.front().get();
+			}
+			catch(...)
+			{
+				if(!error)
+					error = std::current_exception();
+			}
+			requests.pop_front();
+		};
+
+	size_t begin = 0;
+	while(begin < parts.size() && !error)
+	{
+		// Every request carries at least one part, however large
+		std::vector<PartInfo> batch;
+		uint64_t batchSize = 0;
+		do
+		{
+			PartInfo request;
+			request.fingerprint = parts[begin + batch.size()].fingerprint;
+			request.size = parts[begin + batch.size()].size;
+			request.offset = parts[begin + batch.size()].offset;
+			batchSize += request.size;
+			batch.push_back(std::move(request));
+		}
+		while(begin + batch.size() < parts.size() &&
+			batchSize + parts[begin + batch.size()].size <= m_config.maxPartsRequestSize);
+
+		// Replies come back in request order, the callback runs on the event thread
+		auto next = begin;
+		requests.push_back(GetPartsAsync(batch,
+			[&parts, next](PartInfo &received) mutable { TakePartData(parts[next++], received); }, shareId));
+
+		begin += batch.size();
+
+		if(requests.size() >= std::max<uint32_t>(m_config.maxPartsRequestsInFlight, 1))
+			wait();
+	}
 
-	auto data = ProcessBinaryPartsRequest("get_object_parts", parts, shareId, false);
+	// The callbacks write into parts, so let every request finish before returning
+	while(!requests.empty())
+		wait();
 
-	if(!BinaryParsePartsReply(data, &parts))
-		throw CloudException(PART_NOT_FOUND, std::string("Unable to locate ") + part.fingerprint);
-	
-	part = parts.front();
+	if(error)
+		std::rethrow_exception(error);
 }
 
 /**
- * HasParts - This function will ask the cloud if it has the requested parts, and return
- * a vector of parts that the cloud does not have
+ * GetParts - Fetches a group of parts in one request, callback is handed
+ * each part as soon as its data has arrived and been verified
  */
-std::vector<CloudApi::PartInfo> CloudApi::HasParts(std::vector<PartInfo> parts, uint64_t shareId)
+void CloudApi::GetParts(const std::vector<PartInfo> &parts, const PartCallback &callback, uint64_t shareId)
 {
-    std::vector<PartInfo> neededParts;
+	if(parts.empty())
+		return;
+
+	auto parser = std::make_shared<PartsReplyParser>(parts, callback);
+	auto request = CreateGetPartsRequest(parts, shareId, parser);
+
+	Perform(*request);
+	parser->Finish();
+}
 
+/**
+ * GetPartAsync - Fetches a part from the cloud without blocking, the future
+ * yields the part with its data filled in
+ */
+std::future<CloudApi::PartInfo> CloudApi::GetPartAsync(const PartInfo &part, uint64_t shareId)
+{
+	std::vector<PartInfo> parts(1, part);
+
+	auto result = std::make_shared<PartInfo>(part);
+	auto parser = std::make_shared<PartsReplyParser>(parts,
+		[result](PartInfo &received) { TakePartData(*result, received); });
+
+	return PostAsync<PartInfo>(CreateGetPartsRequest(parts, shareId, parser),
+		[parser, result](Http::Request &)
+		{
+			parser->Finish();
+			return std::move(*result);
+		});
+}
+
+/**
+ * GetPartsAsync - Fetches a group of parts without blocking, callback is invoked
+ * from the event thread for each part as it arrives
+ */
+std::future<void> CloudApi::GetPartsAsync(const std::vector<PartInfo> &parts, PartCallback callback, uint64_t shareId)
+{
 	if(parts.empty())
-		return neededParts;
+	{
+		std::promise<void> promise;
+		promise.set_value();
+		return promise.get_future();
+	}
+
+	auto parser = std::make_shared<PartsReplyParser>(parts, std::move(callback));
+
+	return PostAsync<void>(CreateGetPartsRequest(parts, shareId, parser),
+		[parser](Http::Request &) { parser->Finish(); });
+}
+
+/**
+ * CreateGetPartsRequest - Builds a get_object_parts request whose reply is streamed into parser
+ */
+Http::RequestPtr CloudApi::CreateGetPartsRequest(const std::vector<PartInfo> &parts, uint64_t shareId,
+	const std::shared_ptr<PartsReplyParser> &parser)
+{
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields, "get_object_parts");
+
+	auto request = CreateRequest(headerFields, BinaryPackPartsRequest(parts, shareId, false), "get_object_parts");
+	request->dataCallback = [parser](const uint8_t *data, size_t size) { parser->Feed(data, size); };
+	return request;
+}
+
+/**
+ * HasParts - This function will ask the cloud if it has the requested parts, the result
+ * has the status of each part and the indexes of the parts the cloud does not have
+ */
+CloudApi::HasPartsResult CloudApi::HasParts(const std::vector<PartInfo> &parts, uint64_t shareId)
+{
+	if(parts.empty())
+		return HasPartsResult();
 
 	auto data = ProcessBinaryPartsRequest("has_object_parts", parts, shareId, false);
 
-    std::vector<PART_ITEM *> partItems;
+	return ParseHasPartsReply(data, GetFingerprints(parts));
+}
+
+/**
+ * HasPartsAsync - Asks the cloud which parts it is missing without blocking
+ */
+std::future<CloudApi::HasPartsResult> CloudApi::HasPartsAsync(const std::vector<PartInfo> &parts, uint64_t shareId)
+{
+	if(parts.empty())
+	{
+		std::promise<HasPartsResult> promise;
+		promise.set_value(HasPartsResult());
+		return promise.get_future();
+	}
+
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields, "has_object_parts");
+
+	auto fingerprints = std::make_shared<std::vector<Fingerprint>>(GetFingerprints(parts));
+	return PostAsync<HasPartsResult>(headerFields, BinaryPackPartsRequest(parts, shareId, false), "has_object_parts",
+		[this, fingerprints](Http::Request &request) { return ParseHasPartsReply(request.response, *fingerprints); });
+}
+
+/**
+ * GetFingerprints - Returns the fingerprints of parts, in order
+ */
+std::vector<Fingerprint> CloudApi::GetFingerprints(const std::vector<PartInfo> &parts)
+{
+	std::vector<Fingerprint> fingerprints;
+	fingerprints.reserve(parts.size());
 
-	BinaryParsePartsReply(data, nullptr, &partItems);
+	for(auto &part : parts)
+		fingerprints.push_back(part.fingerprint);
+
+	return fingerprints;
+}
 
-	if(!partItems.empty())
+/**
+ * ParseHasPartsReply - Matches a has_object_parts reply up with the parts asked about,
+ * fingerprints are theirs in request order
+ */
+CloudApi::HasPartsResult CloudApi::ParseHasPartsReply(Data &data, const std::vector<Fingerprint> &fingerprints)
+{
+	HasPartsResult result;
+	result.status.resize(fingerprints.size());
+
+	std::vector<PART_ITEM *> partItems;
+	BinaryParsePartsReply(data, &partItems);
+
+	if(partItems.empty())
+		return result;
+
+	// Index the reply by fingerprint, the first item for a fingerprint wins
+	std::unordered_map<Fingerprint, PART_ITEM *> cloudParts;
+	cloudParts.reserve(partItems.size());
+
+	for(auto &cloudPart : partItems)
+	{
+		Fingerprint fingerprint;
+		if(!Fingerprint::FromHex(cloudPart->fingerprint, strnlen(cloudPart->fingerprint, sizeof(cloudPart->fingerprint)), fingerprint))
+			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "ParseHasPartsReply: invalid part fingerprint");
+
+		cloudParts.emplace(fingerprint, cloudPart);
+	}
+
+	for(size_t index = 0; index < fingerprints.size(); index++)
 	{
-		for(auto iter = parts.begin(); iter != parts.end(); iter++) 
+		auto found = cloudParts.find(fingerprints[index]);
+		if(found == cloudParts.end())
+			continue;
+
+		auto cloudPart = found->second;
+		if(cloudPart->partSize && !cloudPart->errorCode)
+			continue;
+
+		auto &status = result.status[index];
+		status.needed = true;
+
+		if(cloudPart->errorCode)
 		{
-			bool bFound = false;
-			for(auto &cloudPart : partItems)
-			{
-				if(iter->fingerprint == cloudPart->fingerprint)
-				{
-					if(!cloudPart->partSize || cloudPart->errorCode)
-					{
-						if(cloudPart->errorCode)
-						{
-							// Save the part error in the PartInfo if we want to use this at some point
-							iter->errorCode = cloudPart->errorCode;
-							auto errMsgOffset = data.PtrToOffset(cloudPart) + sizeof(PART_ITEM);
-
-							// Get the error message out of the reply data
-							if(errMsgOffset + cloudPart->payloadSize < data.Size())
-								iter->errorDesc = std::string(data.Cast<char>() + data.PtrToOffset(cloudPart) +
-                                            sizeof(PART_ITEM), cloudPart->payloadSize);
-						}
-
- 						neededParts.push_back(*iter);
-					}
-					 break;
-				}
-			}
+			// Save the part error in the status if we want to use this at some point
+			status.errorCode = cloudPart->errorCode;
+			auto errMsgOffset = data.PtrToOffset(cloudPart) + sizeof(PART_ITEM);
+
+			// Get the error message out of the reply data
+			if(errMsgOffset + cloudPart->payloadSize <= data.Size())
+				status.errorDesc = std::string(data.Cast<char>(errMsgOffset), cloudPart->payloadSize);
 		}
+
+		result.needed.push_back(index);
 	}
-				
-	return neededParts;
+
+	return result;
 }
 
 /**
@@ -103,7 +374,13 @@ std::vector<CloudApi::PartInfo> CloudApi::HasParts(std::vector<PartInfo> parts,
  */
 void CloudApi::SendNeededParts(const std::vector<PartInfo> &parts, uint64_t shareId)
 {
-	SendParts(HasParts(parts));
+	auto result = HasParts(parts, shareId);
+	if(result.needed.empty())
+		return;
+
+	auto data = ProcessBinaryPartsRequest("send_object_parts", parts, shareId, true, &result.needed);
+
+	ParseSendPartsReply(data, result.needed.size());
 }
 
 /**
@@ -116,7 +393,41 @@ void CloudApi::SendParts(const std::vector<PartInfo> &parts, uint64_t shareId)
 
 	auto data = ProcessBinaryPartsRequest("send_object_parts", parts, shareId, true);
 
-	if(BinaryParsePartsReply(data, nullptr, nullptr) != parts.size())
+	ParseSendPartsReply(data, parts.size());
+}
+
+/**
+ * SendPartsAsync - Sends a group of parts to the cloud without blocking, the request
+ * reads the part data in place so the parts are held until it completes
+ */
+std::future<void> CloudApi::SendPartsAsync(std::vector<PartInfo> parts, uint64_t shareId)
+{
+	if(parts.empty())
+	{
+		std::promise<void> promise;
+		promise.set_value();
+		return promise.get_future();
+	}
+
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields, "send_object_parts");
+
+	auto partCount = parts.size();
+	auto sendParts = std::make_shared<const std::vector<PartInfo>>(std::move(parts));
+
+	auto body = BinaryPackPartsRequest(*sendParts, shareId, true);
+	body.KeepAlive(sendParts);
+
+	return PostAsync<void>(headerFields, std::move(body), "send_object_parts",
+		[this, partCount](Http::Request &request) { ParseSendPartsReply(request.response, partCount); });
+}
+
+/**
+ * ParseSendPartsReply - Verifies the cloud accepted every part we sent
+ */
+void CloudApi::ParseSendPartsReply(Data &replyData, size_t partCount)
+{
+	if(BinaryParsePartsReply(replyData) != partCount)
 		throw CloudException(CLOUD_RESPONSE_FAILURE, "Not all parts were excepted by the cloud");
 }
 
@@ -128,267 +439,314 @@ void CloudApi::CreateFile(const std::string &cloudPath, const std::vector<PartIn
 	std::map<std::string, std::string> headerFields;
 	SetCommonHeaderFields(headerFields);
 
-	JSON::Array items;
-	JSON::Object item, main_request;
-	item.Set<std::string>("action", "create");
-	item.Set<std::string>("object_type", "file");
-	item.Set<std::string>("path", cloudPath);
+	SendJsonRequest(headerFields, CreateFileRequest(cloudPath, parts));
+}
+
+/**
+ * CreateFileAsync - Creates or updates a file without blocking
+ */
+std::future<void> CloudApi::CreateFileAsync(const std::string &cloudPath, const std::vector<PartInfo> &parts)
+{
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields);
+
+	return SendJsonRequestAsync<void>(headerFields, CreateFileRequest(cloudPath, parts),
+		[](const JSON::ValuePtr &) {});
+}
 
+/**
+ * CreateFileRequest - Encodes the update_objects request for CreateFile
+ */
+std::string CloudApi::CreateFileRequest(const std::string &cloudPath, const std::vector<PartInfo> &parts)
+{
 	// Sum up the size of the parts
 	uint64_t size = 0;
 	for(auto &part : parts)
 		size += part.size;
 
-	item.Set<std::string>("size", std::to_string(size));
+	CreateFileItem item = { "create", "file", parts, cloudPath, size };
+	CreateFileParams params;
+	params.meta.push_back(item);
 
-	JSON::Array part_items;
-	for(auto &part : parts)
-	{
-		JSON::Object partObj;
-		partObj.Set<std::string>("fingerprint", part.fingerprint);
-		partObj.Set<std::string>("offset", std::to_string(part.offset));
-		partObj.Set<std::string>("size", std::to_string(part.size));
-		part_items.push_back(JSON::Value::Create(partObj));
-	}
-	item.Set<JSON::Array>("parts", part_items);
-
-	items.push_back(JSON::Value::Create(item));
+	return EncodeJsonRequest("update_objects", params);
+}
 
-	main_request.Set<JSON::Array>("meta", items);
-	
-	ProcessRequest("update_objects", headerFields, main_request);
+/**
+ * CreateRequest - Prepares an http request for one of the cloud api methods
+ */
+Http::RequestPtr CloudApi::CreateRequest(std::map<std::string, std::string> &headerFields, Http::Body body, const std::string &method)
+{
+	auto request = std::make_shared<Http::Request>();
+	request->url = m_config.address + "/" + method;
+	request->headerFields = headerFields;
+	request->body = std::move(body);
+	request->debugCallback = m_config.debugCallback;
+	return request;
 }
 
-Data CloudApi::Post(std::map<std::string, std::string> &headerFields, const Data &data, const std::string &method)
+/**
+ * Post - Performs a request on the calling thread, headerFields are replaced with the
+ * response header fields
+ */
+Data CloudApi::Post(std::map<std::string, std::string> &headerFields, Http::Body body, const std::string &method)
 {
-	Data response;
+	auto request = CreateRequest(headerFields, std::move(body), method);
+	Perform(*request);
 
-	auto completeUrl = m_config.address + "/" + method;
+	headerFields = std::move(request->responseHeaderFields);
+	return std::move(request->response);
+}
 
-	struct curl_slist *curlList = nullptr;
-	for(auto iter = headerFields.begin(); iter != headerFields.end(); iter++)
-		curlList = curl_slist_append(curlList, (iter->first + std::string(": ") + iter->second).c_str());
+/**
+ * Perform - Runs a request on the calling thread with a handle from the pool
+ */
+void CloudApi::Perform(Http::Request &request)
+{
+	auto handle = m_handles.Checkout();
+	request.Perform(handle.Get());
+}
 
-	auto callbackData = std::make_pair(this, &response);
-	curl_easy_setopt(m_curl, CURLOPT_URL, completeUrl.c_str());
-	curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, curlList);
-	curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &callbackData);
-	curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, CurlWriteDataCallback);
-	curl_easy_setopt(m_curl, CURLOPT_POST, 1);
-	curl_easy_setopt(m_curl, CURLOPT_HEADER, 0);
-	curl_easy_setopt(m_curl, CURLOPT_POSTFIELDSIZE, data.Size()); 
-	curl_easy_setopt(m_curl, CURLOPT_POSTFIELDS, data.Cast<uint8_t>());
+/**
+ * PostAsync - Queues a request on the async engine, complete is invoked from the
+ * event thread to turn the reply into the value the future yields
+ */
+template<typename T>
+std::future<T> CloudApi::PostAsync(std::map<std::string, std::string> &headerFields, Http::Body body, const std::string &method,
+	std::function<T (Http::Request &request)> complete)
+{
+	return PostAsync<T>(CreateRequest(headerFields, std::move(body), method), std::move(complete));
+}
 
-	headerFields.clear();
-	auto callbackInfo = std::make_pair(this, &headerFields);
-	curl_easy_setopt(m_curl, CURLOPT_WRITEHEADER, &callbackInfo);
-	curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, CurlWriteHeaderCallback);
+template<typename T>
+std::future<T> CloudApi::PostAsync(const Http::RequestPtr &request, std::function<T (Http::Request &request)> complete)
+{
+	auto promise = std::make_shared<std::promise<T>>();
 
-	try
-	{
-		Perform();
-	}
-	catch(const std::exception &)
-	{
-		curl_slist_free_all(curlList);
-		throw;
-	}
+	request->callback = [promise, complete](Http::Request &request, std::exception_ptr error)
+		{
+			if(error)
+			{
+				promise->set_exception(error);
+				return;
+			}
 
-	curl_slist_free_all(curlList);
+			try
+			{
+				FulfillPromise(*promise, complete, request);
+			}
+			catch(...)
+			{
+				promise->set_exception(std::current_exception());
+			}
+		};
 
-	return response;
+	auto future = promise->get_future();
+	GetEngine().Submit(request);
+	return future;
 }
 
-size_t CloudApi::CurlWriteDataCallback(char *ptr, size_t size, size_t nmemb, std::pair<CloudApi *, Data *> *info)
+/**
+ * GetEngine - Returns the async engine, starting it on first use
+ */
+Http::Engine &CloudApi::GetEngine()
 {
-	info->second->Append(size * nmemb, ptr);
-	return size * nmemb;
+	std::call_once(m_engineCreated, [this]() { m_engine.reset(new Http::Engine(m_handles, m_config.maxAsyncRequests)); });
+	return *m_engine;
 }
 
-size_t CloudApi::CurlWriteHeaderCallback(void *ptr, size_t size, size_t nmemb, std::pair<CloudApi *, std::map<std::string, std::string> *> *info)
+/**
+ * ListPath - List cloudObj at a specific path
+ */
+CloudApi::ListResult CloudApi::ListPath(ListConfig &config)
 {
-	auto headerLine = reinterpret_cast<char *>(ptr);
-	auto keys = SplitString(headerLine, ":");
-	keys.first.erase(std::remove_if(keys.first.begin(), keys.first.end(), ::isspace), keys.first.end());
-	keys.second.erase(std::remove_if(keys.second.begin(), keys.second.end(), ::isspace), keys.second.end());
-	info->second->operator[](keys.first) = keys.second;
-	return size * nmemb;
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields);
+
+	auto listReply = ProcessDocumentRequest("list_objects", headerFields, CreateListRequest(config));
+
+	return ParseListReply(config, listReply->GetRoot().At("result"));
 }
 
-int CloudApi::CurlDebugCallback(CURL *curl, curl_infotype infoType, char *data, size_t size, CloudApi *thisClass)
+/**
+ * ListPathAsync - Lists a path without blocking, pass the result's index back in
+ * as ListConfig::index to fetch the next page
+ */
+std::future<CloudApi::ListResult> CloudApi::ListPathAsync(const ListConfig &config)
 {
-	if(!size)
-		return 0;
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields);
 
-	std::ostringstream ss;
+	return ProcessDocumentRequestAsync<ListResult>("list_objects", headerFields, CreateListRequest(config),
+		[this, config](const JSON::Node &listReply)
+		{
+			auto replyConfig = config;
+			return ParseListReply(replyConfig, listReply);
+		});
+}
 
-	switch(infoType)
-	{
-		case CURLINFO_HEADER_IN:
-			ss << "HEADER <- " << std::string(data, size);
-			break;
+/**
+ * ListPath - Lists a path with its reply streamed, callback is handed each child
+ * as soon as it has been parsed so the listing is never held in memory whole.
+ * The result has no children, only the root on the first page and the index
+ */
+CloudApi::ListResult CloudApi::ListPath(ListConfig &config, const CloudObjCallback &callback)
+{
+	std::shared_ptr<ListReplyParser> parser;
+	auto request = CreateStreamedListRequest(config, callback, parser);
 
-		case CURLINFO_HEADER_OUT:
-			ss << "HEADER -> " << std::string(data, size);
-			break;
+	Perform(*request);
 
-		case CURLINFO_TEXT:
-			ss << std::string(data, size);
-			break;
-	}
+	auto result = parser->Finish();
+	config.index = result.index;
+	return result;
+}
 
-	thisClass->m_config.debugCallback(ss.str());
+/**
+ * ListPathAsync - ListPath with a streamed reply that doesn't block, callback is
+ * invoked from the event thread for each child as it arrives
+ */
+std::future<CloudApi::ListResult> CloudApi::ListPathAsync(const ListConfig &config, CloudObjCallback callback)
+{
+	std::shared_ptr<ListReplyParser> parser;
+	auto request = CreateStreamedListRequest(config, std::move(callback), parser);
 
-	return 0;
+	return PostAsync<ListResult>(request, [parser](Http::Request &) { return parser->Finish(); });
 }
 
-void CloudApi::Perform()
+/**
+ * CreateStreamedListRequest - Builds a list_objects request whose reply is streamed into parser
+ */
+Http::RequestPtr CloudApi::CreateStreamedListRequest(const ListConfig &config, CloudObjCallback callback,
+	std::shared_ptr<ListReplyParser> &parser)
 {
+	std::map<std::string, std::string> headerFields;
+	SetCommonHeaderFields(headerFields);
+
+	auto data = EncodeJsonRequest("list_objects", headerFields, CreateListRequest(config));
+
 	if(m_config.debugCallback)
-	{
-		curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1);
-		curl_easy_setopt(m_curl, CURLOPT_DEBUGDATA, this);
-		curl_easy_setopt(m_curl, CURLOPT_DEBUGFUNCTION, CurlDebugCallback);
-	}
+		m_config.debugCallback(std::string("Processing request ") + data);
 
-	curl_easy_setopt(m_curl, CURLOPT_ENCODING, "gzip,deflate");
-	uint32_t httpStatus;
-	auto result = curl_easy_perform(m_curl);
-	curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &httpStatus);
+	auto request = CreateRequest(headerFields, Data(data), "jsonrpc");
+	parser = std::make_shared<ListReplyParser>(request->responseHeaderFields, !config.index, std::move(callback));
 
-	if(result != CURLE_OK)
-		throw std::logic_error(curl_easy_strerror(result));
-	// Allow 302 - Found (redirect) 200 - OK http status codes
-	else if(httpStatus && httpStatus != 200 && httpStatus != 302)
-		throw std::logic_error("Unexpected http status");
+	auto target = parser;
+	request->dataCallback = [target](const uint8_t *data, size_t size) { target->Feed(data, size); };
+	return request;
 }
 
 /**
- * ListPath - List cloudObj at a specific path
+ * CreateListRequest - Builds the list_objects request for a ListConfig
  */
-CloudApi::ListResult CloudApi::ListPath(ListConfig &config)
+JSON::Object CloudApi::CreateListRequest(const ListConfig &config)
 {
-	std::map<std::string, std::string> headerFields;
-	SetCommonHeaderFields(headerFields);
-	ListResult result;
-	bool firstTime = !config.index;
-
-	JSON::Object main_request;
-	main_request.Set<std::string>("path", config.path);
+	auto main_request = JSON::Builder::MakeObject();
+	main_request.Set("path", config.path);
 
 	if(config.maxCount)
-		main_request.Set<std::string>("max_items", std::to_string(config.maxCount));
+		main_request.Set("max_items", std::to_string(config.maxCount));
 
-	main_request.Set<std::string>("list_watermark", std::to_string(config.index));
-	main_request.Set<std::string>("include_total_items", std::to_string(0));
-	main_request.Set<std::string>("recurse", std::to_string(config.recurse));
-	main_request.Set<std::string>("include_parts", std::to_string(config.includeParts));
-	main_request.Set<std::string>("include_child_counts", std::to_string(config.includeChildCounts));
-	main_request.Set<std::string>("include_attributes", std::to_string(1));
-	main_request.Set<std::string>("include_sync_filters", std::to_string(0));
+	main_request.Set("list_watermark", std::to_string(config.index));
+	main_request.Set("include_total_items", std::to_string(0));
+	main_request.Set("recurse", std::to_string(config.recurse));
+	main_request.Set("include_parts", std::to_string(config.includeParts));
+	main_request.Set("include_child_counts", std::to_string(config.includeChildCounts));
+	main_request.Set("include_attributes", std::to_string(1));
+	main_request.Set("include_sync_filters", std::to_string(0));
 
 	if(!config.filter.empty())
-		main_request.Set<std::string>("filter_name", config.filter);
+		main_request.Set("filter_name", config.filter);
 
 	if(!config.groupByDir)
-		main_request.Set<std::string>("group_by_dir", std::to_string(config.groupByDir));
+		main_request.Set("group_by_dir", std::to_string(config.groupByDir));
 
 	if(!config.sortField.empty())
-		main_request.Set<std::string>("sort_field", config.sortField);
+		main_request.Set("sort_field", config.sortField);
 
 	if(!config.sortDirection.empty())
-		main_request.Set<std::string>("sort_direction", config.sortDirection);
+		main_request.Set("sort_direction", config.sortDirection);
+
+	return main_request.BuildObject();
+}
 
-	auto list_result = ProcessRequest("list_objects", headerFields, main_request)->AsObject();
+/**
+ * ParseListReply - Parses a list_objects reply, and advances the config's index
+ */
+CloudApi::ListResult CloudApi::ParseListReply(ListConfig &config, const JSON::Node &listReply)
+{
+	ListResult result;
+	bool firstTime = !config.index;
 
-	config.index = list_result.Get<uint64_t>("list_watermark");
-	result.more = list_result.Get<uint32_t>("more_items") > 0;
+	config.index = listReply.Get<uint64_t>("list_watermark");
+	result.more = listReply.Get<uint32_t>("more_items") > 0;
 
 	// Force sync index to increment so we don't loop forever
 	if(!config.index)
 		config.index = config.index + 1;
 
-	if(list_result.GetType("children") == JSON::Type_Null)
+	result.index = config.index;
+
+	if(listReply.GetType("children") == JSON::Type_Null)
 		return result;
-	auto cloudObjArray = list_result.Get<JSON::Array>("children");
+	auto &cloudObjArray = listReply.At("children");
 
 	// First pass include root at start
 	if(firstTime)
-	{
-		auto parentInfo = list_result.Get<JSON::ValuePtr>("object");
-		result.root = ParseCloudObj(parentInfo);
-	}
+		result.root = ParseCloudObj(listReply.At("object"));
 
+	result.children.reserve(cloudObjArray.Size());
 	for(auto &cloudObjInfo : cloudObjArray)
 	{
 		auto cloudObj = ParseCloudObj(cloudObjInfo);
 		if(cloudObj)
-			result.children.push_back(cloudObj);
+			result.children.push_back(std::move(cloudObj));
 	}
 
 	return result;
 }
 
-CloudApi::CloudObj CloudApi::ParseCloudObj(const JSON::ValuePtr &cloudObjInfo)
+CloudApi::CloudObj CloudApi::ParseCloudObj(const JSON::Node &cloudObjInfo)
 {
-	auto cloudObjInfoObj = cloudObjInfo->AsObject();
-
 	CloudObj obj;
 
-	if(!cloudObjInfoObj.Has("path"))
+	if(!cloudObjInfo.Has("path"))
 		return CloudObj();
 
-	auto type = cloudObjInfoObj.GetOpt<std::string>("type", cloudObjInfoObj.GetOpt<std::string>("object_type", ""));
-	auto path = cloudObjInfoObj.Get<std::string>("path");
-
-	obj.id = cloudObjInfoObj.GetOpt<uint64_t>("object_id", 0);
-	obj.removedTime = cloudObjInfoObj.GetOpt<uint64_t>("removed_time", 0);
-	obj.createdTime = cloudObjInfoObj.GetOpt<uint64_t>("created_time", 0);
-	obj.modifiedTime = cloudObjInfoObj.GetOpt<uint64_t>("modified_time", 0);
-	obj.childCount = cloudObjInfoObj.GetOpt<uint32_t>("children_count", 0);
-
-	// File attributes (optional)
-	if(cloudObjInfoObj.GetType("attributes") == JSON::Type_Object)
-		obj.attributes = cloudObjInfoObj.Get<JSON::ValuePtr>("attributes");
-
-	obj.path = path;
-
-	auto action = cloudObjInfoObj.GetOpt<std::string>("action", "create");
-
+	auto type = cloudObjInfo.GetOpt<std::string>("type", cloudObjInfo.GetOpt<std::string>("object_type", ""));
+	obj.path = cloudObjInfo.Get<std::string>("path");
 	if(!(type == "file" || type == "dir" || type == "share" || type == "company"))
 		return CloudObj();
-	obj.type = type;
 
-	if(type == "file")
+	obj.type = std::move(type);
+	obj.id = cloudObjInfo.GetOpt<uint64_t>("object_id", 0);
+	obj.removedTime = cloudObjInfo.GetOpt<uint64_t>("removed_time", 0);
+	obj.createdTime = cloudObjInfo.GetOpt<uint64_t>("created_time", 0);
+	obj.modifiedTime = cloudObjInfo.GetOpt<uint64_t>("modified_time", 0);
+	obj.childCount = cloudObjInfo.GetOpt<uint32_t>("children_count", 0);
+
+	// File attributes (optional), copied out as they outlive the reply
+	if(cloudObjInfo.GetType("attributes") == JSON::Type_Object)
+		obj.attributes = cloudObjInfo.At("attributes").ToValue();
+
+	if(obj.type == "file")
 	{
-		obj.size = cloudObjInfoObj.GetOpt<uint64_t>("size", 0);
+		obj.size = cloudObjInfo.GetOpt<uint64_t>("size", 0);
 
-		if(cloudObjInfoObj.Has("revisions"))
+		// Only the first revision's parts are read
+		auto revisions = cloudObjInfo.Find("revisions");
+		if(revisions && !revisions->GetElements().IsEmpty() && revisions->begin()->Has("parts"))
 		{
-			auto revisionsArray = cloudObjInfoObj.Get<JSON::Array>("revisions");
-
-			for(auto &revision : revisionsArray)
+			auto partsArray = revisions->begin()->GetArrayView("parts");
+			obj.parts.reserve(partsArray.Size());
+			for(auto &partInfo : partsArray)
 			{
-				auto revisionObj = revision->AsObject();
-
-				if(revisionObj.Has("parts"))
-				{
-					auto partsArray = revisionObj.Get<JSON::Array>("parts");
-					for(auto &partInfo : partsArray)
-					{
-						PartInfo part;
+				PartInfo part;
 
-						auto partInfoObj = partInfo->AsObject();
+				part.offset = partInfo.Get<uint64_t>("offset");
+				part.size = partInfo.Get<uint32_t>("size");
+				ReadFingerprint(partInfo.At("fingerprint"), part.fingerprint);
 
-						part.offset = partInfoObj.Get<uint64_t>("offset");
-						part.size = partInfoObj.Get<uint32_t>("size");
-						part.fingerprint = partInfoObj.Get<std::string>("fingerprint");
-
-						obj.parts.push_back(part);
-					}
-				}
-
-				break;
+				obj.parts.push_back(part);
 			}
 		}
 	}
@@ -396,27 +754,133 @@ CloudApi::CloudObj CloudApi::ParseCloudObj(const JSON::ValuePtr &cloudObjInfo)
 	return obj;
 }
 
+/**
+ * StartJsonRequest - Writes a json rpc request up to its params, in the order
+ * JSONRPC::ToJSON's object would have them
+ */
+void CloudApi::StartJsonRequest(JSON::Writer &writer, const std::string &method)
+{
+	writer.StartObject();
+	writer.Key("id");
+	writer.String("0");
+	writer.Key("jsonrpc");
+	writer.String("2.0");
+	writer.Key("method");
+	writer.String(method);
+	writer.Key("params");
+}
+
 std::string CloudApi::EncodeJsonRequest(const std::string &method, std::map<std::string, std::string> &headerFields, JSON::Object _request)
 {
-	JSON::JSONRPC requestRpc;
-	requestRpc.id = JSON::Value::Create("0");
-	requestRpc.method = JSON::Value::Create(method);
+	JSON::Writer writer;
+	StartJsonRequest(writer, method);
+	writer.Write(_request);
+	writer.EndObject();
 
-	requestRpc.params  = JSON::Value::Create(_request);
-	auto requestJSON = requestRpc.ToJSON();
-	return JSON::Value::Create(requestJSON)->Stringify();
+	return writer.Take();
+}
+
+/**
+ * EncodeJsonRequest - Encodes a request whose params are a bound struct, written
+ * straight from its members with no Object built in between
+ */
+template<typename T>
+std::string CloudApi::EncodeJsonRequest(const std::string &method, const T &params)
+{
+	JSON::Writer writer;
+	StartJsonRequest(writer, method);
+	JSON::Write(writer, params);
+	writer.EndObject();
+
+	return writer.Take();
 }
 
 JSON::ValuePtr CloudApi::ProcessRequest(const std::string &method, std::map<std::string, std::string> &headerFields, JSON::Object _request)
 {
-	auto data = EncodeJsonRequest(method, headerFields, _request);
+	return SendJsonRequest(headerFields, EncodeJsonRequest(method, headerFields, std::move(_request)));
+}
 
+/**
+ * SendJsonRequest - Posts an encoded json rpc request and decodes the reply
+ */
+JSON::ValuePtr CloudApi::SendJsonRequest(std::map<std::string, std::string> &headerFields, const std::string &data)
+{
+	if(m_config.debugCallback)
+		m_config.debugCallback(std::string("Processing request ") + data);
+
+	auto response = Post(headerFields, Data(data));
+
+	return ParseJsonReply(response, headerFields);
+}
+
+/**
+ * ProcessRequestAsync - Queues a json rpc request on the async engine, complete is invoked
+ * from the event thread with the rpc result
+ */
+template<typename T>
+std::future<T> CloudApi::ProcessRequestAsync(const std::string &method, std::map<std::string, std::string> &headerFields,
+	JSON::Object _request, std::function<T (const JSON::ValuePtr &result)> complete)
+{
+	return SendJsonRequestAsync<T>(headerFields, EncodeJsonRequest(method, headerFields, std::move(_request)), std::move(complete));
+}
+
+/**
+ * SendJsonRequestAsync - Queues an encoded json rpc request on the async engine
+ */
+template<typename T>
+std::future<T> CloudApi::SendJsonRequestAsync(std::map<std::string, std::string> &headerFields, const std::string &data,
+	std::function<T (const JSON::ValuePtr &result)> complete)
+{
 	if(m_config.debugCallback)
 		m_config.debugCallback(std::string("Processing request ") + data);
 
-	auto response = Post(headerFields, data).ToString();
+	return PostAsync<T>(headerFields, Data(data), "jsonrpc",
+		[this, complete](Http::Request &request) { return complete(ParseJsonReply(request.response, request.responseHeaderFields)); });
+}
+
+/**
+ * ProcessDocumentRequest - Sends a json rpc request and parses the reply into a
+ * document, for replies big enough that a Value tree would be costly
+ */
+JSON::DocumentPtr CloudApi::ProcessDocumentRequest(const std::string &method, std::map<std::string, std::string> &headerFields, JSON::Object _request)
+{
+	auto data = EncodeJsonRequest(method, headerFields, std::move(_request));
 
-	auto value = JSON::Parse(response.c_str());
+	if(m_config.debugCallback)
+		m_config.debugCallback(std::string("Processing request ") + data);
+
+	auto response = Post(headerFields, Data(data));
+
+	return ParseJsonDocument(std::move(response), headerFields);
+}
+
+/**
+ * ProcessDocumentRequestAsync - ProcessRequestAsync for replies parsed into a document,
+ * complete is passed the rpc result while the document is still around
+ */
+template<typename T>
+std::future<T> CloudApi::ProcessDocumentRequestAsync(const std::string &method, std::map<std::string, std::string> &headerFields,
+	JSON::Object _request, std::function<T (const JSON::Node &result)> complete)
+{
+	auto data = EncodeJsonRequest(method, headerFields, std::move(_request));
+
+	if(m_config.debugCallback)
+		m_config.debugCallback(std::string("Processing request ") + data);
+
+	return PostAsync<T>(headerFields, Data(data), "jsonrpc",
+		[this, complete](Http::Request &request)
+		{
+			auto document = ParseJsonDocument(std::move(request.response), request.responseHeaderFields);
+			return complete(document->GetRoot().At("result"));
+		});
+}
+
+/**
+ * ParseJsonReply - Decodes a json rpc reply, throws if the cloud returned an error
+ */
+JSON::ValuePtr CloudApi::ParseJsonReply(Data &responseData, std::map<std::string, std::string> &headerFields)
+{
+	auto value = JSON::Parse(responseData.Cast<char>(), responseData.Size());
 
 	JSON::JSONRPC responseRpc(value->AsObject());
 	if(!responseRpc.IsValidResponse())
@@ -426,12 +890,36 @@ JSON::ValuePtr CloudApi::ProcessRequest(const std::string &method, std::map<std:
 	return responseRpc.result;
 }
 
+/**
+ * ParseJsonDocument - Decodes a json rpc reply into a document that takes over
+ * the reply's buffer, throws if the cloud returned an error
+ */
+JSON::DocumentPtr CloudApi::ParseJsonDocument(Data responseData, std::map<std::string, std::string> &headerFields)
+{
+	auto document = std::make_shared<JSON::Document>(std::move(responseData));
+	auto &root = document->GetRoot();
+
+	// The same checks JSONRPC makes of a response
+	auto id = root.Find("id");
+	if(root.GetOpt<std::string>("jsonrpc", "") != "2.0" || root.Has("method") || root.Has("params") ||
+		!id || !(id->IsString() || id->IsNumber() || id->IsNull()))
+		throw CloudException(CLOUD_RESPONSE_FAILURE, "JSON response not valid JSONRPC");
+
+	if(auto error = root.Find("error"))
+		ParseCloudError(*error, headerFields);
+
+	return document;
+}
+
 void CloudApi::SetCommonHeaderFields(std::map<std::string, std::string> &headerFields, const std::string &method)
 {
 	// Do oauth
-	OAuth::Client oauth(&m_oauthConsumer, &m_oauthToken);
-	headerFields["Authorization"] = SplitString(oauth.getFormattedHttpHeader(OAuth::Http::Post,
-		 m_config.address + "/" + method), ": ").second;
+	{
+		std::lock_guard<std::mutex> lock(m_oauthLock);
+		OAuth::Client oauth(&m_oauthConsumer, &m_oauthToken);
+		headerFields["Authorization"] = SplitString(oauth.getFormattedHttpHeader(OAuth::Http::Post,
+			 m_config.address + "/" + method), ": ").second;
+	}
 
 	// Required to bypass oath binary payloads
 	if(method == "has_object_parts" || method == "send_object_parts" || method == "get_object_parts")
@@ -493,7 +981,21 @@ void CloudApi::ParseCloudError(JSON::JSONRPC &responseRpc, std::map<std::string,
 	if(!responseRpc.error || responseRpc.error->IsNull())
 		return;
 
-	auto error = responseRpc.error->AsObject();
+	auto &error = responseRpc.error->AsObject();
+	auto errorCode = error.Get<uint32_t>("code");
+	auto errorString = error.Get<std::string>("message");
+
+	throw CloudException(MapCloudError(errorCode), errorString);
+}
+
+void CloudApi::ParseCloudError(const JSON::Node &error, std::map<std::string, std::string> &headerFields)
+{
+	if(headerFields["X-Request-Result"] == "success")
+		return;
+
+	if(error.IsNull())
+		return;
+
 	auto errorCode = error.Get<uint32_t>("code");
 	auto errorString = error.Get<std::string>("message");
 
@@ -501,17 +1003,19 @@ void CloudApi::ParseCloudError(JSON::JSONRPC &responseRpc, std::map<std::string,
 }
 
 /**
- * BinaryPackPart - Packs a part into a request structure
+ * BinaryPackPart - Packs a part into a request body, the part data is
+ * referenced rather than copied so it must outlive the request
  * Returns if it was successful
  */
-bool CloudApi::BinaryPackPart(PartInfo part, Data &data, bool addPartData, uint64_t shareId)
+bool CloudApi::BinaryPackPart(const PartInfo &part, Http::Body &body, bool addPartData, uint64_t shareId)
 {
-	if(data.Size() < sizeof(PARTS_HEADER))
-		data.Grow(sizeof(PARTS_HEADER));
+	if(addPartData && part.data.Size() < part.size)
+		throw CloudException(INVALID_PART_SIZE, std::string("Missing data for part ") + part.fingerprint.ToHex());
 
+	auto &storage = body.GetStorage();
 	auto totalDataSize = sizeof(PART_ITEM) + (addPartData ? part.size : 0);
 
-	auto partItem = data.CastAllocAtEnd<PART_ITEM>(totalDataSize);
+	auto partItem = storage.CastAllocAtEnd<PART_ITEM>(sizeof(PART_ITEM));
 
 	partItem->signature = CPU32_NET(0xCAB005E5);
 	partItem->version = CPU32_NET(BINARY_PART_ITEM_VERSION);
@@ -519,45 +1023,45 @@ bool CloudApi::BinaryPackPart(PartInfo part, Data &data, bool addPartData, uint6
 
 	partItem->shareId = CPU32_NET(static_cast<uint32_t>(shareId));
 
-	strcpy(partItem->fingerprint, part.fingerprint.c_str());
+	part.fingerprint.ToHex(partItem->fingerprint);
+	partItem->fingerprint[Fingerprint::HEX_SIZE] = '\0';
 	partItem->partSize = CPU32_NET(part.size);
 	partItem->payloadSize = (addPartData ? CPU32_NET(part.size) : CPU32_NET(0));
 	partItem->errorCode = CPU32_NET(0);
+	partItem->reserved = 0;
+
+	body.AddStorage(storage.PtrToOffset(partItem), sizeof(PART_ITEM));
+
+	if(addPartData && part.size)
+		body.AddReference(part.data.Cast<uint8_t>(0, part.size), part.size);
 
-	if(addPartData)
-		data.Copy(data.PtrToOffset(partItem) + sizeof(PART_ITEM), part.data.Size(), part.data);
-    
 	return true;
 }
 
 /**
- * BinaryPackPartsHeader - Packs a header into a request structure
+ * BinaryPackPartsHeader - Fills in the header reserved at the start of the body's storage
  */
-void CloudApi::BinaryPackPartsHeader(Data &data, uint32_t partCount)
+void CloudApi::BinaryPackPartsHeader(Http::Body &body, uint32_t partCount)
 {
-	if(data.Size() < sizeof(PARTS_HEADER))
-		data.Grow(sizeof(PARTS_HEADER));
-
-	auto header = data.Cast<PARTS_HEADER>();
+	auto header = body.GetStorage().Cast<PARTS_HEADER>();
 
 	header->signature = CPU32_NET(0xBA5EBA11);
 	header->headerSize = CPU32_NET(sizeof(PARTS_HEADER));
 	header->version = CPU32_NET(BINARY_PARTS_HEADER_VERSION);
-	header->bodySize = CPU32_NET(data.Size() - sizeof(PARTS_HEADER));
+	header->bodySize = CPU32_NET(body.Size() - sizeof(PARTS_HEADER));
 	header->partCount = CPU32_NET(partCount);
 	header->errorCode = CPU32_NET(0);
 }
 
 /**
- * BinaryParsePartsReply - Parses a cloud response from the binary parts api
- * Returns count of parts with valid part data
- * Include "parts" if expecting data
+ * BinaryParsePartsReply - Parses a cloud response from the binary parts api that
+ * carries no part data (has and send replies), get replies go through PartsReplyParser
+ * Returns count of parts in the reply
  * Include "partInfos" if wanting what parts the cloud returned
  */
-uint32_t CloudApi::BinaryParsePartsReply(Data &replyData,
-	 std::vector<PartInfo> *parts, std::vector<PART_ITEM*> *partInfos)
+uint32_t CloudApi::BinaryParsePartsReply(Data &replyData, std::vector<PART_ITEM*> *partInfos)
 {
-	auto *header = replyData.Cast<PARTS_HEADER>();
+	auto *header = replyData.Cast<PARTS_HEADER>(0, sizeof(PARTS_HEADER));
 
 	header->signature = NET32_CPU(header->signature);
 	header->headerSize = NET32_CPU(header->headerSize);
@@ -572,15 +1076,10 @@ uint32_t CloudApi::BinaryParsePartsReply(Data &replyData,
 		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, std::string("BinaryParsePartsReply: Error code ") + std::to_string(header->errorCode));
 	else if(header->headerSize != sizeof(PARTS_HEADER))
 		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: Invalid header size");
-	else if(parts && parts->size() != header->partCount)
-		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: didn't get expected part count from cloud");
-	
+
 	StructParser parser(offsetof(PART_ITEM, dataSize),
 		 replyData.Cast<uint8_t>() + sizeof(PARTS_HEADER), header->bodySize, false, true);
 
-	std::vector<PartInfo>::iterator partInfoIter;
-	if(parts)
-		partInfoIter = parts->begin();
 	PART_ITEM *partItem;
 	uint32_t  partCount = 0;
 	while((partItem = parser.GetNextEntry<PART_ITEM>()))
@@ -598,53 +1097,9 @@ uint32_t CloudApi::BinaryParsePartsReply(Data &replyData,
 
 		if(partItem->signature != BINARY_PARTS_ITEM_SIG)
 			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: invalid part signature");
-		else if(parts && partItem->errorCode)
-		{
-			partInfoIter->data.Release();
-			std::cerr << "Part error " << replyData.Cast<char>(replyData.PtrToOffset(partItem) + 
-				sizeof(PART_ITEM), partItem->payloadSize);
-			continue;
-		}
-		else if(parts && std::string(partItem->fingerprint) != (*partInfoIter).fingerprint)
-			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: invalid part fingerprint");
-		else if(parts && partItem->partSize != (*partInfoIter).size)
-			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: invalid part size");
-		else if(parts && partItem->payloadSize != partItem->partSize)
-			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: invalid part payload size");
-		else if(parts && partItem->dataSize != partItem->partSize + sizeof(PART_ITEM))
-			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: invalid part data size");
 		else if(partItem->version != BINARY_PART_ITEM_VERSION)
 			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: invalid part structure version");
 
-		if(!parts)
-		{
-			partCount++;
-			continue;
-		}
-
-		// Make sure we dont read past the buffer
-		auto currentOffset = replyData.PtrToOffset(partItem);
-		if(currentOffset + sizeof(PART_ITEM) + partInfoIter->size > replyData.Size())
-			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "BinaryParsePartsReply: not enough data from cloud");
-
-		partInfoIter->data.Resize(partInfoIter->size);
-		partInfoIter->data.Copy(partInfoIter->size,
-			replyData.Cast<char>(currentOffset + sizeof(PART_ITEM), partInfoIter->size));
-		
-		auto actualHash = CreateFingerprint(partInfoIter->data);
-		if(partInfoIter->size != partItem->partSize)
-		{
-			throw CloudException(INVALID_PART_SIZE, std::string("Failed to validate part fingerprint ") +
-				std::to_string(partItem->partSize) + " " + std::to_string(partInfoIter->size));
-		}
-
-		if(actualHash != partItem->fingerprint)
-		{
-			throw CloudException(INVALID_PART_FINGERPRINT, std::string("Failed to validate part fingerprint ") +
-				actualHash + " " + partInfoIter->fingerprint);
-		}
-
-		partInfoIter++;
 		partCount++;
 	}
 
@@ -652,34 +1107,46 @@ uint32_t CloudApi::BinaryParsePartsReply(Data &replyData,
 }
 
 Data CloudApi::ProcessBinaryPartsRequest(const std::string &method,
-	 const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode)
+	 const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode, const std::vector<size_t> *indexes)
 {
 	std::map<std::string, std::string> headerFields;
 	SetCommonHeaderFields(headerFields, method);
 
-	return ProcessBinaryPartsRequest(method, headerFields, parts, shareId, sendMode);
+	return ProcessBinaryPartsRequest(method, headerFields, parts, shareId, sendMode, indexes);
 }
 
 Data CloudApi::ProcessBinaryPartsRequest(const std::string &method, std::map<std::string, std::string> &headerFields,
-	const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode)
+	const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode, const std::vector<size_t> *indexes)
 {
-	Data requestData;
+	return Post(headerFields, BinaryPackPartsRequest(parts, shareId, sendMode, indexes), method);
+}
+
+/**
+ * BinaryPackPartsRequest - Packs the header and every part into a binary parts request,
+ * or only the parts at indexes when given
+ */
+Http::Body CloudApi::BinaryPackPartsRequest(const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode,
+	const std::vector<size_t> *indexes)
+{
+	Http::Body body;
 	uint32_t partCount = 0;
-	uint64_t totalPartSize = 0;
+	auto packCount = indexes ? indexes->size() : parts.size();
 
-	for(auto &part : parts)
+	// Item headers all live in the body's storage, size it and the segment list
+	// (the header, then an item header and its data per part) once up front
+	auto &storage = body.GetStorage();
+	storage.Grow(sizeof(PARTS_HEADER));
+	storage.Reserve(sizeof(PARTS_HEADER) + packCount * sizeof(PART_ITEM));
+	body.Reserve(1 + packCount * 2);
+	body.AddStorage(0, sizeof(PARTS_HEADER));
+
+	for(size_t i = 0; i < packCount; i++)
 	{
-		if(BinaryPackPart(part, requestData, sendMode, shareId))
-		{
+		if(BinaryPackPart(parts.at(indexes ? (*indexes)[i] : i), body, sendMode, shareId))
 			partCount++;
-			totalPartSize += part.size;
-		}
 	}
 
-	auto contentLength = requestData.Size();
+	BinaryPackPartsHeader(body, partCount);
 
-	BinaryPackPartsHeader(requestData, partCount);
-
-	return Post(headerFields, requestData.ToString(), method);
+	return body;
 }
-
@@ -5,7 +5,8 @@
 namespace Copy {
 
 /**
- * CloudApi - The example class for copy api
+ * CloudApi - The example class for copy api, an instance can be shared by
+ * any number of threads
  */
 class CloudApi
 {
@@ -18,19 +19,42 @@ public:
 		std::string accessToken, accessTokenSecret;
 		std::string address = "http://api.qa.copy.com";
 		std::function<void(const std::string &)> debugCallback;
+		uint32_t maxAsyncRequests = 16;
+		uint32_t maxIdleHandles = 16;
+		uint32_t maxPartsRequestSize = 8 * 1024 * 1024;	// Part bytes GetParts asks for per request
+		uint32_t maxPartsRequestsInFlight = 4;			// Requests GetParts keeps running at once
 	};
 
 	// This structure decribes a chunk of data
 	struct PartInfo
 	{
- 		std::string fingerprint;
+ 		Fingerprint fingerprint;
 		Data data;
 		uint64_t size = 0;
 		uint64_t offset = 0;
-        uint32_t errorCode;
+        uint32_t errorCode = 0;
         std::string errorDesc;
 	};
 
+	// Receives each part of a streamed reply as soon as it has been verified, parts
+	// the cloud could not return have errorCode and errorDesc set instead of data
+	typedef std::function<void (PartInfo &part)> PartCallback;
+
+	// What the cloud said about one of the parts passed to HasParts
+	struct PartStatus
+	{
+		bool needed = false;			// The cloud doesn't have it
+		uint32_t errorCode = 0;
+		std::string errorDesc;
+	};
+
+	// Returned by HasParts, status lines up with the parts asked about
+	struct HasPartsResult
+	{
+		std::vector<PartStatus> status;
+		std::vector<size_t> needed;		// Indexes of the parts the cloud doesn't have
+	};
+
 	// Populated from a call to Login, returns all the information about the
 	// logged in user
 	struct UserInfo
@@ -84,10 +108,19 @@ public:
 
 	void SendNeededParts(const std::vector<PartInfo> &parts, uint64_t shareId = 0);
 	void SendParts(const std::vector<PartInfo> &parts, uint64_t shareId = 0);
-	std::vector<PartInfo> HasParts(std::vector<PartInfo> parts, uint64_t shareId = 0);
+	HasPartsResult HasParts(const std::vector<PartInfo> &parts, uint64_t shareId = 0);
 	void GetPart(PartInfo &part, uint64_t shareId = 0);
+	void GetParts(std::vector<PartInfo> &parts, uint64_t shareId = 0);
+	void GetParts(const std::vector<PartInfo> &parts, const PartCallback &callback, uint64_t shareId = 0);
 	void CreateFile(const std::string &path, const std::vector<PartInfo> &parts);
 
+	// Non-blocking variants of the above, these run on the async engine
+	std::future<void> SendPartsAsync(std::vector<PartInfo> parts, uint64_t shareId = 0);
+	std::future<HasPartsResult> HasPartsAsync(const std::vector<PartInfo> &parts, uint64_t shareId = 0);
+	std::future<PartInfo> GetPartAsync(const PartInfo &part, uint64_t shareId = 0);
+	std::future<void> GetPartsAsync(const std::vector<PartInfo> &parts, PartCallback callback, uint64_t shareId = 0);
+	std::future<void> CreateFileAsync(const std::string &path, const std::vector<PartInfo> &parts);
+
 	struct CloudObj
 	{
 		std::string path;
@@ -107,8 +140,12 @@ public:
 		CloudObj root;
 		std::vector<CloudObj> children;
 		bool more = false;
+		uint64_t index = 0;			// Watermark to continue the listing from (ListConfig::index)
 	};
 
+	// Receives each child of a streamed listing as soon as it has been parsed
+	typedef std::function<void (CloudObj &obj)> CloudObjCallback;
+
 	struct ListConfig 
 	{
 		std::string path;
@@ -124,28 +161,58 @@ public:
 	};
 
 	ListResult ListPath(ListConfig &config);
+	std::future<ListResult> ListPathAsync(const ListConfig &config);
+
+	// Streamed variants, children go to callback as they arrive instead of into the result
+	ListResult ListPath(ListConfig &config, const CloudObjCallback &callback);
+	std::future<ListResult> ListPathAsync(const ListConfig &config, CloudObjCallback callback);
 
 protected:
-	void Perform();
-	Data Post(std::map<std::string, std::string> &headerFields, const Data &data, const std::string &method = "jsonrpc");
+	Data Post(std::map<std::string, std::string> &headerFields, Http::Body body, const std::string &method = "jsonrpc");
+	Http::RequestPtr CreateRequest(std::map<std::string, std::string> &headerFields, Http::Body body, const std::string &method);
+	void Perform(Http::Request &request);
+	Http::Engine &GetEngine();
+
+	template<typename T>
+	std::future<T> PostAsync(std::map<std::string, std::string> &headerFields, Http::Body body, const std::string &method,
+		std::function<T (Http::Request &request)> complete);
+	template<typename T>
+	std::future<T> PostAsync(const Http::RequestPtr &request, std::function<T (Http::Request &request)> complete);
+	template<typename T>
+	std::future<T> ProcessRequestAsync(const std::string &command, std::map<std::string, std::string> &headerFields,
+		JSON::Object _request, std::function<T (const JSON::ValuePtr &result)> complete);
+	template<typename T>
+	std::future<T> SendJsonRequestAsync(std::map<std::string, std::string> &headerFields, const std::string &data,
+		std::function<T (const JSON::ValuePtr &result)> complete);
+	template<typename T>
+	std::future<T> ProcessDocumentRequestAsync(const std::string &command, std::map<std::string, std::string> &headerFields,
+		JSON::Object _request, std::function<T (const JSON::Node &result)> complete);
 
 	void SetCommonHeaderFields(std::map<std::string, std::string> &headerFields, const std::string &method = "jsonrpc");
 	std::string EncodeJsonRequest(const std::string &command, std::map<std::string, std::string> &headerFields, JSON::Object _request);
+	template<typename T>
+	std::string EncodeJsonRequest(const std::string &command, const T &params);
+	static void StartJsonRequest(JSON::Writer &writer, const std::string &command);
+	JSON::ValuePtr SendJsonRequest(std::map<std::string, std::string> &headerFields, const std::string &data);
 	JSON::ValuePtr ProcessRequest(const std::string &command, std::map<std::string, std::string> &headerFields, JSON::Object _request = JSON::Object());
+	JSON::ValuePtr ParseJsonReply(Data &response, std::map<std::string, std::string> &headerFields);
+	JSON::DocumentPtr ProcessDocumentRequest(const std::string &command, std::map<std::string, std::string> &headerFields, JSON::Object _request);
+	JSON::DocumentPtr ParseJsonDocument(Data response, std::map<std::string, std::string> &headerFields);
 	void ParseCloudError(JSON::JSONRPC &responseRpc, std::map<std::string, std::string> &headerFields);
-	CloudError MapCloudError(uint32_t errorCode);
-	CloudObj ParseCloudObj(const JSON::ValuePtr &cloudObjInfo);
+	void ParseCloudError(const JSON::Node &error, std::map<std::string, std::string> &headerFields);
+	static CloudError MapCloudError(uint32_t errorCode);
+	CloudObj ParseCloudObj(const JSON::Node &cloudObjInfo);
 
-	static int CurlDebugCallback(CURL *curl, curl_infotype infoType, char *data, size_t size, CloudApi *extra);
-	static size_t CurlWriteHeaderCallback(void *ptr, size_t size, size_t nmemb, std::pair<CloudApi *, std::map<std::string, std::string> *> *info);
-	static size_t CurlWriteDataCallback(char *ptr, size_t size, size_t nmemb, std::pair<CloudApi *, Data *> *info);
+	JSON::Object CreateListRequest(const ListConfig &config);
+	ListResult ParseListReply(ListConfig &config, const JSON::Node &listReply);
+	std::string CreateFileRequest(const std::string &cloudPath, const std::vector<PartInfo> &parts);
 
 	// Define binary cloud api types
-	const uint32_t BINARY_PARTS_HEADER_VERSION = 1;
-	const uint32_t BINARY_PART_ITEM_VERSION = 1;
+	static const uint32_t BINARY_PARTS_HEADER_VERSION = 1;
+	static const uint32_t BINARY_PART_ITEM_VERSION = 1;
 
-	const uint32_t BINARY_PARTS_HEADER_SIG = 0xBA5EBA11;
-	const uint32_t BINARY_PARTS_ITEM_SIG = 0xCAB005E5;
+	static const uint32_t BINARY_PARTS_HEADER_SIG = 0xBA5EBA11;
+	static const uint32_t BINARY_PARTS_ITEM_SIG = 0xCAB005E5;
 
 	#pragma pack(push, 1)
 		struct PARTS_HEADER
@@ -164,7 +231,7 @@ protected:
 			uint32_t dataSize;			// Size of this struct plus payload size
 			uint32_t version;			// Struct version
 			uint32_t shareId;			// Share id for part (for verification)
-			char fingerprint[73];		// Part fingerprint
+			char fingerprint[73];		// Part fingerprint (hex)
 			uint32_t partSize;			// Size of the part
 			uint32_t payloadSize;		// Size of our payload (partSize or 0, error msg size on error)
 			uint32_t errorCode;			// Error code for individual parts
@@ -172,20 +239,216 @@ protected:
 		};
 	#pragma pack(pop)
 
-	bool BinaryPackPart(PartInfo part, Data &data, bool addPartData, uint64_t shareId);
-	void BinaryPackPartsHeader(Data &data, uint32_t partCount);
-	uint32_t BinaryParsePartsReply(Data &replyData,
-		 std::vector<PartInfo> *parts, std::vector<PART_ITEM*> *partInfos = nullptr);
-	Data ProcessBinaryPartsRequest(const std::string &command, const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode);
+	/**
+	 * PartsReplyParser - Parses a get_object_parts reply as it arrives, bytes can be
+	 * fed in pieces of any size. Each payload is fingerprinted as it is copied into
+	 * its part, so only the part being received is held in memory
+	 */
+	class PartsReplyParser
+	{
+	public:
+		PartsReplyParser(std::vector<PartInfo> parts, PartCallback callback);
+
+		void Feed(const uint8_t *data, size_t size);
+		uint32_t Finish();
+
+	protected:
+		enum State
+		{
+			STATE_HEADER,
+			STATE_ITEM,
+			STATE_PAYLOAD,
+			STATE_DONE,
+		};
+
+		size_t Take(size_t wanted, const uint8_t *&data, size_t &size);
+		bool Gather(void *target, size_t targetSize, const uint8_t *&data, size_t &size);
+		void ParseHeader();
+		void ParseItem();
+		void ConsumePayload(const uint8_t *data, size_t size);
+		void FinishItem();
+
+		std::vector<PartInfo> m_parts;
+		PartCallback m_callback;
+
+		State m_state = STATE_HEADER;
+		PARTS_HEADER m_header;
+		PART_ITEM m_item;
+		size_t m_gathered = 0;			// Bytes of the header/item collected so far
+		uint64_t m_bodyLeft = 0;		// Bytes left in the reply after the header
+		uint32_t m_itemCount = 0;
+		uint32_t m_partCount = 0;		// Parts delivered with data
+
+		// Part being received
+		PartInfo m_part;
+		uint32_t m_payloadRead = 0;
+		uint32_t m_payloadLeft = 0;
+		uint32_t m_paddingLeft = 0;
+		FingerprintContext m_fingerprint;
+	};
+
+	// A part of a file as list_objects returns it, members may be missing
+	struct CloudPartReply
+	{
+		JSON::Optional<uint64_t> offset;
+		JSON::Optional<uint64_t> size;
+		JSON::Optional<std::string> fingerprint;
+	};
+
+	struct CloudRevisionReply
+	{
+		std::vector<CloudPartReply> parts;
+	};
+
+	// An object as list_objects returns it, read by ListReplyParser through its binding
+	struct CloudObjReply
+	{
+		JSON::Optional<std::string> path;
+		JSON::Optional<std::string> type;
+		JSON::Optional<std::string> objectType;
+		uint64_t id = 0;
+		uint64_t removedTime = 0;
+		uint64_t createdTime = 0;
+		uint64_t modifiedTime = 0;
+		uint64_t childCount = 0;
+		uint64_t size = 0;
+		JSON::ValuePtr attributes;
+		std::vector<CloudRevisionReply> revisions;
+	};
+
+	// Bindings name the reply structs
+	template<class T>
+	friend struct JSON::Binding;
+
+	/**
+	 * ListReplyParser - Parses a list_objects reply as it arrives, bytes can be fed
+	 * in pieces of any size. Each object is bound straight from the reader's
+	 * events and children go to the callback as soon as their closing brace is
+	 * seen, so only the child being parsed is held in memory. Children may have
+	 * been delivered by the time Finish finds the reply wasn't valid json rpc
+	 */
+	class ListReplyParser : public JSON::Handler
+	{
+	public:
+		ListReplyParser(const Http::HeaderFields &headerFields, bool includeRoot, CloudObjCallback callback);
+
+		void Feed(const uint8_t *data, size_t size);
+		ListResult Finish();
+
+		void StartObject();
+		void Key(const char *data, size_t size);
+		void EndObject();
+		void StartArray();
+		void EndArray();
+		void String(const char *data, size_t size);
+		void Number(uint64_t value);
+		void Null();
+
+	protected:
+		// Where in the reply the parser is, one for each open container
+		enum Context
+		{
+			CONTEXT_ROOT,
+			CONTEXT_RESULT,
+			CONTEXT_ERROR,
+			CONTEXT_CHILDREN,
+			CONTEXT_OBJECT,				// Everything under it goes to m_binder
+			CONTEXT_SKIP,
+		};
+
+		// The members that are read, each is kept until the object holding it closes
+		enum FieldId
+		{
+			FIELD_JSONRPC,
+			FIELD_ID,
+			FIELD_METHOD,
+			FIELD_PARAMS,
+			FIELD_RESULT,
+			FIELD_ERROR,
+			FIELD_WATERMARK,
+			FIELD_MORE,
+			FIELD_CHILDREN,
+			FIELD_CODE,
+			FIELD_MESSAGE,
+			FIELD_COUNT,
+		};
+
+		// A member's value, read the way JSON::Node's Get reads them
+		struct Field
+		{
+			bool present = false;
+			JSON::Type type = JSON::Type_Null;
+			std::string string;
+			uint64_t number = 0;
+
+			std::string GetString() const { return type == JSON::Type_String ? string : std::string(); }
+			uint64_t GetNumber(FieldId id) const;
+		};
+
+		static FieldId FindField(Context context, const std::string &key);
+		static const char *GetFieldName(FieldId id);
+
+		bool IsBinding() const { return !m_contexts.empty() && m_contexts.back() == CONTEXT_OBJECT; }
+		void Open(JSON::Type type);
+		void Close();
+		void Scalar(JSON::Type type, const char *data, size_t size, uint64_t number);
+		void ResetFields(FieldId first, FieldId last);
+		void CheckError();
+		void FinishObject();
+
+		const Http::HeaderFields &m_headerFields;
+		bool m_includeRoot;
+		CloudObjCallback m_callback;
+
+		JSON::Reader m_reader;
+		std::vector<Context> m_contexts;
+		Field m_fields[FIELD_COUNT];
+		Field *m_target = nullptr;			// Where the value after the last key goes
+		std::string m_key;
+
+		// Object being parsed
+		bool m_isRoot = false;
+		JSON::BindReader m_binder;
+		CloudObjReply m_object;
+
+		CloudObj m_root;
+	};
+
+	bool BinaryPackPart(const PartInfo &part, Http::Body &body, bool addPartData, uint64_t shareId);
+	void BinaryPackPartsHeader(Http::Body &body, uint32_t partCount);
+	uint32_t BinaryParsePartsReply(Data &replyData, std::vector<PART_ITEM*> *partInfos = nullptr);
+	Data ProcessBinaryPartsRequest(const std::string &command, const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode,
+		const std::vector<size_t> *indexes = nullptr);
 	Data ProcessBinaryPartsRequest(const std::string &command, std::map<std::string, std::string> &headerFields,
-		const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode);
+		const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode, const std::vector<size_t> *indexes = nullptr);
+	Http::Body BinaryPackPartsRequest(const std::vector<PartInfo> &parts, uint64_t shareId, bool sendMode,
+		const std::vector<size_t> *indexes = nullptr);
+
+	Http::RequestPtr CreateStreamedListRequest(const ListConfig &config, CloudObjCallback callback,
+		std::shared_ptr<ListReplyParser> &parser);
+	Http::RequestPtr CreateGetPartsRequest(const std::vector<PartInfo> &parts, uint64_t shareId,
+		const std::shared_ptr<PartsReplyParser> &parser);
+	std::vector<Fingerprint> GetFingerprints(const std::vector<PartInfo> &parts);
+	HasPartsResult ParseHasPartsReply(Data &replyData, const std::vector<Fingerprint> &fingerprints);
+	void ParseSendPartsReply(Data &replyData, size_t partCount);
 
 	Config m_config;
-	static std::once_flag s_hasInitializedCurl;
-	void *m_curl = nullptr;
+	Http::HandlePool m_handles;
+
+	// Created on first use of an async call
+	std::once_flag m_engineCreated;
+	std::unique_ptr<Http::Engine> m_engine;
 
+	// liboauthcpp generates its nonces with rand(), so signing is serialized
+	std::mutex m_oauthLock;
 	OAuth::Consumer m_oauthConsumer;
 	OAuth::Token m_oauthToken;
 };
 
 }
+
+// Subsystems built on top of the api types
+#include "Chunker/Chunker.h"
+#include "Transfer/BoundedQueue.h"
+#include "Transfer/UploadPipeline.h"
+#include "Transfer/DownloadEngine.h"
@@ -20,6 +20,15 @@
 #include <assert.h>
 #include <fstream>
 #include <list>
+#include <functional>
+#include <future>
+#include <condition_variable>
+#include <array>
+#include <unordered_map>
+#include <unordered_set>
+#include <deque>
+#include <atomic>
+#include <limits>
 
 #if defined(WINDOWS)
 	#include "openssl/md5.h"
@@ -35,6 +44,12 @@
 	#define NOEXCEPT
 #endif
 
+#if !defined(_MSC_VER) || _MSC_VER >= 1900
+	#define CONSTEXPR constexpr
+#else
+	#define CONSTEXPR
+#endif
+
 #define	BSWAP_64(x)	(((uint64_t)(x) << 56) | \
 			(((uint64_t)(x) << 40) & 0xff000000000000ULL) | \
 			(((uint64_t)(x) << 24) & 0xff0000000000ULL) | \
@@ -112,11 +127,23 @@
 #define NET16_CPU(x)	BE16_CPU(x)
 #define NET8_CPU(x)	BE8_CPU(x)
 
+#include "Util/Bits.h"
+#include "Util/BufferPool.h"
 #include "Util/Data.h"
+#include "Util/Arena.h"
+#include "Util/Fingerprint.h"
 #include "Util/Util.h"
 #include "Util/StructParser.h"
+#include "IO/File.h"
+#include "IO/MappedFile.h"
+#include "IO/BlockPool.h"
+#include "IO/RequestQueue.h"
 #include "U8/U8.h"
 #include "JSON/JSON.h"
+#include "Http/Body.h"
+#include "Http/Request.h"
+#include "Http/HandlePool.h"
+#include "Http/Engine.h"
 
 #include <liboauthcpp/liboauthcpp.h>
 
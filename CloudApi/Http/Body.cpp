@@ -0,0 +1,131 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Http;
+
+Body::Body()
+{
+}
+
+/**
+ * Body - Creates a body of a single buffer, which the body takes over
+ */
+Body::Body(Data data) :
+	m_storage(std::move(data))
+{
+	AddStorage(0, m_storage.Size());
+}
+
+/**
+ * Reserve - Makes room for segmentCount segments, so a body whose shape is
+ * known up front doesn't regrow its segment list
+ */
+void Body::Reserve(size_t segmentCount)
+{
+	m_segments.Reserve(segmentCount * sizeof(Segment));
+}
+
+/**
+ * AddStorage - Appends a range of the body's own storage, storage may keep
+ * growing after this as segments are resolved when read
+ */
+void Body::AddStorage(size_t offset, size_t size)
+{
+	if(!size)
+		return;
+
+	// Extend the last segment if this range follows it
+	if(auto count = GetSegmentCount())
+	{
+		auto last = m_segments.Cast<Segment>((count - 1) * sizeof(Segment));
+		if(!last->reference && last->offset + last->size == offset)
+		{
+			last->size += size;
+			m_size += size;
+			return;
+		}
+	}
+
+	Segment segment = { nullptr, offset, size };
+	*m_segments.CastAllocAtEnd<Segment>(sizeof(Segment)) = segment;
+	m_size += size;
+}
+
+/**
+ * AddReference - Appends memory owned by the caller, it is read in place
+ */
+void Body::AddReference(const void *data, size_t size)
+{
+	if(!size)
+		return;
+
+	Segment segment = { static_cast<const uint8_t *>(data), 0, size };
+	*m_segments.CastAllocAtEnd<Segment>(sizeof(Segment)) = segment;
+	m_size += size;
+}
+
+/**
+ * KeepAlive - Holds on to an owner of referenced memory for the life of the body
+ */
+void Body::KeepAlive(const std::shared_ptr<const void> &owner)
+{
+	if(!m_owner)
+		m_owner = owner;
+	else
+		m_owners.push_back(owner);
+}
+
+const uint8_t *Body::GetSegmentData(const Segment &segment) const
+{
+	if(segment.reference)
+		return segment.reference;
+
+	return m_storage.Cast<uint8_t>(segment.offset, segment.size);
+}
+
+/**
+ * Read - Copies the next bytes of the body into buffer, returns
+ * the count copied (0 once the body has been read)
+ */
+size_t Body::Read(void *buffer, size_t size)
+{
+	auto output = static_cast<uint8_t *>(buffer);
+	size_t copied = 0;
+
+	while(copied < size && m_segment < GetSegmentCount())
+	{
+		auto &segment = GetSegment(m_segment);
+		auto length = std::min(segment.size - m_segmentOffset, size - copied);
+
+		memcpy(output + copied, GetSegmentData(segment) + m_segmentOffset, length);
+		copied += length;
+		m_segmentOffset += length;
+
+		if(m_segmentOffset == segment.size)
+		{
+			m_segment++;
+			m_segmentOffset = 0;
+		}
+	}
+
+	return copied;
+}
+
+/**
+ * Seek - Moves the read position, curl rewinds the body when it has
+ * to resend it (redirects, auth)
+ */
+bool Body::Seek(uint64_t offset)
+{
+	if(offset > m_size)
+		return false;
+
+	m_segment = 0;
+	m_segmentOffset = 0;
+
+	while(m_segment < GetSegmentCount() && offset >= GetSegment(m_segment).size)
+		offset -= GetSegment(m_segment++).size;
+
+	m_segmentOffset = static_cast<size_t>(offset);
+	return true;
+}
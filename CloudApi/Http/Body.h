@@ -0,0 +1,54 @@
+#pragma once
+
+namespace Copy {
+	namespace Http {
+
+/**
+ * Body - A request body made up of segments, segments either point into the
+ * body's own storage or reference memory owned by the caller, which is read
+ * by curl in place. Referenced memory must outlive the request, owners can be
+ * handed to KeepAlive when it is not otherwise guaranteed
+ */
+class Body
+{
+public:
+	Body();
+	Body(Data data);
+
+	Data &GetStorage() { return m_storage; }
+
+	void Reserve(size_t segmentCount);
+	void AddStorage(size_t offset, size_t size);
+	void AddReference(const void *data, size_t size);
+	void KeepAlive(const std::shared_ptr<const void> &owner);
+
+	size_t Size() const { return m_size; }
+
+	size_t Read(void *buffer, size_t size);
+	bool Seek(uint64_t offset);
+
+protected:
+	struct Segment
+	{
+		const uint8_t *reference;	// Caller memory, or null for body storage
+		size_t offset;				// Offset into body storage
+		size_t size;
+	};
+
+	size_t GetSegmentCount() const { return m_segments.Size() / sizeof(Segment); }
+	const Segment &GetSegment(size_t index) const { return *m_segments.Cast<Segment>(index * sizeof(Segment), sizeof(Segment)); }
+	const uint8_t *GetSegmentData(const Segment &segment) const;
+
+	Data m_storage;
+	Data m_segments;				// Segment array, pooled like the storage so it's recycled too
+	std::shared_ptr<const void> m_owner;		// The first owner, most bodies have no more
+	std::vector<std::shared_ptr<const void>> m_owners;
+	size_t m_size = 0;
+
+	// Read position
+	size_t m_segment = 0;
+	size_t m_segmentOffset = 0;
+};
+
+	}
+}
@@ -0,0 +1,281 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Http;
+
+// curl_multi_poll/curl_multi_wakeup let Submit interrupt a sleeping event thread,
+// older curl versions fall back to polling with a short timeout
+#if LIBCURL_VERSION_NUM >= 0x074400
+	#define HTTP_ENGINE_HAS_WAKEUP
+#endif
+
+/**
+ * Engine - Creates the multi handle and starts the event thread,
+ * maxActiveRequests limits how many requests are on the wire at once
+ */
+Engine::Engine(HandlePool &handles, uint32_t maxActiveRequests) :
+	m_handles(handles), m_maxActiveRequests(maxActiveRequests ? maxActiveRequests : 1)
+{
+	m_multi = curl_multi_init();
+	if(!m_multi)
+		throw std::logic_error("Failed to create curl multi handle");
+
+	m_thread = std::thread([this]() { Run(); });
+}
+
+/**
+ * ~Engine - Stops the event thread, anything still queued or in flight
+ * completes with an error
+ */
+Engine::~Engine()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stopping = true;
+	}
+
+	// Destroyed by one of its own callbacks, the event thread can't wait for
+	// itself. Run returns as soon as the callback does, so what it would have
+	// cancelled is cancelled here
+	if(std::this_thread::get_id() == m_thread.get_id())
+	{
+		*m_destroyed = true;
+		m_thread.detach();
+		Cancel();
+	}
+	else
+	{
+		Wakeup();
+		m_thread.join();
+	}
+
+	curl_multi_cleanup(m_multi);
+}
+
+/**
+ * Submit - Queues a request, its callback will be invoked from the event thread
+ */
+void Engine::Submit(const RequestPtr &request)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(m_stopping)
+			throw std::logic_error("Http engine is shutting down");
+		m_queued.push_back(request);
+	}
+
+	Wakeup();
+}
+
+/**
+ * GetPendingCount - Returns the count of requests queued or in flight
+ */
+size_t Engine::GetPendingCount()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_queued.size() + m_active.size();
+}
+
+void Engine::Wakeup()
+{
+	m_condition.notify_one();
+
+#ifdef HTTP_ENGINE_HAS_WAKEUP
+	curl_multi_wakeup(m_multi);
+#endif
+}
+
+/**
+ * Run - The event thread, moves queued requests onto the multi handle and
+ * drives them until the engine is destroyed
+ */
+void Engine::Run()
+{
+	bool destroyed = false;
+	m_destroyed = &destroyed;
+
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_lock);
+
+			// Sleep until there is something to do
+			while(!m_stopping && m_queued.empty() && m_active.empty())
+				m_condition.wait(lock);
+
+			if(m_stopping)
+				break;
+		}
+
+		if(!StartPending())
+			return;
+
+		int running = 0;
+		curl_multi_perform(m_multi, &running);
+
+		if(!CompleteFinished())
+			return;
+
+		if(running)
+		{
+#ifdef HTTP_ENGINE_HAS_WAKEUP
+			curl_multi_poll(m_multi, nullptr, 0, 1000, nullptr);
+#else
+			curl_multi_wait(m_multi, nullptr, 0, 10, nullptr);
+#endif
+		}
+	}
+
+	Cancel();
+}
+
+/**
+ * Cancel - Fails whatever is still queued or in flight once the engine stops
+ */
+void Engine::Cancel()
+{
+	std::list<RequestPtr> cancelled;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		cancelled.swap(m_queued);
+
+		for(auto &active : m_active)
+		{
+			curl_multi_remove_handle(m_multi, active.first);
+			m_handles.Release(active.first);
+			cancelled.push_back(active.second);
+		}
+		m_active.clear();
+	}
+
+	for(auto &request : cancelled)
+	{
+		if(!request->callback)
+			continue;
+
+		try
+		{
+			request->callback(*request, std::make_exception_ptr(std::logic_error("Request cancelled")));
+		}
+		catch(...)
+		{
+		}
+	}
+}
+
+/**
+ * Invoke - Runs a request's callback, returns false if the callback destroyed
+ * the engine, after which nothing of it may be touched
+ */
+bool Engine::Invoke(Request &request, std::exception_ptr error)
+{
+	auto destroyed = m_destroyed;
+
+	// Callbacks have no one to throw to on the event thread
+	try
+	{
+		request.callback(request, error);
+	}
+	catch(...)
+	{
+	}
+
+	return !*destroyed;
+}
+
+/**
+ * StartPending - Adds queued requests to the multi handle, up to the
+ * active request limit. A request that can't be set up fails on its own
+ * Returns false if a callback destroyed the engine
+ */
+bool Engine::StartPending()
+{
+	std::list<std::pair<RequestPtr, std::exception_ptr>> failed;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+
+		while(!m_queued.empty() && m_active.size() < m_maxActiveRequests)
+		{
+			auto request = m_queued.front();
+			m_queued.pop_front();
+
+			CURL *curl = nullptr;
+			try
+			{
+				curl = m_handles.Acquire();
+				request->Prepare(curl);
+			}
+			catch(...)
+			{
+				if(curl)
+					m_handles.Release(curl);
+
+				failed.push_back(std::make_pair(request, std::current_exception()));
+				continue;
+			}
+
+			m_active[curl] = request;
+			curl_multi_add_handle(m_multi, curl);
+		}
+	}
+
+	for(auto &failure : failed)
+	{
+		if(failure.first->callback && !Invoke(*failure.first, failure.second))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * CompleteFinished - Reaps every transfer curl reports as done
+ * Returns false if a callback destroyed the engine
+ */
+bool Engine::CompleteFinished()
+{
+	CURLMsg *message;
+	int remaining = 0;
+
+	while((message = curl_multi_info_read(m_multi, &remaining)))
+	{
+		if(message->msg == CURLMSG_DONE && !Complete(message->easy_handle, message->data.result))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Complete - Detaches a finished transfer and invokes its callback
+ * Returns false if the callback destroyed the engine
+ */
+bool Engine::Complete(CURL *curl, CURLcode result)
+{
+	RequestPtr request;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		auto iter = m_active.find(curl);
+		if(iter == m_active.end())
+			return true;
+
+		request = iter->second;
+		m_active.erase(iter);
+	}
+
+	curl_multi_remove_handle(m_multi, curl);
+
+	std::exception_ptr error;
+	try
+	{
+		request->Finish(curl, result);
+	}
+	catch(...)
+	{
+		error = std::current_exception();
+	}
+
+	m_handles.Release(curl);
+
+	return !request->callback || Invoke(*request, error);
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+namespace Copy {
+	namespace Http {
+
+/**
+ * Engine - Drives many requests concurrently over a curl multi handle on a
+ * single event thread. Requests are queued with Submit and their callback is
+ * invoked on the event thread once they complete. Easy handles are checked out
+ * of the pool for the duration of each transfer. A callback may destroy the
+ * engine, the event thread then stops as soon as the callback returns
+ */
+class Engine
+{
+public:
+	Engine(HandlePool &handles, uint32_t maxActiveRequests = 16);
+	~Engine();
+
+	void Submit(const RequestPtr &request);
+
+	size_t GetPendingCount();
+
+protected:
+	void Run();
+	bool StartPending();
+	bool CompleteFinished();
+	bool Complete(CURL *curl, CURLcode result);
+	bool Invoke(Request &request, std::exception_ptr error);
+	void Cancel();
+	void Wakeup();
+
+	HandlePool &m_handles;
+	CURLM *m_multi = nullptr;
+	uint32_t m_maxActiveRequests;
+
+	std::mutex m_lock;
+	std::condition_variable m_condition;
+	std::list<RequestPtr> m_queued;
+	std::map<CURL *, RequestPtr> m_active;
+	bool m_stopping = false;
+
+	std::thread m_thread;
+	bool *m_destroyed = nullptr;		// Run's, set when a callback destroys the engine
+};
+
+	}
+}
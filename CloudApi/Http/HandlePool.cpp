@@ -0,0 +1,104 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Http;
+
+std::once_flag HandlePool::s_hasInitializedCurl;
+
+HandlePool::Lease::Lease(HandlePool &pool) :
+	m_pool(&pool), m_curl(pool.Acquire())
+{
+}
+
+HandlePool::Lease::Lease(Lease &&lease) :
+	m_pool(lease.m_pool), m_curl(lease.m_curl)
+{
+	lease.m_curl = nullptr;
+}
+
+HandlePool::Lease::~Lease()
+{
+	if(m_curl)
+		m_pool->Release(m_curl);
+}
+
+/**
+ * HandlePool - maxIdleHandles caps how many handles (and their open
+ * connections) are kept around between requests
+ */
+HandlePool::HandlePool(uint32_t maxIdleHandles) :
+	m_maxIdleHandles(maxIdleHandles)
+{
+	std::call_once(s_hasInitializedCurl, []() { curl_global_init(CURL_GLOBAL_ALL); });
+
+	m_share = curl_share_init();
+	curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, LockCallback);
+	curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, UnlockCallback);
+	curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+	curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+	curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+HandlePool::~HandlePool()
+{
+	for(auto &curl : m_idle)
+		curl_easy_cleanup(curl);
+
+	curl_share_cleanup(m_share);
+}
+
+/**
+ * Acquire - Returns an idle handle, or creates one if none are idle
+ */
+CURL *HandlePool::Acquire()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(!m_idle.empty())
+		{
+			auto curl = m_idle.back();
+			m_idle.pop_back();
+			return curl;
+		}
+	}
+
+	auto curl = curl_easy_init();
+	if(!curl)
+		throw std::logic_error("Failed to create curl handle");
+
+	Request::SetupHandle(curl);
+	curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+	return curl;
+}
+
+/**
+ * Release - Returns a handle to the pool, its options are reset but its
+ * connections are kept
+ */
+void HandlePool::Release(CURL *curl)
+{
+	curl_easy_reset(curl);
+	Request::SetupHandle(curl);
+	curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(m_idle.size() < m_maxIdleHandles)
+		{
+			m_idle.push_back(curl);
+			return;
+		}
+	}
+
+	curl_easy_cleanup(curl);
+}
+
+void HandlePool::LockCallback(CURL *, curl_lock_data data, curl_lock_access, HandlePool *pool)
+{
+	pool->m_shareLocks[data].lock();
+}
+
+void HandlePool::UnlockCallback(CURL *, curl_lock_data data, HandlePool *pool)
+{
+	pool->m_shareLocks[data].unlock();
+}
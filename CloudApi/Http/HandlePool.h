@@ -0,0 +1,63 @@
+#pragma once
+
+namespace Copy {
+	namespace Http {
+
+/**
+ * HandlePool - Hands out curl easy handles to one request at a time. Idle
+ * handles keep their connections open so the next request that checks one
+ * out skips the tcp and tls handshakes, and every handle shares one dns and
+ * ssl session cache
+ */
+class HandlePool
+{
+public:
+	/**
+	 * Lease - A checked out handle, it goes back to the pool when the lease
+	 * goes out of scope
+	 */
+	class Lease
+	{
+	public:
+		Lease(HandlePool &pool);
+		Lease(Lease &&lease);
+		~Lease();
+
+		CURL *Get() const { return m_curl; }
+
+	protected:
+		Lease(const Lease &);
+		Lease & operator = (const Lease &);
+
+		HandlePool *m_pool;
+		CURL *m_curl;
+	};
+
+	HandlePool(uint32_t maxIdleHandles = 16);
+	~HandlePool();
+
+	Lease Checkout() { return Lease(*this); }
+
+	CURL *Acquire();
+	void Release(CURL *curl);
+
+protected:
+	HandlePool(const HandlePool &);
+	HandlePool & operator = (const HandlePool &);
+
+	static void LockCallback(CURL *curl, curl_lock_data data, curl_lock_access access, HandlePool *pool);
+	static void UnlockCallback(CURL *curl, curl_lock_data data, HandlePool *pool);
+
+	static std::once_flag s_hasInitializedCurl;
+
+	uint32_t m_maxIdleHandles;
+
+	std::mutex m_lock;
+	std::vector<CURL *> m_idle;
+
+	CURLSH *m_share = nullptr;
+	std::mutex m_shareLocks[CURL_LOCK_DATA_LAST];
+};
+
+	}
+}
@@ -0,0 +1,197 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Http;
+
+Request::Request()
+{
+}
+
+Request::~Request()
+{
+	if(m_headerList)
+		curl_slist_free_all(m_headerList);
+}
+
+/**
+ * SetupHandle - Applies the options every easy handle we create needs,
+ * regardless of the request it ends up running
+ */
+void Request::SetupHandle(CURL *curl)
+{
+	// Don't let signals mess us up! This prevents SIGALARM signal handlers to crash
+	// on longjumps in the dns timeout code in hostip.c
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1);
+
+	// Some SSL handshakes (e.g. w/ antivirus scanning) bomb out if we don't explicitly set this.
+	// openSSL 1.0.1c bug? https://code.google.com/p/plowshare/issues/detail?id=731
+	curl_easy_setopt(curl, CURLOPT_SSLVERSION, CURL_SSLVERSION_TLSv1);
+	curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+}
+
+/**
+ * Prepare - Points the easy handle at this request, the request must stay
+ * alive until Finish has been called
+ */
+void Request::Prepare(CURL *curl)
+{
+	if(m_headerList)
+	{
+		curl_slist_free_all(m_headerList);
+		m_headerList = nullptr;
+	}
+
+	for(auto iter = headerFields.begin(); iter != headerFields.end(); iter++)
+		m_headerList = curl_slist_append(m_headerList, (iter->first + std::string(": ") + iter->second).c_str());
+
+	response = Data();
+	responseHeaderFields.clear();
+	body.Seek(0);
+
+	m_curl = curl;
+	m_dataError = nullptr;
+
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, m_headerList);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWriteDataCallback);
+	curl_easy_setopt(curl, CURLOPT_POST, 1);
+	curl_easy_setopt(curl, CURLOPT_HEADER, 0);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, nullptr);
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.Size()));
+	curl_easy_setopt(curl, CURLOPT_READDATA, this);
+	curl_easy_setopt(curl, CURLOPT_READFUNCTION, CurlReadDataCallback);
+	curl_easy_setopt(curl, CURLOPT_SEEKDATA, this);
+	curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, CurlSeekDataCallback);
+	curl_easy_setopt(curl, CURLOPT_WRITEHEADER, this);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, CurlWriteHeaderCallback);
+
+	if(debugCallback)
+	{
+		curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+		curl_easy_setopt(curl, CURLOPT_DEBUGDATA, this);
+		curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, CurlDebugCallback);
+	}
+
+	curl_easy_setopt(curl, CURLOPT_ENCODING, "gzip,deflate");
+}
+
+/**
+ * Finish - Validates the outcome of a transfer, throws if the transfer
+ * failed or the cloud replied with an unexpected http status
+ */
+void Request::Finish(CURL *curl, CURLcode result)
+{
+	long httpStatus = 0;
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpStatus);
+
+	if(m_headerList)
+	{
+		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+		curl_slist_free_all(m_headerList);
+		m_headerList = nullptr;
+	}
+
+	m_curl = nullptr;
+
+	if(m_dataError)
+	{
+		auto error = m_dataError;
+		m_dataError = nullptr;
+		std::rethrow_exception(error);
+	}
+
+	if(result != CURLE_OK)
+		throw std::logic_error(curl_easy_strerror(result));
+	// Allow 302 - Found (redirect) 200 - OK http status codes
+	else if(httpStatus && httpStatus != 200 && httpStatus != 302)
+		throw std::logic_error("Unexpected http status");
+}
+
+/**
+ * Perform - Runs the request to completion on the calling thread
+ */
+void Request::Perform(CURL *curl)
+{
+	Prepare(curl);
+	Finish(curl, curl_easy_perform(curl));
+}
+
+size_t Request::CurlWriteDataCallback(char *ptr, size_t size, size_t nmemb, Request *request)
+{
+	if(request->dataCallback)
+	{
+		// Error replies are still collected so Finish can report on them
+		long httpStatus = 0;
+		curl_easy_getinfo(request->m_curl, CURLINFO_RESPONSE_CODE, &httpStatus);
+
+		if(httpStatus == 200)
+		{
+			// Exceptions can't unwind through curl, park it and abort the transfer
+			try
+			{
+				request->dataCallback(reinterpret_cast<const uint8_t *>(ptr), size * nmemb);
+			}
+			catch(...)
+			{
+				request->m_dataError = std::current_exception();
+				return 0;
+			}
+
+			return size * nmemb;
+		}
+	}
+
+	request->response.Append(size * nmemb, ptr);
+	return size * nmemb;
+}
+
+size_t Request::CurlReadDataCallback(char *ptr, size_t size, size_t nmemb, Request *request)
+{
+	return request->body.Read(ptr, size * nmemb);
+}
+
+int Request::CurlSeekDataCallback(Request *request, curl_off_t offset, int origin)
+{
+	if(origin != SEEK_SET || offset < 0)
+		return CURL_SEEKFUNC_CANTSEEK;
+
+	return request->body.Seek(static_cast<uint64_t>(offset)) ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+}
+
+size_t Request::CurlWriteHeaderCallback(void *ptr, size_t size, size_t nmemb, Request *request)
+{
+	auto headerLine = std::string(reinterpret_cast<char *>(ptr), size * nmemb);
+	auto keys = SplitString(headerLine, ":");
+	keys.first.erase(std::remove_if(keys.first.begin(), keys.first.end(), ::isspace), keys.first.end());
+	keys.second.erase(std::remove_if(keys.second.begin(), keys.second.end(), ::isspace), keys.second.end());
+	request->responseHeaderFields[keys.first] = keys.second;
+	return size * nmemb;
+}
+
+int Request::CurlDebugCallback(CURL *curl, curl_infotype infoType, char *data, size_t size, Request *request)
+{
+	if(!size)
+		return 0;
+
+	std::ostringstream ss;
+
+	switch(infoType)
+	{
+		case CURLINFO_HEADER_IN:
+			ss << "HEADER <- " << std::string(data, size);
+			break;
+
+		case CURLINFO_HEADER_OUT:
+			ss << "HEADER -> " << std::string(data, size);
+			break;
+
+		case CURLINFO_TEXT:
+			ss << std::string(data, size);
+			break;
+	}
+
+	request->debugCallback(ss.str());
+
+	return 0;
+}
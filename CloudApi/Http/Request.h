@@ -0,0 +1,63 @@
+#pragma once
+
+namespace Copy {
+	namespace Http {
+
+typedef std::map<std::string, std::string> HeaderFields;
+
+/**
+ * Request - Holds everything curl needs to perform a single http post, and
+ * collects its response. The same request can be run synchronously on an easy
+ * handle with Perform, or handed to an Engine to run along side others
+ */
+struct Request
+{
+	typedef std::function<void (Request &request, std::exception_ptr error)> Callback;
+	typedef std::function<void (const std::string &)> DebugCallback;
+	typedef std::function<void (const uint8_t *data, size_t size)> DataCallback;
+
+	Request();
+	~Request();
+
+	// Outgoing request
+	std::string url;
+	HeaderFields headerFields;
+	Body body;
+
+	// Incoming response, a successful response body is handed to dataCallback as
+	// it arrives instead of being collected in response when one is set
+	HeaderFields responseHeaderFields;
+	Data response;
+	DataCallback dataCallback;
+
+	// Invoked by the Engine once the request has completed (error is set on failure)
+	Callback callback;
+	DebugCallback debugCallback;
+
+	void Prepare(CURL *curl);
+	void Finish(CURL *curl, CURLcode result);
+	void Perform(CURL *curl);
+
+	static void SetupHandle(CURL *curl);
+
+protected:
+	Request(const Request &);
+	Request & operator = (const Request &);
+
+	static int CurlDebugCallback(CURL *curl, curl_infotype infoType, char *data, size_t size, Request *request);
+	static size_t CurlWriteHeaderCallback(void *ptr, size_t size, size_t nmemb, Request *request);
+	static size_t CurlWriteDataCallback(char *ptr, size_t size, size_t nmemb, Request *request);
+	static size_t CurlReadDataCallback(char *ptr, size_t size, size_t nmemb, Request *request);
+	static int CurlSeekDataCallback(Request *request, curl_off_t offset, int origin);
+
+	struct curl_slist *m_headerList = nullptr;
+	CURL *m_curl = nullptr;
+
+	// Thrown by dataCallback, rethrown from Finish
+	std::exception_ptr m_dataError;
+};
+
+typedef std::shared_ptr<Request> RequestPtr;
+
+	}
+}
@@ -0,0 +1,90 @@
+#include "Common.h"
+
+#if defined(WINDOWS)
+	#include <malloc.h>
+#else
+	#include <stdlib.h>
+#endif
+
+using namespace Copy;
+using namespace Copy::IO;
+
+/**
+ * BlockPool - blockSize is rounded up to a whole number of pages
+ */
+BlockPool::BlockPool(uint32_t count, size_t blockSize) :
+	m_count(std::max<uint32_t>(count, 1)),
+	m_blockSize((std::max<size_t>(blockSize, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT)
+{
+	auto total = m_blockSize * m_count;
+
+#if defined(WINDOWS)
+	m_memory = static_cast<uint8_t *>(_aligned_malloc(total, ALIGNMENT));
+#else
+	void *memory = nullptr;
+	if(posix_memalign(&memory, ALIGNMENT, total) == 0)
+		m_memory = static_cast<uint8_t *>(memory);
+#endif
+
+	if(!m_memory)
+		throw std::bad_alloc();
+
+	for(uint32_t i = m_count; i > 0; i--)
+		m_free.push_back(i - 1);
+}
+
+BlockPool::~BlockPool()
+{
+#if defined(WINDOWS)
+	_aligned_free(m_memory);
+#else
+	free(m_memory);
+#endif
+}
+
+/**
+ * Acquire - Waits for a free block
+ * Returns its index
+ */
+uint32_t BlockPool::Acquire()
+{
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_released.wait(lock, [this]() { return !m_free.empty(); });
+
+	auto index = m_free.back();
+	m_free.pop_back();
+	return index;
+}
+
+/**
+ * TryAcquire - Takes a free block if there is one
+ * Returns false if they're all in use
+ */
+bool BlockPool::TryAcquire(uint32_t &index)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	if(m_free.empty())
+		return false;
+
+	index = m_free.back();
+	m_free.pop_back();
+	return true;
+}
+
+void BlockPool::Release(uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_free.push_back(index);
+	m_released.notify_one();
+}
+
+/**
+ * View - Wraps the first size bytes of a block as Data, the block goes back to
+ * the pool once the view and every slice of it are gone. The pool has to
+ * outlive them all
+ */
+Data BlockPool::View(uint32_t index, size_t size)
+{
+	std::shared_ptr<const void> owner(GetBlock(index), [this, index](const void *) { Release(index); });
+	return Data::View(GetBlock(index), std::min(size, m_blockSize), owner);
+}
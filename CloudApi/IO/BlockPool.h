@@ -0,0 +1,45 @@
+#pragma once
+
+namespace Copy {
+	namespace IO {
+
+/**
+ * BlockPool - A fixed set of equally sized, page aligned blocks that file io is
+ * done into. They're allocated once and reused, which lets a RequestQueue
+ * register them with the kernel up front and meets O_DIRECT's alignment rules.
+ * Acquire blocks until a block is free, so the pool doubles as a cap on how
+ * much data can be in flight
+ */
+class BlockPool
+{
+public:
+	static const size_t ALIGNMENT = 4096;
+
+	BlockPool(uint32_t count, size_t blockSize);
+	~BlockPool();
+
+	uint32_t Acquire();
+	bool TryAcquire(uint32_t &index);
+	void Release(uint32_t index);
+
+	Data View(uint32_t index, size_t size);
+
+	uint8_t *GetBlock(uint32_t index) { return m_memory + index * m_blockSize; }
+	uint32_t GetCount() const { return m_count; }
+	size_t GetBlockSize() const { return m_blockSize; }
+
+protected:
+	BlockPool(const BlockPool &);
+	BlockPool & operator = (const BlockPool &);
+
+	uint32_t m_count;
+	size_t m_blockSize;
+	uint8_t *m_memory = nullptr;
+
+	std::mutex m_lock;
+	std::condition_variable m_released;
+	std::vector<uint32_t> m_free;
+};
+
+	}
+}
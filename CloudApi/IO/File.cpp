@@ -0,0 +1,362 @@
+#include "Common.h"
+
+#if defined(WINDOWS)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
+	#include <errno.h>
+#endif
+
+using namespace Copy;
+using namespace Copy::IO;
+
+namespace {
+
+#if defined(WINDOWS)
+	// Paths are utf8 in the api, the wide calls take them as utf16
+	std::wstring Widen(const std::string &path)
+	{
+		auto length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+		std::wstring wide(length > 0 ? length : 1, L'\0');
+		MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide[0], length);
+		wide.resize(wcslen(wide.c_str()));
+		return wide;
+	}
+
+	std::string SystemError(DWORD error)
+	{
+		char *message = nullptr;
+		FormatMessageA(FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS,
+			nullptr, error, 0, reinterpret_cast<char *>(&message), 0, nullptr);
+
+		std::string result = message ? message : "error " + std::to_string(error);
+		LocalFree(message);
+		return result;
+	}
+
+	OVERLAPPED AtOffset(uint64_t offset)
+	{
+		OVERLAPPED overlapped;
+		memset(&overlapped, 0, sizeof(overlapped));
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		return overlapped;
+	}
+#endif
+
+	// Reads and writes are issued at most this many bytes at a time
+	const size_t MAX_IO_SIZE = 1 << 30;
+
+}
+
+File::File()
+{
+#if defined(WINDOWS)
+	m_handle = INVALID_HANDLE_VALUE;
+#else
+	m_fd = -1;
+#endif
+}
+
+File::File(const std::string &path, Mode mode, bool direct) :
+	File()
+{
+	Open(path, mode, direct);
+}
+
+File::File(File &&file) :
+	File()
+{
+	*this = std::move(file);
+}
+
+File::~File()
+{
+	Close();
+}
+
+File &File::operator = (File &&file)
+{
+	if(this != &file)
+	{
+		Close();
+		m_path = std::move(file.m_path);
+#if defined(WINDOWS)
+		m_handle = file.m_handle;
+		file.m_handle = INVALID_HANDLE_VALUE;
+#else
+		m_fd = file.m_fd;
+		file.m_fd = -1;
+#endif
+	}
+
+	return *this;
+}
+
+void File::Fail(const std::string &operation) const
+{
+#if defined(WINDOWS)
+	auto error = SystemError(GetLastError());
+#else
+	auto error = std::string(strerror(errno));
+#endif
+
+	throw std::logic_error("File: " + operation + " failed for " + m_path + ": " + error);
+}
+
+/**
+ * Open - Opens path, MODE_WRITE creates it or truncates what's there. direct
+ * asks for uncached io, file systems that can't do it open the file cached
+ */
+void File::Open(const std::string &path, Mode mode, bool direct)
+{
+	Close();
+	m_path = path;
+
+#if defined(WINDOWS)
+	auto open = [&](DWORD flags)
+		{
+			return CreateFileW(Widen(path).c_str(), mode == MODE_WRITE ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+				FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, mode == MODE_WRITE ? CREATE_ALWAYS : OPEN_EXISTING,
+				flags, nullptr);
+		};
+
+	m_handle = open(FILE_ATTRIBUTE_NORMAL | (direct ? FILE_FLAG_NO_BUFFERING : 0));
+	if(m_handle == INVALID_HANDLE_VALUE && direct)
+		m_handle = open(FILE_ATTRIBUTE_NORMAL);
+
+	if(m_handle == INVALID_HANDLE_VALUE)
+		Fail("open");
+#else
+	auto flags = (mode == MODE_WRITE ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY) | O_CLOEXEC;
+
+#if defined(O_DIRECT)
+	if(direct)
+	{
+		do
+			m_fd = open(path.c_str(), flags | O_DIRECT, 0666);
+		while(m_fd < 0 && errno == EINTR);
+	}
+
+	// tmpfs and friends refuse O_DIRECT with EINVAL
+	if(m_fd < 0 && (!direct || errno == EINVAL))
+#endif
+	{
+		do
+			m_fd = open(path.c_str(), flags, 0666);
+		while(m_fd < 0 && errno == EINTR);
+	}
+
+	if(m_fd < 0)
+		Fail("open");
+
+#if defined(F_NOCACHE)
+	if(direct)
+		fcntl(m_fd, F_NOCACHE, 1);
+#endif
+#endif
+}
+
+void File::Close()
+{
+#if defined(WINDOWS)
+	if(m_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(m_handle);
+	m_handle = INVALID_HANDLE_VALUE;
+#else
+	if(m_fd >= 0)
+		close(m_fd);
+	m_fd = -1;
+#endif
+}
+
+bool File::IsOpen() const
+{
+#if defined(WINDOWS)
+	return m_handle != INVALID_HANDLE_VALUE;
+#else
+	return m_fd >= 0;
+#endif
+}
+
+uint64_t File::GetSize() const
+{
+#if defined(WINDOWS)
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(m_handle, &size))
+		Fail("size");
+	return static_cast<uint64_t>(size.QuadPart);
+#else
+	struct stat info;
+	if(fstat(m_fd, &info) != 0)
+		Fail("stat");
+	return static_cast<uint64_t>(info.st_size);
+#endif
+}
+
+/**
+ * Allocate - Sets the file's size to size and reserves its blocks up front, so
+ * writes landing out of order don't fragment it and a full disk shows up here
+ * rather than part way through
+ */
+void File::Allocate(uint64_t size)
+{
+#if defined(WINDOWS)
+	FILE_ALLOCATION_INFO allocation;
+	allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(size);
+	SetFileInformationByHandle(m_handle, FileAllocationInfo, &allocation, sizeof(allocation));
+
+	FILE_END_OF_FILE_INFO end;
+	end.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+	if(!SetFileInformationByHandle(m_handle, FileEndOfFileInfo, &end, sizeof(end)))
+		Fail("allocate");
+#else
+	if(!size)
+		return;
+
+	#if defined(__linux__)
+		// Not every file system can reserve blocks, those just get the size set
+		int result;
+		do
+		{
+			result = fallocate(m_fd, 0, 0, static_cast<off_t>(size));
+		}
+		while(result != 0 && errno == EINTR);
+
+		if(result == 0)
+			return;
+		if(errno != EOPNOTSUPP && errno != ENOSYS)
+			Fail("fallocate");
+	#elif defined(__APPLE__)
+		fstore_t store;
+		memset(&store, 0, sizeof(store));
+		store.fst_flags = F_ALLOCATEALL;
+		store.fst_posmode = F_PEOFPOSMODE;
+		store.fst_length = static_cast<off_t>(size);
+		fcntl(m_fd, F_PREALLOCATE, &store);
+	#endif
+
+	if(ftruncate(m_fd, static_cast<off_t>(size)) != 0)
+		Fail("truncate");
+#endif
+}
+
+/**
+ * Sync - Flushes written data through to the disk
+ */
+void File::Sync()
+{
+#if defined(WINDOWS)
+	if(!FlushFileBuffers(m_handle))
+		Fail("flush");
+#elif defined(__APPLE__)
+	if(fsync(m_fd) != 0)
+		Fail("fsync");
+#else
+	if(fdatasync(m_fd) != 0)
+		Fail("fdatasync");
+#endif
+}
+
+/**
+ * ReadAt - Reads up to size bytes from offset
+ * Returns the bytes read, less than size only at the end of the file
+ */
+size_t File::ReadAt(uint64_t offset, void *data, size_t size) const
+{
+	auto bytes = static_cast<uint8_t *>(data);
+	size_t total = 0;
+
+	while(total < size)
+	{
+		auto chunk = std::min(size - total, MAX_IO_SIZE);
+
+#if defined(WINDOWS)
+		auto overlapped = AtOffset(offset + total);
+		DWORD read = 0;
+		if(!ReadFile(m_handle, bytes + total, static_cast<DWORD>(chunk), &read, &overlapped))
+		{
+			if(GetLastError() == ERROR_HANDLE_EOF)
+				break;
+			Fail("read");
+		}
+#else
+		auto read = pread(m_fd, bytes + total, chunk, static_cast<off_t>(offset + total));
+		if(read < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			Fail("pread");
+		}
+#endif
+
+		if(!read)
+			break;
+
+		total += static_cast<size_t>(read);
+	}
+
+	return total;
+}
+
+/**
+ * WriteAt - Writes size bytes at offset
+ */
+void File::WriteAt(uint64_t offset, const void *data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t *>(data);
+	size_t total = 0;
+
+	while(total < size)
+	{
+		auto chunk = std::min(size - total, MAX_IO_SIZE);
+
+#if defined(WINDOWS)
+		auto overlapped = AtOffset(offset + total);
+		DWORD written = 0;
+		if(!WriteFile(m_handle, bytes + total, static_cast<DWORD>(chunk), &written, &overlapped))
+			Fail("write");
+#else
+		auto written = pwrite(m_fd, bytes + total, chunk, static_cast<off_t>(offset + total));
+		if(written < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			Fail("pwrite");
+		}
+#endif
+
+		total += static_cast<size_t>(written);
+	}
+}
+
+/**
+ * Rename - Moves from to to in one step, replacing anything already at to.
+ * Readers of to see either the old file or the new one, never a partial one
+ */
+void File::Rename(const std::string &from, const std::string &to)
+{
+#if defined(WINDOWS)
+	if(!MoveFileExW(Widen(from).c_str(), Widen(to).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		throw std::logic_error("File: rename failed for " + from + " to " + to + ": " + SystemError(GetLastError()));
+#else
+	if(rename(from.c_str(), to.c_str()) != 0)
+		throw std::logic_error("File: rename failed for " + from + " to " + to + ": " + strerror(errno));
+#endif
+}
+
+/**
+ * Remove - Deletes path
+ * Returns false if it couldn't be removed
+ */
+bool File::Remove(const std::string &path)
+{
+#if defined(WINDOWS)
+	return DeleteFileW(Widen(path).c_str()) != 0;
+#else
+	return unlink(path.c_str()) == 0;
+#endif
+}
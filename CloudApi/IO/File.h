@@ -0,0 +1,67 @@
+#pragma once
+
+namespace Copy {
+	namespace IO {
+
+/**
+ * File - A file handle for positional reads and writes. Nothing here moves a
+ * shared file position, so any number of threads can read and write different
+ * ranges of the same file at once. Failures throw std::logic_error naming the
+ * file and the system error. A direct file bypasses the page cache, its
+ * offsets, sizes and buffers then have to be BlockPool::ALIGNMENT aligned
+ */
+class File
+{
+public:
+	enum Mode
+	{
+		MODE_READ,			// Existing file, read only
+		MODE_WRITE,			// Created or truncated, read and write
+	};
+
+	File();
+	File(const std::string &path, Mode mode, bool direct = false);
+	File(File &&file);
+	~File();
+
+	File & operator = (File &&file);
+
+	void Open(const std::string &path, Mode mode, bool direct = false);
+	void Close();
+	bool IsOpen() const;
+
+	uint64_t GetSize() const;
+	void Allocate(uint64_t size);
+	void Sync();
+
+	size_t ReadAt(uint64_t offset, void *data, size_t size) const;
+	void WriteAt(uint64_t offset, const void *data, size_t size);
+
+	const std::string &GetPath() const { return m_path; }
+
+#if defined(WINDOWS)
+	void *GetHandle() const { return m_handle; }
+#else
+	int GetDescriptor() const { return m_fd; }
+#endif
+
+	static void Rename(const std::string &from, const std::string &to);
+	static bool Remove(const std::string &path);
+
+protected:
+	File(const File &);
+	File & operator = (const File &);
+
+	void Fail(const std::string &operation) const;
+
+	std::string m_path;
+
+#if defined(WINDOWS)
+	void *m_handle;
+#else
+	int m_fd;
+#endif
+};
+
+	}
+}
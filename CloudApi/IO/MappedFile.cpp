@@ -0,0 +1,204 @@
+#include "Common.h"
+
+#if defined(WINDOWS)
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <errno.h>
+#endif
+
+using namespace Copy;
+using namespace Copy::IO;
+
+// The mapping itself, shared by the file and every view of it
+struct MappedFile::Mapping
+{
+	~Mapping()
+	{
+		if(!data)
+			return;
+
+#if defined(WINDOWS)
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<uint8_t *>(data), static_cast<size_t>(size));
+#endif
+	}
+
+	/**
+	 * Advise - Passes advice on a range to the kernel, the range is widened out
+	 * to whole pages. Windows has no equivalent for file views so it's ignored
+	 */
+	void Advise(uint64_t offset, uint64_t length, int advice) const
+	{
+#if !defined(WINDOWS)
+		if(offset >= size || !length)
+			return;
+
+		auto end = std::min(size, offset + length);
+		auto first = offset - offset % pageSize;
+		auto last = std::min(size, (end + pageSize - 1) / pageSize * pageSize);
+
+		madvise(const_cast<uint8_t *>(data) + first, static_cast<size_t>(last - first), advice);
+#endif
+	}
+
+	const uint8_t *data = nullptr;
+	uint64_t size = 0;
+	uint64_t pageSize = 4096;
+	std::string path;
+};
+
+// Advice is dropped on Windows, these only need to be distinct
+#if defined(WINDOWS)
+	#define MADV_NORMAL 0
+	#define MADV_RANDOM 1
+	#define MADV_SEQUENTIAL 2
+	#define MADV_WILLNEED 3
+	#define MADV_DONTNEED 4
+#endif
+
+// A view that drops its pages once the last reference to it goes
+struct MappedFile::Region
+{
+	Region(const std::shared_ptr<Mapping> &_mapping, uint64_t _offset, uint64_t _size) :
+		mapping(_mapping), offset(_offset), size(_size)
+	{
+	}
+
+	~Region()
+	{
+		mapping->Advise(offset, size, MADV_DONTNEED);
+	}
+
+	std::shared_ptr<Mapping> mapping;
+	uint64_t offset;
+	uint64_t size;
+};
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+	Open(path);
+}
+
+/**
+ * Open - Maps the whole of path, throws std::logic_error if it can't
+ */
+void MappedFile::Open(const std::string &path)
+{
+	Close();
+
+	auto mapping = std::make_shared<Mapping>();
+	mapping->path = path;
+
+	// Only the mapping is kept, the file handle goes once it's made
+	IO::File file(path, IO::File::MODE_READ);
+	mapping->size = file.GetSize();
+
+	if(mapping->size)
+	{
+#if defined(WINDOWS)
+		auto section = CreateFileMappingW(file.GetHandle(), nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(section)
+		{
+			mapping->data = static_cast<const uint8_t *>(MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(section);
+		}
+
+		if(!mapping->data)
+			throw std::logic_error("MappedFile: failed to map " + path + ": error " + std::to_string(GetLastError()));
+#else
+		mapping->pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+		auto data = mmap(nullptr, static_cast<size_t>(mapping->size), PROT_READ, MAP_SHARED, file.GetDescriptor(), 0);
+		if(data == MAP_FAILED)
+			throw std::logic_error("MappedFile: failed to map " + path + ": " + strerror(errno));
+
+		mapping->data = static_cast<const uint8_t *>(data);
+#endif
+	}
+
+	m_mapping = mapping;
+}
+
+/**
+ * Close - Lets go of the mapping, views already handed out keep it alive
+ */
+void MappedFile::Close()
+{
+	m_mapping.reset();
+}
+
+uint64_t MappedFile::GetSize() const
+{
+	return m_mapping ? m_mapping->size : 0;
+}
+
+const uint8_t *MappedFile::GetData() const
+{
+	return m_mapping ? m_mapping->data : nullptr;
+}
+
+/**
+ * Advise - Tells the kernel how the file is going to be read
+ */
+void MappedFile::Advise(Advice advice)
+{
+	if(!m_mapping)
+		return;
+
+	int flag = MADV_NORMAL;
+	if(advice == ADVICE_SEQUENTIAL)
+		flag = MADV_SEQUENTIAL;
+	else if(advice == ADVICE_RANDOM)
+		flag = MADV_RANDOM;
+
+	m_mapping->Advise(0, m_mapping->size, flag);
+}
+
+/**
+ * WillNeed - Starts reading a range in ahead of it being touched
+ */
+void MappedFile::WillNeed(uint64_t offset, uint64_t size)
+{
+	if(m_mapping)
+		m_mapping->Advise(offset, size, MADV_WILLNEED);
+}
+
+/**
+ * DontNeed - Drops a range's pages from the process, they stay in the page
+ * cache and come back on the next touch. The mapping is read only so this
+ * never loses data, which is why a page shared with a neighbouring range that
+ * is still in use can safely go too
+ */
+void MappedFile::DontNeed(uint64_t offset, uint64_t size)
+{
+	if(m_mapping)
+		m_mapping->Advise(offset, size, MADV_DONTNEED);
+}
+
+/**
+ * View - Returns size bytes from offset without copying them. With
+ * dropWhenReleased the pages are let go once the view and every slice of it
+ * are gone, which keeps memory flat when a large file is read through once
+ */
+Data MappedFile::View(uint64_t offset, size_t size, bool dropWhenReleased) const
+{
+	if(!m_mapping || offset > m_mapping->size || size > m_mapping->size - offset)
+		throw std::logic_error("MappedFile: view is outside " + (m_mapping ? m_mapping->path : std::string("the file")));
+
+	if(!size)
+		return Data();
+
+	std::shared_ptr<const void> owner = m_mapping;
+	if(dropWhenReleased)
+		owner = std::make_shared<Region>(m_mapping, offset, size);
+
+	return Data::View(m_mapping->data + offset, size, owner);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+namespace Copy {
+	namespace IO {
+
+/**
+ * MappedFile - Maps a whole file read only. Views of the mapping are handed out
+ * as Data, so parts can be fingerprinted and sent straight from the page cache
+ * without being copied onto the heap. Each view keeps the mapping alive, it is
+ * only unmapped once the file and every view of it are gone
+ */
+class MappedFile
+{
+public:
+	enum Advice
+	{
+		ADVICE_NORMAL,
+		ADVICE_SEQUENTIAL,		// Read ahead aggressively, pages behind can go early
+		ADVICE_RANDOM,			// Don't bother reading ahead
+	};
+
+	MappedFile();
+	MappedFile(const std::string &path);
+
+	void Open(const std::string &path);
+	void Close();
+	bool IsOpen() const { return m_mapping != nullptr; }
+
+	uint64_t GetSize() const;
+	const uint8_t *GetData() const;
+
+	void Advise(Advice advice);
+	void WillNeed(uint64_t offset, uint64_t size);
+	void DontNeed(uint64_t offset, uint64_t size);
+
+	Data View(uint64_t offset, size_t size, bool dropWhenReleased = false) const;
+
+protected:
+	struct Mapping;
+	struct Region;
+
+	std::shared_ptr<Mapping> m_mapping;
+};
+
+	}
+}
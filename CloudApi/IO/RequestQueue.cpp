@@ -0,0 +1,439 @@
+#include "Common.h"
+
+#include <errno.h>
+
+#if defined(HAVE_IO_URING)
+	#include <linux/io_uring.h>
+	#include <sys/mman.h>
+	#include <sys/syscall.h>
+	#include <sys/uio.h>
+	#include <unistd.h>
+
+	// Older libcs don't name the calls, the numbers are the same on every arch but alpha
+	#ifndef __NR_io_uring_setup
+		#define __NR_io_uring_setup 425
+	#endif
+	#ifndef __NR_io_uring_enter
+		#define __NR_io_uring_enter 426
+	#endif
+	#ifndef __NR_io_uring_register
+		#define __NR_io_uring_register 427
+	#endif
+#endif
+
+using namespace Copy;
+using namespace Copy::IO;
+
+#if defined(HAVE_IO_URING)
+
+/**
+ * Ring - The io_uring itself, the submission and completion rings are shared
+ * with the kernel so their heads and tails are read and written with acquire
+ * and release ordering
+ */
+struct RequestQueue::Ring
+{
+	~Ring()
+	{
+		if(sqes)
+			munmap(sqes, sqesSize);
+		if(cqRing && cqRing != sqRing)
+			munmap(cqRing, cqRingSize);
+		if(sqRing)
+			munmap(sqRing, sqRingSize);
+		if(fd >= 0)
+			close(fd);
+	}
+
+	/**
+	 * Setup - Creates a ring with room for entries requests
+	 * Returns false if the kernel can't give us a usable one
+	 */
+	bool Setup(uint32_t entries)
+	{
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if(fd < 0)
+			return false;
+
+		// Plain read and write arrived in the same release as this feature
+		if(!(params.features & IORING_FEAT_RW_CUR_POS))
+			return false;
+
+		sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if(params.features & IORING_FEAT_SINGLE_MMAP)
+			sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+		sqRing = Map(sqRingSize, IORING_OFF_SQ_RING);
+		cqRing = params.features & IORING_FEAT_SINGLE_MMAP ? sqRing : Map(cqRingSize, IORING_OFF_CQ_RING);
+		sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = static_cast<io_uring_sqe *>(Map(sqesSize, IORING_OFF_SQES));
+		if(!sqRing || !cqRing || !sqes)
+			return false;
+
+		auto sq = static_cast<uint8_t *>(sqRing);
+		sqHead = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+		sqTail = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+		sqMask = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+		sqEntries = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_entries);
+		sqArray = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+
+		auto cq = static_cast<uint8_t *>(cqRing);
+		cqHead = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+		cqTail = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+		cqMask = *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+		return true;
+	}
+
+	void *Map(size_t size, off_t offset)
+	{
+		auto memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+		return memory == MAP_FAILED ? nullptr : memory;
+	}
+
+	/**
+	 * Push - Fills in the next submission entry, there is always room as the
+	 * queue never has more requests out than the ring has entries
+	 */
+	void Push(const Request &request, uint32_t slot)
+	{
+		auto tail = *sqTail;
+		auto index = tail & sqMask;
+		auto &sqe = sqes[index];
+		memset(&sqe, 0, sizeof(sqe));
+
+		auto fixed = request.block != NO_BLOCK;
+		if(request.write)
+			sqe.opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+		else
+			sqe.opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+
+		sqe.fd = request.file->GetDescriptor();
+		sqe.off = request.offset;
+		sqe.addr = reinterpret_cast<uint64_t>(request.data);
+		sqe.len = static_cast<uint32_t>(request.size);
+		sqe.user_data = slot;
+		if(fixed)
+			sqe.buf_index = static_cast<uint16_t>(request.block);
+
+		sqArray[index] = index;
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+		unsubmitted++;
+	}
+
+	/**
+	 * Enter - Hands over anything unsubmitted and waits for minimum completions
+	 */
+	void Enter(uint32_t minimum)
+	{
+		while(true)
+		{
+			auto result = syscall(__NR_io_uring_enter, fd, unsubmitted, minimum, minimum ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			if(result >= 0)
+			{
+				unsubmitted -= static_cast<uint32_t>(result);
+				return;
+			}
+
+			if(errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				throw std::logic_error(std::string("RequestQueue: io_uring_enter failed: ") + strerror(errno));
+		}
+	}
+
+	/**
+	 * Reap - Takes every completion that is ready
+	 * Returns how many there were
+	 */
+	template<typename Callback>
+	uint32_t Reap(const Callback &callback)
+	{
+		uint32_t count = 0;
+
+		// The head is read afresh each time round, a callback can queue more
+		// requests and end up reaping some itself
+		while(true)
+		{
+			auto head = *cqHead;
+			if(head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+				return count;
+
+			auto &cqe = cqes[head & cqMask];
+			auto slot = static_cast<uint32_t>(cqe.user_data);
+			auto result = cqe.res;
+
+			// Give the entry back before running anything that might queue more
+			__atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+			callback(slot, result);
+			count++;
+		}
+	}
+
+	int fd = -1;
+	uint32_t unsubmitted = 0;
+
+	void *sqRing = nullptr;
+	void *cqRing = nullptr;
+	size_t sqRingSize = 0;
+	size_t cqRingSize = 0;
+	io_uring_sqe *sqes = nullptr;
+	size_t sqesSize = 0;
+
+	uint32_t *sqHead = nullptr;
+	uint32_t *sqTail = nullptr;
+	uint32_t sqMask = 0;
+	uint32_t sqEntries = 0;
+	uint32_t *sqArray = nullptr;
+
+	uint32_t *cqHead = nullptr;
+	uint32_t *cqTail = nullptr;
+	uint32_t cqMask = 0;
+	io_uring_cqe *cqes = nullptr;
+};
+
+#else
+
+struct RequestQueue::Ring
+{
+};
+
+#endif
+
+/**
+ * RequestQueue - depth is the most requests that are ever in flight at once
+ */
+RequestQueue::RequestQueue(uint32_t depth) :
+	m_depth(std::max<uint32_t>(depth, 1))
+{
+	m_slots.resize(m_depth);
+	for(uint32_t i = m_depth; i > 0; i--)
+		m_freeSlots.push_back(i - 1);
+
+#if defined(HAVE_IO_URING)
+	std::unique_ptr<Ring> ring(new Ring());
+	if(ring->Setup(m_depth))
+		m_ring = std::move(ring);
+#endif
+}
+
+RequestQueue::~RequestQueue()
+{
+#if defined(HAVE_IO_URING)
+	// The kernel may still be filling or reading buffers, which belong to the
+	// caller and are about to go, so wait it out without running completions
+	if(m_ring)
+	{
+		try
+		{
+			while(m_inFlight)
+			{
+				m_ring->Enter(1);
+				m_inFlight -= m_ring->Reap([](uint32_t, int64_t) {});
+			}
+		}
+		catch(...)
+		{
+		}
+	}
+#endif
+}
+
+/**
+ * IsAsync - Returns true if requests really run in the background, false if
+ * they're done in place during Submit
+ */
+bool RequestQueue::IsAsync() const
+{
+	return m_ring != nullptr;
+}
+
+/**
+ * RegisterBlocks - Pins a pool's blocks with the kernel once, so requests
+ * naming a block skip mapping its pages on every call
+ */
+void RequestQueue::RegisterBlocks(BlockPool &pool)
+{
+	m_blocks = &pool;
+
+#if defined(HAVE_IO_URING)
+	if(!m_ring)
+		return;
+
+	std::vector<iovec> blocks(pool.GetCount());
+	for(uint32_t i = 0; i < pool.GetCount(); i++)
+	{
+		blocks[i].iov_base = pool.GetBlock(i);
+		blocks[i].iov_len = pool.GetBlockSize();
+	}
+
+	// Locked memory limits can refuse this, requests then just name no block
+	if(syscall(__NR_io_uring_register, m_ring->fd, IORING_REGISTER_BUFFERS, blocks.data(), blocks.size()) != 0)
+		m_blocks = nullptr;
+#endif
+}
+
+/**
+ * Read - Queues a read of size bytes at offset into data, block is the index
+ * of a registered block that data lies in
+ */
+void RequestQueue::Read(const File &file, uint64_t offset, void *data, size_t size, Completion completion, int32_t block)
+{
+	Request request = { false, &file, offset, static_cast<uint8_t *>(data), size, block, std::move(completion), 0 };
+	Queue(std::move(request));
+}
+
+/**
+ * Write - Queues a write of size bytes from data at offset, data has to stay
+ * put until the completion has run
+ */
+void RequestQueue::Write(const File &file, uint64_t offset, const void *data, size_t size, Completion completion, int32_t block)
+{
+	Request request = { true, &file, offset, const_cast<uint8_t *>(static_cast<const uint8_t *>(data)), size, block,
+		std::move(completion), 0 };
+	Queue(std::move(request));
+}
+
+void RequestQueue::Queue(Request request)
+{
+	if(request.size > std::numeric_limits<uint32_t>::max())
+		throw std::logic_error("RequestQueue: requests are limited to 4GB");
+
+	if(!m_blocks)
+		request.block = NO_BLOCK;
+
+	// A full queue makes room by finishing something first
+	while(m_freeSlots.empty())
+		Wait(1);
+
+	auto slot = m_freeSlots.back();
+	m_freeSlots.pop_back();
+	m_slots[slot] = std::move(request);
+	m_inFlight++;
+
+#if defined(HAVE_IO_URING)
+	if(m_ring)
+	{
+		m_ring->Push(m_slots[slot], slot);
+		return;
+	}
+#endif
+
+	m_unsubmitted.push_back(slot);
+}
+
+/**
+ * Submit - Hands every queued request over in one go
+ * Returns how many were handed over
+ */
+uint32_t RequestQueue::Submit()
+{
+#if defined(HAVE_IO_URING)
+	if(m_ring)
+	{
+		auto count = m_ring->unsubmitted;
+		if(count)
+			m_ring->Enter(0);
+		return count - m_ring->unsubmitted;
+	}
+#endif
+
+	auto count = static_cast<uint32_t>(m_unsubmitted.size());
+	for(auto slot : m_unsubmitted)
+	{
+		auto &request = m_slots[slot];
+		try
+		{
+			if(request.write)
+			{
+				const_cast<File *>(request.file)->WriteAt(request.offset, request.data, request.size);
+				request.result = static_cast<int64_t>(request.size);
+			}
+			else
+				request.result = static_cast<int64_t>(request.file->ReadAt(request.offset, request.data, request.size));
+		}
+		catch(std::exception &)
+		{
+			request.result = -(errno ? errno : EIO);
+		}
+
+		m_finished.push_back(slot);
+	}
+
+	m_unsubmitted.clear();
+	return count;
+}
+
+/**
+ * Wait - Runs completions, waiting until at least minimum have finished or
+ * nothing is left in flight. Throws std::logic_error for a failed request once
+ * the others that finished with it have been completed
+ * Returns how many completions ran
+ */
+uint32_t RequestQueue::Wait(uint32_t minimum)
+{
+	uint32_t completed = 0;
+	std::string error;
+
+#if defined(HAVE_IO_URING)
+	if(m_ring)
+	{
+		auto complete = [this, &error](uint32_t slot, int64_t result) { Complete(slot, result, error); };
+
+		completed += m_ring->Reap(complete);
+		while(completed < minimum && m_inFlight)
+		{
+			m_ring->Enter(std::min(minimum - completed, m_inFlight));
+			completed += m_ring->Reap(complete);
+		}
+	}
+	else
+#endif
+	{
+		if(m_finished.size() < minimum)
+			Submit();
+
+		auto finished = std::move(m_finished);
+		m_finished.clear();
+		for(auto slot : finished)
+		{
+			Complete(slot, m_slots[slot].result, error);
+			completed++;
+		}
+	}
+
+	if(!error.empty())
+		throw std::logic_error(error);
+
+	return completed;
+}
+
+/**
+ * Complete - Frees a request's slot and runs its completion, failures are
+ * noted in error rather than thrown so the rest of a batch still completes
+ */
+void RequestQueue::Complete(uint32_t slot, int64_t result, std::string &error)
+{
+	auto request = std::move(m_slots[slot]);
+	m_slots[slot] = Request();
+	m_freeSlots.push_back(slot);
+	m_inFlight--;
+
+	if(result >= 0 && request.write && static_cast<size_t>(result) != request.size)
+		result = -EIO;
+
+	if(result < 0)
+	{
+		if(error.empty())
+		{
+			error = std::string("RequestQueue: ") + (request.write ? "write" : "read") + " failed for " +
+				request.file->GetPath() + ": " + strerror(static_cast<int>(-result));
+		}
+		return;
+	}
+
+	if(request.completion)
+		request.completion(static_cast<size_t>(result));
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+namespace Copy {
+	namespace IO {
+
+/**
+ * RequestQueue - Keeps many positional file reads and writes in flight from
+ * one thread. Requests are queued, handed to the kernel together by Submit and
+ * their completions run from Wait. On Linux this is an io_uring driven through
+ * its raw system calls, elsewhere (or when the kernel refuses one) the requests
+ * run with pread and pwrite during Submit, so callers behave the same either way.
+ * Not thread safe, one thread queues, submits and waits
+ */
+class RequestQueue
+{
+public:
+	// Called from Wait with the bytes moved, which is short only at the end of a file
+	typedef std::function<void (size_t bytes)> Completion;
+
+	static const int32_t NO_BLOCK = -1;
+
+	RequestQueue(uint32_t depth = 64);
+	~RequestQueue();
+
+	bool IsAsync() const;
+	uint32_t GetDepth() const { return m_depth; }
+	uint32_t GetInFlight() const { return m_inFlight; }
+
+	void RegisterBlocks(BlockPool &pool);
+
+	void Read(const File &file, uint64_t offset, void *data, size_t size, Completion completion, int32_t block = NO_BLOCK);
+	void Write(const File &file, uint64_t offset, const void *data, size_t size, Completion completion, int32_t block = NO_BLOCK);
+
+	uint32_t Submit();
+	uint32_t Wait(uint32_t minimum = 1);
+
+protected:
+	RequestQueue(const RequestQueue &);
+	RequestQueue & operator = (const RequestQueue &);
+
+	struct Request
+	{
+		bool write;
+		const File *file;
+		uint64_t offset;
+		uint8_t *data;
+		size_t size;
+		int32_t block;
+		Completion completion;
+		int64_t result;
+	};
+
+	struct Ring;
+
+	void Queue(Request request);
+	void Complete(uint32_t slot, int64_t result, std::string &error);
+
+	uint32_t m_depth;
+	uint32_t m_inFlight = 0;
+
+	std::vector<Request> m_slots;
+	std::vector<uint32_t> m_freeSlots;
+	std::vector<uint32_t> m_unsubmitted;		// Queued but not yet handed over
+	std::vector<uint32_t> m_finished;			// Done without the ring, waiting for Wait
+
+	BlockPool *m_blocks = nullptr;
+	std::unique_ptr<Ring> m_ring;
+};
+
+	}
+}
@@ -0,0 +1,236 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+namespace Copy {
+	namespace JSON {
+
+bool FieldTraits<ValuePtr>::Open(void *field, Type type, BindReader &reader)
+{
+	reader.PushValue(static_cast<ValuePtr *>(field), type);
+	return true;
+}
+
+	}
+}
+
+BindReader::BindReader()
+{
+	m_slot.field = nullptr;
+	m_slot.functions = nullptr;
+}
+
+/**
+ * Reset - Starts reading a new value into root
+ */
+void BindReader::Reset(const Slot &root)
+{
+	m_frames.clear();
+	m_slot = root;
+	m_hasSlot = true;
+	m_complete = false;
+	m_valueTarget = nullptr;
+}
+
+/**
+ * TakeSlot - Works out where the value that's starting goes
+ * Returns false if it isn't wanted
+ */
+bool BindReader::TakeSlot(Slot &slot)
+{
+	if(m_frames.empty() || m_frames.back().kind == FRAME_OBJECT)
+	{
+		if(!m_hasSlot)
+			return false;
+
+		slot = m_slot;
+		m_hasSlot = false;
+		return true;
+	}
+
+	auto &frame = m_frames.back();
+	if(frame.kind != FRAME_ARRAY)
+		return false;
+
+	slot = frame.append(frame.target);
+	return true;
+}
+
+/**
+ * Done - A value finished, if it was the root reading is complete
+ */
+void BindReader::Done()
+{
+	if(m_frames.empty())
+		m_complete = true;
+}
+
+void BindReader::StartObject()
+{
+	Open(Type_Object);
+}
+
+void BindReader::StartArray()
+{
+	Open(Type_Array);
+}
+
+void BindReader::Open(Type type)
+{
+	if(!m_frames.empty())
+	{
+		auto &frame = m_frames.back();
+		if(frame.kind == FRAME_SKIP)
+		{
+			frame.depth++;
+			return;
+		}
+		else if(frame.kind == FRAME_VALUE)
+		{
+			if(type == Type_Object)
+				m_builder.StartObject();
+			else
+				m_builder.StartArray();
+
+			frame.depth++;
+			return;
+		}
+	}
+
+	Slot slot;
+	if(TakeSlot(slot) && slot.functions->open(slot.field, type, *this))
+		return;
+
+	Frame frame = { FRAME_SKIP, nullptr, nullptr, nullptr, 0, 1 };
+	m_frames.push_back(frame);
+}
+
+void BindReader::Key(const char *data, size_t size)
+{
+	auto &frame = m_frames.back();
+	if(frame.kind == FRAME_VALUE)
+		return m_builder.Key(data, size);
+	else if(frame.kind != FRAME_OBJECT)
+		return;
+
+	// A repeated member is read again over the one before it, as in a Value tree
+	uint32_t index;
+	m_hasSlot = frame.object->find(frame.target, JSON::Key(data, size), m_slot, index);
+	if(m_hasSlot && index < 64)
+		frame.seen |= static_cast<uint64_t>(1) << index;
+}
+
+void BindReader::EndObject()
+{
+	Close(true);
+}
+
+void BindReader::EndArray()
+{
+	Close(false);
+}
+
+void BindReader::Close(bool isObject)
+{
+	auto &frame = m_frames.back();
+	switch(frame.kind)
+	{
+		case FRAME_SKIP:
+			if(--frame.depth)
+				return;
+			break;
+
+		case FRAME_VALUE:
+			if(isObject)
+				m_builder.EndObject();
+			else
+				m_builder.EndArray();
+
+			if(--frame.depth)
+				return;
+
+			*m_valueTarget = m_builder.Take();
+			m_valueTarget = nullptr;
+			break;
+
+		case FRAME_OBJECT:
+			frame.object->finish(frame.target, frame.seen);
+			break;
+
+		case FRAME_ARRAY:
+			break;
+	}
+
+	m_frames.pop_back();
+	m_hasSlot = false;
+	Done();
+}
+
+void BindReader::String(const char *data, size_t size)
+{
+	if(!m_frames.empty() && m_frames.back().kind == FRAME_VALUE)
+		return m_builder.String(data, size);
+
+	Slot slot;
+	if(TakeSlot(slot))
+		slot.functions->string(slot.field, data, size);
+	Done();
+}
+
+void BindReader::Number(uint64_t value)
+{
+	if(!m_frames.empty() && m_frames.back().kind == FRAME_VALUE)
+		return m_builder.Number(value);
+
+	Slot slot;
+	if(TakeSlot(slot))
+		slot.functions->number(slot.field, value);
+	Done();
+}
+
+void BindReader::Null()
+{
+	if(!m_frames.empty() && m_frames.back().kind == FRAME_VALUE)
+		return m_builder.Null();
+
+	Slot slot;
+	if(TakeSlot(slot))
+		slot.functions->null(slot.field);
+	Done();
+}
+
+/**
+ * PushObject - Starts reading an object into a bound struct
+ */
+void BindReader::PushObject(void *object, const ObjectFunctions *functions)
+{
+	Frame frame = { FRAME_OBJECT, object, functions, nullptr, 0, 0 };
+	m_frames.push_back(frame);
+}
+
+/**
+ * PushArray - Starts reading an array, append adds an element for each value
+ */
+void BindReader::PushArray(void *array, Slot (*append)(void *array))
+{
+	Frame frame = { FRAME_ARRAY, array, nullptr, append, 0, 0 };
+	m_frames.push_back(frame);
+}
+
+/**
+ * PushValue - Starts building a Value tree from a container
+ */
+void BindReader::PushValue(ValuePtr *value, Type type)
+{
+	m_builder = ValueBuilder();
+	if(type == Type_Object)
+		m_builder.StartObject();
+	else
+		m_builder.StartArray();
+
+	m_valueTarget = value;
+
+	Frame frame = { FRAME_VALUE, nullptr, nullptr, nullptr, 0, 1 };
+	m_frames.push_back(frame);
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+// Flags a member is bound with
+enum FieldFlags
+{
+	FIELD_REQUIRED = 1,				// Reading throws if it's missing
+	FIELD_NUMBER_STRING = 2,		// Written as a string of digits, as the cloud api takes numbers
+};
+
+/**
+ * Binding - Specialised for each struct that's read from or written as json.
+ * The specialisation's Fields calls visitor(Key("name"), bound.member, flags)
+ * once for each member, and that one list is what the reading and writing
+ * code for the struct is generated from:
+ *
+ *	template<>
+ *	struct Binding<Part>
+ *	{
+ *		template<class Visitor, class Bound>
+ *		static void Fields(Visitor &visitor, Bound &part)
+ *		{
+ *			visitor(Key("offset"), part.offset, FIELD_REQUIRED);
+ *			visitor(Key("size"), part.size);
+ *		}
+ *	};
+ */
+template<class T>
+struct Binding;
+
+/**
+ * Optional - A member that remembers whether it was in the json, whatever type
+ * the value was. It's left out when written if it was never set
+ */
+template<class T>
+struct Optional
+{
+	Optional() : value(), has(false) {}
+	Optional(const T &_value) : value(_value), has(true) {}
+
+	T value;
+	bool has;
+};
+
+class BindReader;
+
+/**
+ * SlotFunctions - How a value is put into one type of member, each member type
+ * gets one table from FieldTraits. Values of the wrong type leave the member
+ * as it was, open returns false when the container should be skipped
+ */
+struct SlotFunctions
+{
+	void (*string)(void *field, const char *data, size_t size);
+	void (*number)(void *field, uint64_t value);
+	void (*null)(void *field);
+	bool (*open)(void *field, Type type, BindReader &reader);
+};
+
+// Where the next value read goes
+struct Slot
+{
+	void *field;
+	const SlotFunctions *functions;
+};
+
+/**
+ * ObjectFunctions - Generated for each bound struct, find matches a key with a
+ * member and finish checks a read object had its required members. index is
+ * the member's position
+ */
+struct ObjectFunctions
+{
+	bool (*find)(void *object, const Key &key, Slot &slot, uint32_t &index);
+	void (*finish)(void *object, uint64_t seen);
+};
+
+template<class T>
+Slot MakeSlot(T &field);
+
+/**
+ * FieldTraits - How a member of type T is read and written. Unspecialised T is
+ * a bound struct, read from and written as an object
+ */
+template<class T>
+struct FieldTraits
+{
+	static void String(void *, const char *, size_t) {}
+	static void Number(void *, uint64_t) {}
+	static void Null(void *) {}
+	static bool Open(void *field, Type type, BindReader &reader);
+
+	static bool IsSet(const T &) { return true; }
+	static void Write(Writer &writer, const T &field, uint32_t flags);
+};
+
+template<>
+struct FieldTraits<std::string>
+{
+	static void String(void *field, const char *data, size_t size) { static_cast<std::string *>(field)->assign(data, size); }
+	static void Number(void *, uint64_t) {}
+	static void Null(void *) {}
+	static bool Open(void *, Type, BindReader &) { return false; }
+
+	static bool IsSet(const std::string &) { return true; }
+	static void Write(Writer &writer, const std::string &field, uint32_t) { writer.String(field); }
+};
+
+// Numbers may come as strings of digits, the way the cloud sends most of them
+template<class T>
+struct NumberTraits
+{
+	static void String(void *field, const char *data, size_t size)
+	{
+		uint64_t number;
+		if(ParseDigits(data, size, number))
+			*static_cast<T *>(field) = static_cast<T>(number);
+	}
+
+	static void Number(void *field, uint64_t value) { *static_cast<T *>(field) = static_cast<T>(value); }
+	static void Null(void *) {}
+	static bool Open(void *, Type, BindReader &) { return false; }
+
+	static bool IsSet(const T &) { return true; }
+	static void Write(Writer &writer, const T &field, uint32_t flags)
+	{
+		if(flags & FIELD_NUMBER_STRING)
+			writer.NumberString(field);
+		else
+			writer.Number(field);
+	}
+};
+
+template<>
+struct FieldTraits<uint64_t> : NumberTraits<uint64_t> {};
+
+template<>
+struct FieldTraits<uint32_t> : NumberTraits<uint32_t> {};
+
+// A fingerprint is its hex string
+template<>
+struct FieldTraits<Fingerprint>
+{
+	static void String(void *field, const char *data, size_t size) { Fingerprint::FromHex(data, size, *static_cast<Fingerprint *>(field)); }
+	static void Number(void *, uint64_t) {}
+	static void Null(void *) {}
+	static bool Open(void *, Type, BindReader &) { return false; }
+
+	static bool IsSet(const Fingerprint &) { return true; }
+	static void Write(Writer &writer, const Fingerprint &field, uint32_t)
+	{
+		char hex[Fingerprint::HEX_SIZE];
+		field.ToHex(hex);
+		writer.String(hex, sizeof(hex));
+	}
+};
+
+// Anything at all, kept as a Value tree
+template<>
+struct FieldTraits<ValuePtr>
+{
+	static void String(void *field, const char *data, size_t size) { *static_cast<ValuePtr *>(field) = std::make_shared<Value>(data, size); }
+	static void Number(void *field, uint64_t value) { *static_cast<ValuePtr *>(field) = std::make_shared<Value>(value); }
+	static void Null(void *field) { *static_cast<ValuePtr *>(field) = std::make_shared<Value>(); }
+	static bool Open(void *field, Type type, BindReader &reader);
+
+	static bool IsSet(const ValuePtr &) { return true; }
+	static void Write(Writer &writer, const ValuePtr &field, uint32_t)
+	{
+		if(field)
+			writer.Write(*field);
+		else
+			writer.Null();
+	}
+};
+
+template<class T>
+struct FieldTraits<std::vector<T>>
+{
+	static void String(void *, const char *, size_t) {}
+	static void Number(void *, uint64_t) {}
+	static void Null(void *) {}
+	static bool Open(void *field, Type type, BindReader &reader);
+
+	static bool IsSet(const std::vector<T> &) { return true; }
+	static void Write(Writer &writer, const std::vector<T> &field, uint32_t flags)
+	{
+		writer.StartArray();
+		for(auto &item : field)
+			FieldTraits<T>::Write(writer, item, flags);
+		writer.EndArray();
+	}
+
+	// Adds an element for the next value in the array to go into
+	static Slot Append(void *field)
+	{
+		auto &array = *static_cast<std::vector<T> *>(field);
+		array.emplace_back();
+		return MakeSlot(array.back());
+	}
+};
+
+template<class T>
+struct FieldTraits<Optional<T>>
+{
+	static void String(void *field, const char *data, size_t size) { Mark(field); FieldTraits<T>::String(&Get(field), data, size); }
+	static void Number(void *field, uint64_t value) { Mark(field); FieldTraits<T>::Number(&Get(field), value); }
+	static void Null(void *field) { Mark(field); FieldTraits<T>::Null(&Get(field)); }
+	static bool Open(void *field, Type type, BindReader &reader) { Mark(field); return FieldTraits<T>::Open(&Get(field), type, reader); }
+
+	static bool IsSet(const Optional<T> &field) { return field.has; }
+	static void Write(Writer &writer, const Optional<T> &field, uint32_t flags) { FieldTraits<T>::Write(writer, field.value, flags); }
+
+private:
+	static void Mark(void *field) { static_cast<Optional<T> *>(field)->has = true; }
+	static T &Get(void *field) { return static_cast<Optional<T> *>(field)->value; }
+};
+
+template<class T>
+Slot MakeSlot(T &field)
+{
+	static const SlotFunctions functions =
+	{
+		&FieldTraits<T>::String,
+		&FieldTraits<T>::Number,
+		&FieldTraits<T>::Null,
+		&FieldTraits<T>::Open,
+	};
+
+	Slot slot = { &field, &functions };
+	return slot;
+}
+
+/**
+ * BoundObject - The reading code generated for a bound struct. Matching a key
+ * runs down the members comparing hashes, which for literal keys are
+ * constants, so there's no table to look anything up in
+ */
+template<class T>
+struct BoundObject
+{
+	struct FindVisitor
+	{
+		const Key &key;
+		Slot &slot;
+		uint32_t &index;
+		uint32_t position;
+		bool found;
+
+		template<class M>
+		void operator () (const Key &fieldKey, M &member, uint32_t = 0)
+		{
+			if(!found && fieldKey == key)
+			{
+				slot = MakeSlot(member);
+				index = position;
+				found = true;
+			}
+
+			position++;
+		}
+	};
+
+	struct FinishVisitor
+	{
+		uint64_t seen;
+		uint32_t position;
+
+		template<class M>
+		void operator () (const Key &fieldKey, M &, uint32_t flags = 0)
+		{
+			if((flags & FIELD_REQUIRED) && position < 64 && !(seen & static_cast<uint64_t>(1) << position))
+				throw std::logic_error(std::string("Failed to find field ") + std::string(fieldKey.GetData(), fieldKey.GetSize()));
+
+			position++;
+		}
+	};
+
+	static bool Find(void *object, const Key &key, Slot &slot, uint32_t &index)
+	{
+		FindVisitor visitor = { key, slot, index, 0, false };
+		Binding<T>::Fields(visitor, *static_cast<T *>(object));
+		return visitor.found;
+	}
+
+	static void Finish(void *object, uint64_t seen)
+	{
+		FinishVisitor visitor = { seen, 0 };
+		Binding<T>::Fields(visitor, *static_cast<T *>(object));
+	}
+
+	static const ObjectFunctions *GetFunctions()
+	{
+		static const ObjectFunctions functions = { &Find, &Finish };
+		return &functions;
+	}
+};
+
+/**
+ * BindReader - A handler that reads json straight into a bound struct, or a
+ * member of any type FieldTraits knows. Members that aren't bound are skipped
+ * over without anything being built for them. It can be handed the events of
+ * just one value in a bigger document, IsComplete says when that value is done
+ */
+class BindReader : public Handler
+{
+public:
+	BindReader();
+
+	template<class T>
+	explicit BindReader(T &root)
+	{
+		Reset(root);
+	}
+
+	template<class T>
+	void Reset(T &root)
+	{
+		Reset(MakeSlot(root));
+	}
+
+	void Reset(const Slot &root);
+	bool IsComplete() const { return m_complete; }
+
+	void StartObject();
+	void Key(const char *data, size_t size);
+	void EndObject();
+	void StartArray();
+	void EndArray();
+	void String(const char *data, size_t size);
+	void Number(uint64_t value);
+	void Null();
+
+	// For FieldTraits, to start reading a container into a member
+	void PushObject(void *object, const ObjectFunctions *functions);
+	void PushArray(void *array, Slot (*append)(void *array));
+	void PushValue(ValuePtr *value, Type type);
+
+protected:
+	enum FrameKind
+	{
+		FRAME_OBJECT,
+		FRAME_ARRAY,
+		FRAME_VALUE,				// Everything under it goes to m_builder
+		FRAME_SKIP,
+	};
+
+	struct Frame
+	{
+		FrameKind kind;
+		void *target;
+		const ObjectFunctions *object;
+		Slot (*append)(void *array);
+		uint64_t seen;				// Bit for each member of an object that's been read
+		uint32_t depth;				// Containers open under a value or skip frame
+	};
+
+	bool TakeSlot(Slot &slot);
+	void Open(Type type);
+	void Close(bool isObject);
+	void Done();
+
+	std::vector<Frame> m_frames;
+	Slot m_slot;					// Where the next value goes, if m_hasSlot
+	bool m_hasSlot = false;
+	bool m_complete = false;
+
+	ValueBuilder m_builder;
+	ValuePtr *m_valueTarget = nullptr;
+};
+
+template<class T>
+bool FieldTraits<T>::Open(void *field, Type type, BindReader &reader)
+{
+	if(type != Type_Object)
+		return false;
+
+	// A repeated member is read from scratch, not over the one before it
+	*static_cast<T *>(field) = T();
+	reader.PushObject(field, BoundObject<T>::GetFunctions());
+	return true;
+}
+
+// Writes each member of a bound struct that's set
+struct WriteVisitor
+{
+	Writer &writer;
+
+	template<class M>
+	void operator () (const Key &key, const M &member, uint32_t flags = 0)
+	{
+		if(!FieldTraits<M>::IsSet(member))
+			return;
+
+		writer.Key(key.GetData(), key.GetSize());
+		FieldTraits<M>::Write(writer, member, flags);
+	}
+};
+
+template<class T>
+void FieldTraits<T>::Write(Writer &writer, const T &field, uint32_t)
+{
+	WriteVisitor visitor = { writer };
+	writer.StartObject();
+	Binding<T>::Fields(visitor, field);
+	writer.EndObject();
+}
+
+template<class T>
+bool FieldTraits<std::vector<T>>::Open(void *field, Type type, BindReader &reader)
+{
+	if(type != Type_Array)
+		return false;
+
+	static_cast<std::vector<T> *>(field)->clear();
+	reader.PushArray(field, &Append);
+	return true;
+}
+
+/**
+ * Read - Parses size bytes of json at data into value
+ */
+template<class T>
+void Read(const char *data, size_t size, T &value)
+{
+	BindReader binder(value);
+	Reader reader(binder);
+	reader.Feed(data, size);
+	reader.Finish();
+}
+
+/**
+ * Write - Writes value as json
+ */
+template<class T>
+void Write(Writer &writer, const T &value)
+{
+	FieldTraits<T>::Write(writer, value, 0);
+}
+
+	}
+}
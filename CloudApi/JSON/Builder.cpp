@@ -0,0 +1,115 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+Builder::Builder(Value &&value) :
+	m_value(std::move(value))
+{
+}
+
+Builder::Builder(Builder &&builder) :
+	m_value(std::move(builder.m_value))
+{
+}
+
+Builder & Builder::operator = (Builder &&builder)
+{
+	m_value = std::move(builder.m_value);
+	return *this;
+}
+
+Builder Builder::MakeObject()
+{
+	return Builder(Value(Object()));
+}
+
+Builder Builder::MakeArray()
+{
+	return Builder(Value(Array()));
+}
+
+Object &Builder::TargetObject()
+{
+	if(!m_value.IsObject())
+		throw std::logic_error("JSON builder isn't building an object");
+
+	return *m_value.GetObjectStorage();
+}
+
+Array &Builder::TargetArray()
+{
+	if(!m_value.IsArray())
+		throw std::logic_error("JSON builder isn't building an array");
+
+	return *m_value.GetArrayStorage();
+}
+
+Builder &Builder::Set(std::string key, ValuePtr value)
+{
+	TargetObject().Put(std::move(key), std::move(value));
+	return *this;
+}
+
+Builder &Builder::Set(std::string key, std::string value)
+{
+	return Set(std::move(key), std::make_shared<Value>(value.data(), value.size()));
+}
+
+Builder &Builder::Set(std::string key, uint64_t value)
+{
+	return Set(std::move(key), std::make_shared<Value>(value));
+}
+
+Builder &Builder::Set(std::string key, Builder &&builder)
+{
+	return Set(std::move(key), builder.Build());
+}
+
+Builder &Builder::Push(ValuePtr value)
+{
+	TargetArray().push_back(std::move(value));
+	return *this;
+}
+
+Builder &Builder::Push(std::string value)
+{
+	return Push(std::make_shared<Value>(value.data(), value.size()));
+}
+
+Builder &Builder::Push(uint64_t value)
+{
+	return Push(std::make_shared<Value>(value));
+}
+
+Builder &Builder::Push(Builder &&builder)
+{
+	return Push(builder.Build());
+}
+
+/**
+ * Reserve - Makes room for count more values in an array
+ */
+void Builder::Reserve(size_t count)
+{
+	auto &array = TargetArray();
+	array.reserve(array.size() + count);
+}
+
+/**
+ * Build - Moves the finished value out, the builder is left empty
+ */
+ValuePtr Builder::Build()
+{
+	return std::make_shared<Value>(std::move(m_value));
+}
+
+/**
+ * BuildObject - Moves the finished object out, the builder is left empty
+ */
+Object Builder::BuildObject()
+{
+	auto object = std::move(TargetObject());
+	m_value = Value();
+	return object;
+}
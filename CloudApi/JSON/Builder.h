@@ -0,0 +1,50 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * Builder - Puts together an object or an array, values are moved into the
+ * tree as they're added and the finished tree is moved out, so nothing is
+ * copied on the way. Builders can only be moved
+ */
+class Builder
+{
+public:
+	static Builder MakeObject();
+	static Builder MakeArray();
+
+	Builder(Builder &&builder);
+	Builder & operator = (Builder &&builder);
+
+	// Objects
+	Builder &Set(std::string key, ValuePtr value);
+	Builder &Set(std::string key, std::string value);
+	Builder &Set(std::string key, uint64_t value);
+	Builder &Set(std::string key, Builder &&builder);
+
+	// Arrays
+	Builder &Push(ValuePtr value);
+	Builder &Push(std::string value);
+	Builder &Push(uint64_t value);
+	Builder &Push(Builder &&builder);
+
+	void Reserve(size_t count);
+
+	ValuePtr Build();
+	Object BuildObject();
+
+private:
+	explicit Builder(Value &&value);
+
+	Builder(const Builder &);
+	Builder & operator = (const Builder &);
+
+	Object &TargetObject();
+	Array &TargetArray();
+
+	Value m_value;
+};
+
+	}
+}
@@ -0,0 +1,475 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * DocumentParser - Stage two for a Document, walks the structural index the
+ * same way Parser does but writes nodes to the arena. An array or object's
+ * children are gathered on a scratch stack while it's parsed and copied to
+ * the arena in one piece once it closes, so they end up next to each other
+ */
+class DocumentParser : public Parser
+{
+public:
+	DocumentParser(const char *data, size_t size, Arena &arena) :
+		Parser(data, size), m_arena(arena)
+	{
+	}
+
+	void ParseRoot(Node &root)
+	{
+		ParseNode(root, 0);
+
+		SkipWhitespace();
+		if(m_pos != m_size)
+			Fail();
+	}
+
+protected:
+	static void Fail()
+	{
+		throw std::logic_error("JSON Decode Failure");
+	}
+
+	void ParseNode(Node &node, uint32_t depth);
+	void ParseObject(Node &node, uint32_t depth);
+	void ParseArray(Node &node, uint32_t depth);
+	void ParseString(Node &node);
+	uint32_t HashKey(const Node &key);
+	Member *AllocateIndexed(uint32_t count, const uint32_t *hashes);
+
+	Arena &m_arena;
+	std::vector<Node> m_elements;
+	std::vector<Member> m_members;
+	std::vector<uint32_t> m_hashes;		// Hash of each member name on m_members
+};
+
+void DocumentParser::ParseNode(Node &node, uint32_t depth)
+{
+	if(depth > MAX_DEPTH)
+		throw std::logic_error("JSON Decode Failure: nested too deeply");
+
+	SkipWhitespace();
+	if(m_pos >= m_size)
+		Fail();
+
+	if(m_pos != NextStructural())
+	{
+		const char *begin, *end;
+		TakeScalar(begin, end);
+
+		Type type;
+		ReadScalar(begin, end, type, node.m_number);
+		node.m_type = static_cast<uint8_t>(type);
+		node.m_size = 0;
+		node.m_escaped = false;
+		return;
+	}
+
+	switch(m_data[m_pos])
+	{
+		case '{':
+			ParseObject(node, depth);
+			break;
+
+		case '[':
+			ParseArray(node, depth);
+			break;
+
+		case '"':
+			ParseString(node);
+			break;
+
+		default:
+			Fail();
+	}
+}
+
+void DocumentParser::ParseObject(Node &node, uint32_t depth)
+{
+	TakeStructural();
+
+	auto first = m_members.size();
+	if(AtStructural('}'))
+		TakeStructural();
+	else
+	{
+		while(true)
+		{
+			if(!AtStructural('"'))
+				Fail();
+
+			// The member is filled in on the stack, which may move while its value is parsed
+			Member member;
+			ParseString(member.key);
+
+			auto hash = HashKey(member.key);
+			member.key.m_hash = static_cast<uint16_t>(hash >> 16);
+
+			if(TakeStructural() != ':')
+				Fail();
+
+			ParseNode(member.value, depth + 1);
+			m_members.push_back(member);
+			m_hashes.push_back(hash);
+
+			auto chr = TakeStructural();
+			if(chr == '}')
+				break;
+			else if(chr != ',')
+				Fail();
+		}
+	}
+
+	auto count = static_cast<uint32_t>(m_members.size() - first);
+	auto members = count <= Node::SCAN_LIMIT ? m_arena.Allocate<Member>(count) : AllocateIndexed(count, &m_hashes[first]);
+	std::copy(m_members.begin() + first, m_members.end(), members);
+	m_members.resize(first);
+	m_hashes.resize(first);
+
+	node.m_members = members;
+	node.m_size = count;
+	node.m_type = Type_Object;
+	node.m_escaped = false;
+}
+
+void DocumentParser::ParseArray(Node &node, uint32_t depth)
+{
+	TakeStructural();
+
+	auto first = m_elements.size();
+	if(AtStructural(']'))
+		TakeStructural();
+	else
+	{
+		while(true)
+		{
+			Node element;
+			ParseNode(element, depth + 1);
+			m_elements.push_back(element);
+
+			auto chr = TakeStructural();
+			if(chr == ']')
+				break;
+			else if(chr != ',')
+				Fail();
+		}
+	}
+
+	auto count = m_elements.size() - first;
+	auto elements = m_arena.Allocate<Node>(count);
+	std::copy(m_elements.begin() + first, m_elements.end(), elements);
+	m_elements.resize(first);
+
+	node.m_elements = elements;
+	node.m_size = static_cast<uint32_t>(count);
+	node.m_type = Type_Array;
+	node.m_escaped = false;
+}
+
+/**
+ * ParseString - Points the node at the string's contents in the input, stage
+ * one has already checked them so escapes are left for whoever reads it
+ */
+void DocumentParser::ParseString(Node &node)
+{
+	const char *begin, *end;
+	TakeString(begin, end);
+
+	node.m_chars = begin;
+	node.m_size = static_cast<uint32_t>(end - begin);
+	node.m_type = Type_String;
+	node.m_escaped = memchr(begin, '\\', end - begin) != nullptr;
+}
+
+/**
+ * HashKey - Hashes a member name as Key would, decoded if it has escapes
+ */
+uint32_t DocumentParser::HashKey(const Node &key)
+{
+	if(!key.m_escaped)
+		return Key::Hash(key.m_chars, key.m_size);
+
+	auto str = key.AsString();
+	return Key::Hash(str.data(), str.size());
+}
+
+/**
+ * AllocateIndexed - Allocates count members with an index after them, which
+ * the members are put in last first, so a probe meets the last of a repeated
+ * member before the others
+ */
+Member *DocumentParser::AllocateIndexed(uint32_t count, const uint32_t *hashes)
+{
+	auto indexSize = Node::GetIndexSize(count);
+	auto members = static_cast<Member *>(m_arena.Allocate(count * sizeof(Member) + indexSize * sizeof(uint32_t)));
+
+	auto index = reinterpret_cast<uint32_t *>(members + count);
+	memset(index, 0, indexSize * sizeof(uint32_t));
+
+	auto mask = indexSize - 1;
+	for(auto position = count; position-- > 0;)
+	{
+		auto slot = hashes[position] & mask;
+		while(index[slot])
+			slot = (slot + 1) & mask;
+
+		index[slot] = position + 1;
+	}
+
+	return members;
+}
+
+	}
+}
+
+/**
+ * Document - Parses buffer, which the document holds on to as its strings
+ * point into it. Throws std::logic_error if it isn't valid json
+ */
+Document::Document(Data buffer) :
+	m_buffer(std::move(buffer)), m_arena(std::max<size_t>(m_buffer.Size(), 4096))
+{
+	// Read through a const reference, a non const Cast would give a shared
+	// block a copy of its own
+	auto &reply = static_cast<const Data &>(m_buffer);
+	DocumentParser(reply.Cast<char>(), reply.Size(), m_arena).ParseRoot(m_root);
+}
+
+/**
+ * AsString - Returns the string, decoding its escapes if it has any
+ */
+std::string Node::AsString() const
+{
+	if(!IsString())
+		return std::string();
+
+	std::string str;
+	if(m_escaped)
+		Parser::Unescape(m_chars, m_chars + m_size, str);
+	else
+		str.assign(m_chars, m_size);
+
+	return str;
+}
+
+/**
+ * Equals - Returns true if this is the string of size bytes at str, strings
+ * without escapes are compared where they are
+ */
+bool Node::Equals(const char *str, size_t size) const
+{
+	if(!IsString())
+		return false;
+	else if(m_escaped)
+		return AsString() == std::string(str, size);
+
+	return m_size == size && memcmp(m_chars, str, size) == 0;
+}
+
+const Member &Node::GetMember(uint32_t index) const
+{
+	if(!IsObject() || index >= m_size)
+		throw std::logic_error("JSON member index out of range");
+
+	return m_members[index];
+}
+
+/**
+ * Find - Returns the value of the member named key, or nullptr if there isn't
+ * one or this isn't an object. Small objects are scanned from the end comparing
+ * the kept bits of each name's hash, bigger ones probe their index. Either way
+ * the last of a repeated member is found, as in a Value tree
+ */
+const Node *Node::Find(const Key &key) const
+{
+	if(!IsObject())
+		return nullptr;
+
+	auto hash = key.GetHash();
+	auto tag = static_cast<uint16_t>(hash >> 16);
+	if(m_size <= SCAN_LIMIT)
+	{
+		for(auto i = m_size; i-- > 0;)
+		{
+			auto &member = m_members[i];
+			if(member.key.m_hash == tag && member.key.Equals(key.GetData(), key.GetSize()))
+				return &member.value;
+		}
+
+		return nullptr;
+	}
+
+	// The last of a repeated member went in first, so it's found first
+	auto index = reinterpret_cast<const uint32_t *>(m_members + m_size);
+	auto mask = GetIndexSize(m_size) - 1;
+	for(auto slot = hash & mask; index[slot]; slot = (slot + 1) & mask)
+	{
+		auto &member = m_members[index[slot] - 1];
+		if(member.key.m_hash == tag && member.key.Equals(key.GetData(), key.GetSize()))
+			return &member.value;
+	}
+
+	return nullptr;
+}
+
+/**
+ * GetIndexSize - Slots in the index of an object with memberCount members, it's
+ * kept at most half full
+ */
+uint32_t Node::GetIndexSize(uint32_t memberCount)
+{
+	uint32_t size = 16;
+	while(size < memberCount * 2)
+		size *= 2;
+
+	return size;
+}
+
+const Node &Node::At(const Key &key) const
+{
+	auto value = Find(key);
+	if(!value)
+		throw std::logic_error(std::string("Failed to find field ") + key.ToString());
+
+	return *value;
+}
+
+/**
+ * GetArrayView - The elements of the member named key, empty if it isn't an
+ * array. Throws if there's no such member
+ */
+Range<Node> Node::GetArrayView(const Key &key) const
+{
+	return At(key).GetElements();
+}
+
+Type Node::GetType(const Key &key) const
+{
+	auto value = Find(key);
+	return value ? value->GetType() : Type_Null;
+}
+
+/**
+ * ToValue - Copies the node and everything under it out to a Value tree that
+ * can outlive the document
+ */
+ValuePtr Node::ToValue() const
+{
+	switch(GetType())
+	{
+		case Type_String:
+		{
+			if(!m_escaped)
+				return std::make_shared<Value>(m_chars, m_size);
+
+			auto str = AsString();
+			return std::make_shared<Value>(str.data(), str.size());
+		}
+
+		case Type_Number:
+			return std::make_shared<Value>(m_number);
+
+		case Type_Array:
+		{
+			Array array;
+			array.reserve(m_size);
+			for(auto &element : *this)
+				array.push_back(element.ToValue());
+			return std::make_shared<Value>(std::move(array));
+		}
+
+		case Type_Object:
+		{
+			Object object;
+			for(uint32_t i = 0; i < m_size; i++)
+				object.Append(m_members[i].key.AsString(), m_members[i].value.ToValue());
+			object.Finish();
+			return std::make_shared<Value>(std::move(object));
+		}
+
+		default:
+			return std::make_shared<Value>();
+	}
+}
+
+namespace {
+
+/**
+ * ReadNumber - Reads a number node, or a string of digits in place when it has
+ * no escapes to decode. Returns false for anything else
+ */
+bool ReadNumber(const Node &value, uint64_t &number)
+{
+	if(value.IsNumber())
+	{
+		number = value.AsNumber();
+		return true;
+	}
+	else if(!value.IsString())
+		return false;
+	else if(!value.IsEscaped())
+		return ParseDigits(value.GetStringData(), value.GetStringSize(), number);
+
+	auto str = value.AsString();
+	return ParseDigits(str.data(), str.size(), number);
+}
+
+}
+
+namespace Copy {
+	namespace JSON {
+
+template <>
+std::string Node::Get<std::string>(const Key &key) const
+{
+	return At(key).AsString();
+}
+
+template <>
+uint64_t Node::Get<uint64_t>(const Key &key) const
+{
+	auto &value = At(key);
+	if(!value.IsNumber() && !value.IsString())
+		throw std::logic_error(std::string("Field was not of type json=type Number of String ") + key.ToString());
+
+	uint64_t number;
+	if(!ReadNumber(value, number))
+		throw std::logic_error(std::string("Field was not a number ") + key.ToString());
+
+	return number;
+}
+
+template <>
+uint32_t Node::Get<uint32_t>(const Key &key) const
+{
+	return static_cast<uint32_t>(Get<uint64_t>(key));
+}
+
+template <>
+std::string Node::GetOpt<std::string>(const Key &key, const std::string &defaultValue) const
+{
+	auto value = Find(key);
+	return value ? value->AsString() : defaultValue;
+}
+
+template <>
+uint64_t Node::GetOpt<uint64_t>(const Key &key, const uint64_t &defaultValue) const
+{
+	uint64_t number;
+	auto value = Find(key);
+	return value && ReadNumber(*value, number) ? number : defaultValue;
+}
+
+template <>
+uint32_t Node::GetOpt<uint32_t>(const Key &key, const uint32_t &defaultValue) const
+{
+	return static_cast<uint32_t>(GetOpt<uint64_t>(key, defaultValue));
+}
+
+	}
+}
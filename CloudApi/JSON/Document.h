@@ -0,0 +1,145 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+struct Member;
+class DocumentParser;
+
+/**
+ * Range - A run of nodes or members next to each other in a document's arena,
+ * for range for to walk without copying anything
+ */
+template<class T>
+class Range
+{
+public:
+	Range() : m_begin(nullptr), m_end(nullptr) {}
+	Range(const T *begin, const T *end) : m_begin(begin), m_end(end) {}
+
+	const T *begin() const { return m_begin; }
+	const T *end() const { return m_end; }
+	uint32_t Size() const { return static_cast<uint32_t>(m_end - m_begin); }
+	bool IsEmpty() const { return m_begin == m_end; }
+
+private:
+	const T *m_begin;
+	const T *m_end;
+};
+
+/**
+ * Node - A value in a Document, 16 bytes in the document's arena. Strings are
+ * where they sit in the input and escapes are only decoded when the string is
+ * read, arrays and objects point at their elements and members, which sit
+ * next to each other in the arena. A member name keeps 16 bits of its hash,
+ * and an object with more than SCAN_LIMIT members has an open addressing
+ * index straight after its members, so finding a member is one probe
+ */
+class Node
+{
+public:
+	friend class DocumentParser;
+
+	Type GetType() const { return static_cast<Type>(m_type); }
+	bool IsNull() const { return m_type == Type_Null; }
+	bool IsString() const { return m_type == Type_String; }
+	bool IsNumber() const { return m_type == Type_Number; }
+	bool IsArray() const { return m_type == Type_Array; }
+	bool IsObject() const { return m_type == Type_Object; }
+
+	uint64_t AsNumber() const { return IsNumber() ? m_number : 0; }
+	std::string AsString() const;
+	bool Equals(const char *str, size_t size) const;
+
+	// A string as it sits in the input, which is only what it says when it isn't escaped
+	const char *GetStringData() const { return IsString() ? m_chars : nullptr; }
+	uint32_t GetStringSize() const { return IsString() ? m_size : 0; }
+	bool IsEscaped() const { return IsString() && m_escaped; }
+
+	// Elements of an array, members of an object
+	uint32_t Size() const { return IsArray() || IsObject() ? m_size : 0; }
+	const Node *begin() const { return IsArray() ? m_elements : nullptr; }
+	const Node *end() const { return IsArray() ? m_elements + m_size : nullptr; }
+	const Member &GetMember(uint32_t index) const;
+	Range<Node> GetElements() const { return Range<Node>(begin(), end()); }
+	inline Range<Member> GetMembers() const;
+	Range<Node> GetArrayView(const Key &key) const;
+
+	const Node *Find(const Key &key) const;
+	const Node &At(const Key &key) const;
+
+	template <class T>
+	T Get(const Key &key) const;
+
+	template <class T>
+	T GetOpt(const Key &key, const T &defaultValue) const;
+
+	Type GetType(const Key &key) const;
+	bool Has(const Key &key) const { return Find(key) != nullptr; }
+
+	ValuePtr ToValue() const;
+
+	static const uint32_t SCAN_LIMIT = 8;		// Members that are searched without an index
+	static uint32_t GetIndexSize(uint32_t memberCount);
+
+private:
+	union
+	{
+		uint64_t m_number;
+		const char *m_chars;
+		const Node *m_elements;
+		const Member *m_members;
+	};
+	uint32_t m_size;				// String length in bytes, element or member count
+	uint8_t m_type;
+	bool m_escaped;					// The string has escapes to decode
+	uint16_t m_hash;				// Top of a member name's hash
+};
+
+struct Member
+{
+	Node key;
+	Node value;
+};
+
+/**
+ * GetMembers - An object's members, empty if this isn't an object
+ */
+inline Range<Member> Node::GetMembers() const
+{
+	return IsObject() ? Range<Member>(m_members, m_members + m_size) : Range<Member>();
+}
+
+/**
+ * Document - A parsed reply that owns everything it's made of, the reply's
+ * buffer and an arena holding every node. Nothing is allocated per value and
+ * it's all freed at once with the document
+ */
+class Document
+{
+public:
+	explicit Document(Data buffer);
+
+	const Node &GetRoot() const { return m_root; }
+	size_t GetArenaSize() const { return m_arena.GetSize(); }
+
+protected:
+	Document(const Document &);
+	Document & operator = (const Document &);
+
+	Data m_buffer;
+	Arena m_arena;
+	Node m_root;
+};
+
+typedef std::shared_ptr<Document> DocumentPtr;
+
+template <> std::string Node::Get<std::string>(const Key &key) const;
+template <> uint64_t Node::Get<uint64_t>(const Key &key) const;
+template <> uint32_t Node::Get<uint32_t>(const Key &key) const;
+template <> std::string Node::GetOpt<std::string>(const Key &key, const std::string &defaultValue) const;
+template <> uint64_t Node::GetOpt<uint64_t>(const Key &key, const uint64_t &defaultValue) const;
+template <> uint32_t Node::GetOpt<uint32_t>(const Key &key, const uint32_t &defaultValue) const;
+
+	}
+}
@@ -24,6 +24,33 @@
 
 #include "Common.h"
 
+namespace {
+
+/**
+ * ParseHex4 - Reads the 4 hex digits of a \u escape, the nul ending the
+ * input isn't one so nothing past it is read
+ */
+bool ParseHex4(const char *data, uint32_t &codepoint)
+{
+	codepoint = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		codepoint <<= 4;
+		if(data[i] >= '0' && data[i] <= '9')
+			codepoint |= data[i] - '0';
+		else if(data[i] >= 'A' && data[i] <= 'F')
+			codepoint |= 10 + (data[i] - 'A');
+		else if(data[i] >= 'a' && data[i] <= 'f')
+			codepoint |= 10 + (data[i] - 'a');
+		else
+			return false;
+	}
+
+	return true;
+}
+
+}
+
 namespace Copy {
 	namespace JSON {
 
@@ -40,138 +67,83 @@ bool SkipWhitespace(const char **data)
 
 /** 
  * Extracts a JSON String as defined by the spec - "<some chars>"
- * Any escaped characters are swapped out for their unescaped values
+ * Any escaped characters are swapped out for their unescaped values. Runs of
+ * plain characters are copied whole and an escape only looks at its own chars
  */
 bool ExtractString(const char **data, std::string &str)
 {
-	str = "";
-	
-	while(**data != 0)
+	str.clear();
+
+	auto pos = *data;
+	for(;;)
 	{
-		// Save the char so we can change it if need be
-		char next_char = **data;
-		
-		// Escaping something?
-		if(next_char == '\\')
-		{
-			// Move over the escape char
-			*data = U8::NextChar(*data);
-			
-			// Deal with the escaped char
-			switch (**data)
-			{
-				case '"': next_char = '"'; break;
-				case '\\': next_char = '\\'; break;
-				case '/': next_char = '/'; break;
-				case 'b': next_char = '\b'; break;
-				case 'f': next_char = '\f'; break;
-				case 'n': next_char = '\n'; break;
-				case 'r': next_char = '\r'; break;
-				case 't': next_char = '\t'; break;
-				case 'u':
-				{
-					// We need 5 chars (4 hex + the 'u') or its not valid
-					if(U8::StringLength(*data) < 5)
-						return false;
-					
-					// Parse the hex digits into integer codepoint
-					uint32_t codepoint = 0;
-					for(int i = 0; i < 4; i++)
-					{
-						// Do it first to move off the 'u' and leave us on the 
-						// final hex digit as we move on by one later on
-						(*data)++;
-						
-						codepoint <<= 4;
-						
-						// Parse the hex digit
-						if(**data >= '0' && **data <= '9')
-							codepoint |= (**data - '0');
-						else if(**data >= 'A' && **data <= 'F')
-							codepoint |= (10 + (**data - 'A'));
-						else if(**data >= 'a' && **data <= 'f')
-							codepoint |= (10 + (**data - 'a'));
-						else
-						{
-							// Invalid hex digit = invalid JSON
-							return false;
-						}
-					}
+		// Everything up to a quote, an escape or a control character goes as it
+		// is. SPEC Violation: Allow tabs due to real world cases
+		auto run = pos;
+		while(static_cast<uint8_t>(*run) >= ' ' ? *run != '"' && *run != '\\' : *run == '\t')
+			run++;
 
-					// Utf8 officially supports up to 4 bytes
-					uint32_t charlen;
-					uint8_t lenMarker;
-					if((codepoint & 0x0074) == codepoint) // Up to U+0074
-					{
-						charlen = 1;
-						lenMarker = 0; // 0xxxxxxx
-					}
-					else if((codepoint & 0x07FF) == codepoint) // Up to U+07FF
-					{
-						charlen = 2;
-						lenMarker = 0xC0; // 110xxxxx
-					}
-					else if((codepoint & 0xFFFF) == codepoint) // Up to U+FFFF
-					{
-						charlen = 3;
-						lenMarker = 0xE0; //1110xxxx
-					}
-					else if((codepoint & 0x10FFFF) == codepoint) // Up to U+10FFFF
-					{
-						charlen = 4;
-						lenMarker = 0xF0; // 11110xxx
-					}
-					else
-						return false;
+		if(!U8::IsValid(pos, run - pos))
+			return false;
 
-					// Figure out characters backwards
-					char utfChars[5] = {0};
-					for(int i = charlen - 1; i >= 0; i--)
-					{
-						if(i > 0)
-							utfChars[i] = (0x3F & codepoint) | 0x80; // Grab next 6 bits
-						else
-							utfChars[i] = static_cast<char>(codepoint | lenMarker);
-						codepoint >>= 6;
-					}
+		str.append(pos, run);
+		pos = run;
 
-					// Add all but last character to string
-					for(uint32_t i = 0; i < charlen - 1; i++)
-						str += utfChars[i];
-					next_char = utfChars[charlen - 1]; // End of the loop will add the last one
-					break;
-				}
-				
-				// By the spec, only the above cases are allowed
-				default:
-					return false;
-			}
-		}
-		
 		// End of the string?
-		else if(next_char == '"')
+		if(*pos == '"')
 		{
-			*data = U8::NextChar(*data);
-			str.reserve(); // Remove unused capacity
+			*data = pos + 1;
 			return true;
 		}
-		
-		// Disallowed char?
-		else if(next_char < ' ' && next_char != '\t')
-		{
-			// SPEC Violation: Allow tabs due to real world cases
+
+		// Disallowed char, or the string ended incorrectly?
+		if(*pos != '\\')
 			return false;
+
+		// Deal with the escaped char
+		pos += 2;
+		switch(pos[-1])
+		{
+			case '"': str += '"'; break;
+			case '\\': str += '\\'; break;
+			case '/': str += '/'; break;
+			case 'b': str += '\b'; break;
+			case 'f': str += '\f'; break;
+			case 'n': str += '\n'; break;
+			case 'r': str += '\r'; break;
+			case 't': str += '\t'; break;
+			case 'u':
+			{
+				uint32_t codepoint;
+				if(!ParseHex4(pos, codepoint))
+					return false;
+				pos += 4;
+
+				// Characters past the basic plane come as a surrogate pair, a
+				// surrogate on its own can't be utf8 so it becomes U+FFFD
+				uint32_t low;
+				if(codepoint >= 0xD800 && codepoint <= 0xDBFF)
+				{
+					if(pos[0] == '\\' && pos[1] == 'u' && ParseHex4(pos + 2, low) && low >= 0xDC00 && low <= 0xDFFF)
+					{
+						codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+						pos += 6;
+					}
+					else
+						codepoint = 0xFFFD;
+				}
+				else if(codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+					codepoint = 0xFFFD;
+
+				U8::Append(codepoint, str);
+				break;
+			}
+
+			// By the spec, only the above cases are allowed
+			default:
+				return false;
 		}
-		
-		// Add the next char
-		str += next_char;
-		
-		// Move on
-		*data = U8::NextChar(*data);
 	}
-	
-	// If we're here, the string ended incorrectly
-	return false;
 }
 
 /** 
@@ -185,13 +157,12 @@ bool ExtractString(const char **data, std::string &str)
  */
 uint64_t ParseInt(const char **data)
 {
+	auto end = *data;
+	while(*end >= '0' && *end <= '9')
+		end++;
+
 	uint64_t integer = 0;
-	while (**data != 0 && **data >= '0' && **data <= '9')
-	{
-		integer = integer * 10 + (*(*data) - '0');
-		*data = U8::NextChar(*data);
-	}
-	
+	*data = ReadDigits(*data, end, integer);
 	return integer;
 }
 
@@ -206,17 +177,16 @@ uint64_t ParseInt(const char **data)
  */
 double ParseDecimal(const char **data)
 {
-	double decimal = 0.0;
-	double factor = 0.1;
+	auto begin = *data;
+	while(**data >= '0' && **data <= '9')
+		(*data)++;
 
-	while (**data != 0 && **data >= '0' && **data <= '9')
-	{
-		int digit = (*(*data) - '0');
-		decimal = decimal + digit * factor;
-		factor *= 0.1;
-		*data = U8::NextChar(*data);
-	}
+	// Read as the fraction it is rather than adding up tenths
+	std::string text("0.");
+	text.append(begin, *data);
 
+	double decimal = 0.0;
+	ParseDouble(text.data(), text.size(), decimal);
 	return decimal;
 }
 
@@ -228,21 +198,15 @@ double ParseDecimal(const char **data)
  */
 Copy::JSON::ValuePtr Copy::JSON::Parse(const char *data)
 {
-	// Skip any preceding whitespace, end of data = no JSON = fail
-	if(!SkipWhitespace(&data))
-		throw std::logic_error("JSON Decode Failure");
-
-	// We need the start of a value here now...
-	auto value = Value::Parse(&data);
-	if(!value)
-		throw std::logic_error("JSON Decode Failure");
-	
-	// Can be white space now and should be at the end of the string then...
-	if(SkipWhitespace(&data))
-		throw std::logic_error("JSON Decode Failure");
+	return Parse(data, strlen(data));
+}
 
-	// We're now at the end of the string
-	return value;
+/**
+ * Parses size bytes of JSON, which needn't be null terminated
+ */
+Copy::JSON::ValuePtr Copy::JSON::Parse(const char *data, size_t size)
+{
+	return Parser(data, size).Parse();
 }
 
 /**
@@ -38,14 +38,24 @@ typedef std::vector<ValuePtr> Array;
 	}
 }
 
+#include "JSON/Key.h"
+#include "JSON/Number.h"
 #include "JSON/Object.h"
 #include "JSON/Value.h"
+#include "JSON/Builder.h"
 #include "JSON/JSONRPC.h"
+#include "JSON/StructuralIndex.h"
+#include "JSON/Parser.h"
+#include "JSON/Document.h"
+#include "JSON/Reader.h"
+#include "JSON/Writer.h"
+#include "JSON/Binding.h"
 
 namespace Copy{
 	namespace JSON {
 
 ValuePtr Parse(const char *data);
+ValuePtr Parse(const char *data, size_t size);
 std::string Stringify(const Value *value);
 bool ExtractString(const char **data, std::string &str);
 bool SkipWhitespace(const char **data);
@@ -0,0 +1,66 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * Key - A member name and its 32 bit FNV-1a hash. Made from a string literal
+ * the hash is worked out at compile time, so matching a key read from json
+ * against it is an integer compare before the bytes are looked at
+ */
+class Key
+{
+public:
+	template<size_t N>
+	CONSTEXPR Key(const char (&literal)[N]) :
+		m_data(literal), m_size(N - 1), m_hash(HashLiteral(literal, N - 1, FNV_BASIS))
+	{
+	}
+
+	Key(const char *data, size_t size) :
+		m_data(data), m_size(size), m_hash(Hash(data, size))
+	{
+	}
+
+	Key(const std::string &str) :
+		m_data(str.data()), m_size(str.size()), m_hash(Hash(str.data(), str.size()))
+	{
+	}
+
+	CONSTEXPR const char *GetData() const { return m_data; }
+	CONSTEXPR size_t GetSize() const { return m_size; }
+	CONSTEXPR uint32_t GetHash() const { return m_hash; }
+	std::string ToString() const { return std::string(m_data, m_size); }
+
+	bool operator == (const Key &key) const
+	{
+		return m_hash == key.m_hash && m_size == key.m_size && memcmp(m_data, key.m_data, m_size) == 0;
+	}
+
+	bool operator != (const Key &key) const { return !(*this == key); }
+
+	static uint32_t Hash(const char *data, size_t size)
+	{
+		auto hash = FNV_BASIS;
+		for(size_t i = 0; i < size; i++)
+			hash = (hash ^ static_cast<uint8_t>(data[i])) * FNV_PRIME;
+		return hash;
+	}
+
+private:
+	static const uint32_t FNV_BASIS = 2166136261u;
+	static const uint32_t FNV_PRIME = 16777619u;
+
+	// Hash as one expression so it can be constexpr in C++11, literals are short
+	static CONSTEXPR uint32_t HashLiteral(const char *data, size_t size, uint32_t hash)
+	{
+		return size ? HashLiteral(data + 1, size - 1, (hash ^ static_cast<uint8_t>(*data)) * FNV_PRIME) : hash;
+	}
+
+	const char *m_data;
+	size_t m_size;
+	uint32_t m_hash;
+};
+
+	}
+}
@@ -0,0 +1,215 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+namespace {
+
+const uint64_t s_ones = 0x0101010101010101ull;
+
+const uint64_t s_powers[] =
+{
+	1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+// Every power of ten a double holds exactly
+const double s_exactPowers[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+bool IsSpace(char chr)
+{
+	return chr == ' ' || (chr >= '\t' && chr <= '\r');
+}
+
+/**
+ * CountDigits - How many of the characters in chunk are digits before the
+ * first that isn't, the first character is in the low byte. A byte is a digit
+ * when its high nibble is 3 and adding 6 leaves it there
+ */
+inline uint32_t CountDigits(uint64_t chunk)
+{
+	auto high = 0xF0 * s_ones;
+	auto nonDigits = ((chunk & high) ^ 0x30 * s_ones) | (((chunk + 0x06 * s_ones) & high) ^ 0x30 * s_ones);
+	return nonDigits ? CountTrailingZeros(nonDigits) / 8 : 8;
+}
+
+/**
+ * ParseEightDigits - The value of 8 digit characters, the first in the low
+ * byte. Each step joins neighbouring pairs of values into one
+ */
+inline uint32_t ParseEightDigits(uint64_t chunk)
+{
+	chunk = (chunk & 0x0F * s_ones) * (10 << 8 | 1) >> 8;
+	chunk = (chunk & 0x00FF00FF00FF00FFull) * (100 << 16 | 1) >> 16;
+	return static_cast<uint32_t>((chunk & 0x0000FFFF0000FFFFull) * (10000ull << 32 | 1) >> 32);
+}
+
+}
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * ReadDigits - Reads the digits at data onto the end of number, which wraps
+ * past 64 bits. Returns where the digits stop
+ */
+const char *ReadDigits(const char *data, const char *end, uint64_t &number)
+{
+	auto start = data;
+	while(end - data >= 8)
+	{
+		uint64_t chunk;
+		memcpy(&chunk, data, sizeof(chunk));
+		chunk = LE64_CPU(chunk);
+
+		auto digits = CountDigits(chunk);
+		if(digits == 8)
+		{
+			number = number * s_powers[8] + ParseEightDigits(chunk);
+			data += 8;
+			continue;
+		}
+
+		// The digits are moved up behind leading zeros
+		if(digits)
+			number = number * s_powers[digits] + ParseEightDigits(chunk << (64 - 8 * digits) | (0x30 * s_ones) >> (8 * digits));
+
+		return data + digits;
+	}
+
+	if(data == end)
+		return data;
+
+	// Too few left for a whole chunk, when the run started far enough back the
+	// last 8 bytes are read instead and the ones already used shifted out
+	auto left = static_cast<uint32_t>(end - data);
+	if(data - start < 8)
+	{
+		for(; data < end && IsDigit(*data); data++)
+			number = number * 10 + (*data - '0');
+
+		return data;
+	}
+
+	uint64_t chunk;
+	memcpy(&chunk, end - 8, sizeof(chunk));
+	chunk = LE64_CPU(chunk) >> (64 - 8 * left);
+
+	auto digits = CountDigits(chunk);
+	if(digits)
+		number = number * s_powers[digits] + ParseEightDigits(chunk << (64 - 8 * digits) | (0x30 * s_ones) >> (8 * digits));
+
+	return data + digits;
+}
+
+/**
+ * ParseDigits - Reads a number from a string the way std::stoull does, without
+ * copying the string first
+ * Returns false where stoull would throw
+ */
+bool ParseDigits(const char *data, size_t size, uint64_t &number)
+{
+	auto end = data + size;
+	while(data < end && IsSpace(*data))
+		data++;
+
+	auto neg = data < end && *data == '-';
+	if(data < end && (*data == '-' || *data == '+'))
+		data++;
+
+	if(data == end || !IsDigit(*data))
+		return false;
+
+	// 19 digits can't overflow, any past that are checked one at a time
+	uint64_t value = 0;
+	auto safe = static_cast<size_t>(end - data) < 19 ? end : data + 19;
+	data = ReadDigits(data, safe, value);
+	for(; data < end && IsDigit(*data); data++)
+	{
+		uint64_t digit = *data - '0';
+		if(value > (std::numeric_limits<uint64_t>::max() - digit) / 10)
+			return false;
+
+		value = value * 10 + digit;
+	}
+
+	// Negatives wrap, as they do with stoull
+	number = neg ? 0 - value : value;
+	return true;
+}
+
+/**
+ * ParseDouble - Reads a number from a string the way std::stod does. A plain
+ * decimal of up to 19 digits whose digits and power of ten are both exact as
+ * doubles is one correctly rounded multiply or divide (Clinger's fast path),
+ * anything else is left to strtod
+ * Returns false where stod would throw
+ */
+bool ParseDouble(const char *data, size_t size, double &number)
+{
+	auto begin = data, end = data + size;
+	while(data < end && IsSpace(*data))
+		data++;
+
+	auto neg = data < end && *data == '-';
+	if(data < end && (*data == '-' || *data == '+'))
+		data++;
+
+	uint64_t mantissa = 0;
+	auto digits = data;
+	data = ReadDigits(data, end, mantissa);
+	auto count = data - digits;
+
+	// Hex is left to strtod
+	if(data < end && (*data == 'x' || *data == 'X'))
+		count = 0;
+
+	int64_t exponent = 0;
+	if(data < end && *data == '.')
+	{
+		auto fraction = ++data;
+		data = ReadDigits(data, end, mantissa);
+		exponent = fraction - data;
+		count += data - fraction;
+	}
+
+	// An e without digits after it isn't part of the number
+	if(count && data < end && (*data == 'e' || *data == 'E'))
+	{
+		auto mark = data + 1;
+		auto negExponent = mark < end && *mark == '-';
+		if(mark < end && (*mark == '-' || *mark == '+'))
+			mark++;
+
+		uint64_t value = 0;
+		auto stop = ReadDigits(mark, end - mark > 4 ? mark + 4 : end, value);
+		if(stop != mark && (stop == end || !IsDigit(*stop)))
+			exponent += negExponent ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+		else if(stop != mark)
+			count = 0;
+	}
+
+	if(count && count <= 19 && mantissa <= static_cast<uint64_t>(1) << 53 && exponent >= -22 && exponent <= 22)
+	{
+		auto value = static_cast<double>(mantissa);
+		value = exponent < 0 ? value / s_exactPowers[-exponent] : value * s_exactPowers[exponent];
+		number = neg ? -value : value;
+		return true;
+	}
+
+	std::string text(begin, end);
+	char *stop;
+	errno = 0;
+	auto value = strtod(text.c_str(), &stop);
+	if(stop == text.c_str() || errno == ERANGE)
+		return false;
+
+	number = value;
+	return true;
+}
+
+	}
+}
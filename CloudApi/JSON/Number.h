@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * Number parsing shared by the parsers, the typed getters and bound structs.
+ * Runs of digits are read 8 at a time, one multiply per step folds the 8
+ * characters of a 64 bit word into their value
+ */
+const char *ReadDigits(const char *data, const char *end, uint64_t &number);
+bool ParseDigits(const char *data, size_t size, uint64_t &number);
+bool ParseDouble(const char *data, size_t size, double &number);
+
+	}
+}
@@ -5,17 +5,18 @@ using namespace Copy::JSON;
 
 Object::operator std::string()
 {
-	// Convert us to a value then stringify
-	return Value::Create(*this)->Stringify();
+	Writer writer;
+	writer.Write(*this);
+	return writer.Take();
 }
 
 void Object::IterateObjects(ValuePtr value, IterateObjectCallback callback)
 {
 	if(value->IsArray())
 	{
-		for(auto &item : value->m_array)
+		for(auto &item : *value->GetArrayStorage())
 		{
-			switch(item->m_type)
+			switch(item->GetType())
 			{
 				case Type_Object:
 				case Type_Array:
@@ -26,38 +27,193 @@ void Object::IterateObjects(ValuePtr value, IterateObjectCallback callback)
 	}
 	else if(value->IsObject())
 	{
-		callback(value->m_object);
-		auto iter = value->m_object.m_fields.begin();
-		for(auto iter = value->m_object.m_fields.begin(); iter != value->m_object.m_fields.end(); iter++)
+		auto &object = *value->GetObjectStorage();
+		callback(object);
+		for(auto &field : object.m_fields)
 		{
-			switch(iter->second->m_type)
+			switch(field.value->GetType())
 			{
 				case Type_Object:
 				case Type_Array:
-					IterateObjects(iter->second, callback);
+					IterateObjects(field.value, callback);
 					break;
 			}
 		}
 	}
 }
 
-ValuePtr Object::FindOpt(const std::string &key) const
+ValuePtr Object::FindOpt(const Key &key) const
 {
-	auto iter = m_fields.find(key);
-	if(iter == m_fields.end())
+	auto field = FindField(key);
+	if(!field)
 		return ValuePtr();
-	return iter->second;
+	return field->value;
 }
 
-ValuePtr Object::Find(const std::string &key) const
+ValuePtr Object::Find(const Key &key) const
 {
-	auto iter = m_fields.find(key);
-	if(iter == m_fields.end())
-		throw std::logic_error(std::string("Failed to find field ") + key);
-	return iter->second;
+	auto field = FindField(key);
+	if(!field)
+		throw std::logic_error(std::string("Failed to find field ") + key.ToString());
+	return field->value;
 }
 
-void Object::Put(const std::string &key, const ValuePtr &value)
+/**
+ * FindField - Returns the member named key or nullptr, small objects are
+ * scanned comparing hashes and bigger ones probe the index
+ */
+const Object::Field *Object::FindField(const Key &key) const
 {
-	m_fields[key] = value;
+	auto hash = key.GetHash();
+	if(m_index.empty())
+	{
+		for(auto &field : m_fields)
+		{
+			if(field.hash == hash && field.key.size() == key.GetSize() && memcmp(field.key.data(), key.GetData(), key.GetSize()) == 0)
+				return &field;
+		}
+
+		return nullptr;
+	}
+
+	auto mask = static_cast<uint32_t>(m_index.size() - 1);
+	for(auto slot = hash & mask; m_index[slot]; slot = (slot + 1) & mask)
+	{
+		auto &field = m_fields[m_index[slot] - 1];
+		if(field.hash == hash && field.key.size() == key.GetSize() && memcmp(field.key.data(), key.GetData(), key.GetSize()) == 0)
+			return &field;
+	}
+
+	return nullptr;
+}
+
+/**
+ * Put - Sets the member named key, replacing it if it's already there
+ */
+void Object::Put(std::string key, ValuePtr value)
+{
+	Key lookup(key);
+	auto existing = FindField(lookup);
+	if(existing)
+	{
+		m_fields[existing - m_fields.data()].value = std::move(value);
+		return;
+	}
+
+	Field field = { std::move(key), std::move(value), lookup.GetHash() };
+
+	// Members mostly come in order, so the end is tried before searching
+	if(m_fields.empty() || m_fields.back().key < field.key)
+	{
+		m_fields.push_back(std::move(field));
+		if(m_index.empty() && m_fields.size() > SCAN_LIMIT)
+			BuildIndex();
+		else if(!m_index.empty())
+			AddToIndex(static_cast<uint32_t>(m_fields.size() - 1));
+		return;
+	}
+
+	auto pos = std::lower_bound(m_fields.begin(), m_fields.end(), field,
+		[](const Field &left, const Field &right) { return left.key < right.key; });
+	m_fields.insert(pos, std::move(field));
+
+	// Everything after the new member moved along
+	if(m_fields.size() > SCAN_LIMIT)
+		BuildIndex();
+}
+
+/**
+ * Append - Adds a member to the end without looking for its name or keeping
+ * the order, nothing can be looked up until Finish has been called
+ */
+void Object::Append(std::string key, ValuePtr value)
+{
+	auto hash = Key::Hash(key.data(), key.size());
+	Field field = { std::move(key), std::move(value), hash };
+	m_fields.push_back(std::move(field));
+}
+
+/**
+ * Finish - Sorts the members Append added into name order and indexes them,
+ * of a name given more than once the last value is kept as Put would have
+ */
+void Object::Finish()
+{
+	auto byName = [](const Field &left, const Field &right) { return left.key < right.key; };
+
+	// Members mostly come in order, in which case there's nothing to do
+	auto unsorted = std::adjacent_find(m_fields.begin(), m_fields.end(),
+		[](const Field &left, const Field &right) { return !(left.key < right.key); });
+	if(unsorted != m_fields.end())
+	{
+		std::stable_sort(m_fields.begin(), m_fields.end(), byName);
+
+		// Repeats sit together in the order they came, keep the last of each
+		auto kept = m_fields.begin();
+		for(auto field = m_fields.begin(); field != m_fields.end(); ++field)
+		{
+			if(field + 1 != m_fields.end() && field->key == (field + 1)->key)
+				continue;
+
+			if(kept != field)
+				*kept = std::move(*field);
+			++kept;
+		}
+		m_fields.erase(kept, m_fields.end());
+	}
+
+	m_index.clear();
+	if(m_fields.size() > SCAN_LIMIT)
+		BuildIndex();
+}
+
+uint32_t Object::Erase(const Key &key)
+{
+	auto field = FindField(key);
+	if(!field)
+		return 0;
+
+	m_fields.erase(m_fields.begin() + (field - m_fields.data()));
+	if(m_fields.size() > SCAN_LIMIT)
+		BuildIndex();
+	else
+		m_index.clear();
+
+	return 1;
+}
+
+/**
+ * AddToIndex - Puts the field at position into the index, which is kept at
+ * most half full
+ */
+void Object::AddToIndex(uint32_t position)
+{
+	if(m_fields.size() * 2 > m_index.size())
+		return BuildIndex();
+
+	auto mask = static_cast<uint32_t>(m_index.size() - 1);
+	auto slot = m_fields[position].hash & mask;
+	while(m_index[slot])
+		slot = (slot + 1) & mask;
+
+	m_index[slot] = position + 1;
+}
+
+void Object::BuildIndex()
+{
+	size_t size = 16;
+	while(size < m_fields.size() * 2)
+		size *= 2;
+
+	m_index.assign(size, 0);
+
+	auto mask = static_cast<uint32_t>(size - 1);
+	for(uint32_t position = 0; position < m_fields.size(); position++)
+	{
+		auto slot = m_fields[position].hash & mask;
+		while(m_index[slot])
+			slot = (slot + 1) & mask;
+
+		m_index[slot] = position + 1;
+	}
 }
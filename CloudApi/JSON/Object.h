@@ -29,10 +29,25 @@ namespace Copy {
 
 class Value;
 
+/**
+ * Object - Members sit in one flat array sorted by name, which is the order
+ * they're written in, each with its name's hash so a lookup compares integers
+ * before it compares strings. Past SCAN_LIMIT members an open addressing index
+ * over the array is kept as well and a lookup is one probe. Lookups take a Key,
+ * so a string literal's hash is worked out at compile time and nothing is
+ * allocated to look it up. Parsers Append members as they come and Finish the
+ * object once it closes, so members out of order are sorted once rather than
+ * inserted one by one
+ */
 class Object 
 {
 public:
 	friend class Value;
+	friend class Parser;
+	friend class Builder;
+	friend class ValueBuilder;
+	friend class Writer;
+	friend class Node;
 
 	Object();
 	Object(const std::string &jsonPayload);
@@ -42,14 +57,18 @@ public:
 	typedef std::function<void (Object &object)> IterateObjectCallback;
 
 	template <class T>
-	inline T Get(const std::string &key) const;
+	inline T Get(const Key &key) const;
 
 	template <class T>
-	inline T GetOpt(const std::string &key, const T &defaultValue) const;
+	inline T GetOpt(const Key &key, const T &defaultValue) const;
+
+	inline Type GetType(const Key &key) const;
 
-	inline Type GetType(const std::string &key) const;
+	inline bool Has(const Key &key) const;
 
-	inline bool Has(const std::string &key) const;
+	// A member's array or object where it is, rather than a copy
+	inline const Array &GetArrayView(const Key &key) const;
+	inline const Object &GetObjectRef(const Key &key) const;
 
 	template<class T>
 	ValuePtr Set(const std::string &key, const T &_value);
@@ -62,23 +81,41 @@ public:
 
 	uint32_t Size() const { return static_cast<uint32_t>(m_fields.size()); }
 	bool IsEmpty() const { return m_fields.empty(); }
-	void Clear() { m_fields.clear(); }
-	uint32_t Erase(const std::string &key) { return static_cast<uint32_t>(m_fields.erase(key)); }
+	void Clear() { m_fields.clear(); m_index.clear(); }
+	uint32_t Erase(const Key &key);
 
 	Object & operator = (const Object &object);
 	Object & operator = (Object &&object);
 
+	struct Field
+	{
+		std::string key;
+		ValuePtr value;
+		uint32_t hash;
+	};
+
+	// Walks the members in name order
+	std::vector<Field>::const_iterator begin() const { return m_fields.begin(); }
+	std::vector<Field>::const_iterator end() const { return m_fields.end(); }
+
 protected:
+	static const uint32_t SCAN_LIMIT = 8;		// Members that are searched without an index
 
-	ValuePtr Find(const std::string &key) const;
-	ValuePtr FindOpt(const std::string &key) const;
-	void Put(const std::string &key, const ValuePtr &value);
+	ValuePtr Find(const Key &key) const;
+	ValuePtr FindOpt(const Key &key) const;
+	const Field *FindField(const Key &key) const;
+	void Put(std::string key, ValuePtr value);
+	void Append(std::string key, ValuePtr value);
+	void Finish();
+	void AddToIndex(uint32_t position);
+	void BuildIndex();
 
 	static void IterateObjects(ValuePtr value, IterateObjectCallback callback);
 
 private:
 
-	std::map<std::string, ValuePtr> m_fields;
+	std::vector<Field> m_fields;
+	std::vector<uint32_t> m_index;		// Position + 1 of the field in each slot, 0 when empty
 };
 	}
 }
@@ -33,24 +33,24 @@ inline Object::Object()
 
 inline Object::Object(const std::string &jsonPayload) 
 {
-	auto value = JSON::Parse(jsonPayload.c_str());
-	m_fields = std::move(value->AsObject().m_fields);
+	auto value = JSON::Parse(jsonPayload.data(), jsonPayload.size());
+	*this = std::move(value->AsObject());
 }
 
 inline Object::Object(Object &&array) :
-		m_fields(std::move(array.m_fields))
+		m_fields(std::move(array.m_fields)), m_index(std::move(array.m_index))
 {
 }
 
 inline Object::Object(const Object &array) :
-	m_fields(array.m_fields)
+	m_fields(array.m_fields), m_index(array.m_index)
 {
 }
 
 template <class T>
-inline T Object::Get(const std::string &key) const
+inline T Object::Get(const Key &key) const
 {
-	throw std::logic_error(std::string("Required field missing ") + key);
+	throw std::logic_error(std::string("Required field missing ") + key.ToString());
 }
 
 inline Object & Object::operator = (const Object &object)
@@ -59,23 +59,25 @@ inline Object & Object::operator = (const Object &object)
 		return *this;
 
 	m_fields = object.m_fields;
+	m_index = object.m_index;
 	return *this;
 }
 
 inline Object & Object::operator = (Object &&object)
 {
 	m_fields = std::move(object.m_fields);
+	m_index = std::move(object.m_index);
 	return *this;
 }
 
 template <>
-inline Array Object::Get<Array>(const std::string &key) const
+inline Array Object::Get<Array>(const Key &key) const
 {
 	return Find(key)->AsArray();
 }
 
 template <>
-inline bool Object::Get<bool>(const std::string &key) const
+inline bool Object::Get<bool>(const Key &key) const
 {
 	auto value = Find(key);
 
@@ -83,26 +85,30 @@ inline bool Object::Get<bool>(const std::string &key) const
 		return value->AsBool();
 	else if(value->IsNumber())
 		return value->AsNumber() != 0;
-	else
-		return std::stod(value->AsString()) != 0;
+
+	double number;
+	if(!ParseDouble(value->GetStringData(), value->GetStringSize(), number))
+		throw std::logic_error(std::string("Field was not a number ") + key.ToString());
+
+	return number != 0;
 }
 
 template <>
-inline ValuePtr Object::Get<ValuePtr>(const std::string &key) const
+inline ValuePtr Object::Get<ValuePtr>(const Key &key) const
 {
 	auto value = Find(key);
 	return value;
 }
 
 template <>
-inline Object Object::Get<Object>(const std::string &key) const
+inline Object Object::Get<Object>(const Key &key) const
 {
 	auto value = Find(key);
 	return value->AsObject();
 }
 
 template <>
-inline std::vector<std::string> Object::Get<std::vector<std::string>>(const std::string &key) const
+inline std::vector<std::string> Object::Get<std::vector<std::string>>(const Key &key) const
 {
 	auto value = Find(key);
 	std::vector<std::string> result;
@@ -112,53 +118,65 @@ inline std::vector<std::string> Object::Get<std::vector<std::string>>(const std:
 }
 
 template <>
-inline std::string Object::Get<std::string>(const std::string &key) const
+inline std::string Object::Get<std::string>(const Key &key) const
 {
 	auto value = Find(key);
 	return value->AsString();
 }
 
 template <>
-inline double Object::Get<double>(const std::string &key) const
+inline double Object::Get<double>(const Key &key) const
 {
 	auto value = Find(key);
 	if(!value->IsNumber() && !value->IsString())
-		throw std::logic_error(std::string("Field was not of type json=type Number of String ") + key);
+		throw std::logic_error(std::string("Field was not of type json=type Number of String ") + key.ToString());
+	else if(value->IsNumber())
+		return static_cast<double>(value->AsNumber());
 
-	return std::stod(value->AsString());
+	double number;
+	if(!ParseDouble(value->GetStringData(), value->GetStringSize(), number))
+		throw std::logic_error(std::string("Field was not a number ") + key.ToString());
+
+	return number;
 }
 
 template <>
-inline uint64_t Object::Get<uint64_t>(const std::string &key) const
+inline uint64_t Object::Get<uint64_t>(const Key &key) const
 {
 	auto value = Find(key);
 	if(!value->IsNumber() && !value->IsString())
-		throw std::logic_error(std::string("Field was not of type json=type Number of String ") + key);
+		throw std::logic_error(std::string("Field was not of type json=type Number of String ") + key.ToString());
+	else if(value->IsNumber())
+		return value->AsNumber();
+
+	// Numbers the cloud sends as strings are read where they are
+	uint64_t number;
+	if(!ParseDigits(value->GetStringData(), value->GetStringSize(), number))
+		throw std::logic_error(std::string("Field was not a number ") + key.ToString());
 
-	return value->IsNumber() ? static_cast<uint64_t>(value->AsNumber())
-		: std::stoll(value->AsString());
+	return number;
 }
 
 template <>
-inline uint32_t Object::Get<uint32_t>(const std::string &key) const
+inline uint32_t Object::Get<uint32_t>(const Key &key) const
 {
 	return static_cast<uint32_t>(Get<uint64_t>(key));
 }
 
 template <>
-inline uint16_t Object::Get<uint16_t>(const std::string &key) const
+inline uint16_t Object::Get<uint16_t>(const Key &key) const
 {
 	return static_cast<uint16_t>(Get<uint64_t>(key));
 }
 
 template <class T>
-inline T Object::GetOpt(const std::string &key, const T &defaultValue) const
+inline T Object::GetOpt(const Key &key, const T &defaultValue) const
 {
-	throw std::logic_error(std::string("Unhangled template ") + key);
+	throw std::logic_error(std::string("Unhangled template ") + key.ToString());
 }
 
 template <>
-inline std::string Object::GetOpt<std::string>(const std::string &key, const std::string &defaultValue) const
+inline std::string Object::GetOpt<std::string>(const Key &key, const std::string &defaultValue) const
 {
 	auto value = FindOpt(key);
 
@@ -169,24 +187,20 @@ inline std::string Object::GetOpt<std::string>(const std::string &key, const std
 }
 
 template <>
-inline double Object::GetOpt<double>(const std::string &key, const double &defaultValue) const
+inline double Object::GetOpt<double>(const Key &key, const double &defaultValue) const
 {
 	auto value = FindOpt(key);
 	if(!value || (!value->IsNumber() && !value->IsString()))
 		return defaultValue;
+	else if(value->IsNumber())
+		return static_cast<double>(value->AsNumber());
 
-	try
-	{
-		return std::stod(value->AsString());
-	}
-	catch(std::exception &)
-	{
-		return defaultValue;
-	}
+	double number;
+	return ParseDouble(value->GetStringData(), value->GetStringSize(), number) ? number : defaultValue;
 }
 
 template <>
-inline ValuePtr Object::GetOpt<ValuePtr>(const std::string &key, const ValuePtr &defaultObject) const
+inline ValuePtr Object::GetOpt<ValuePtr>(const Key &key, const ValuePtr &defaultObject) const
 {
 	auto value = FindOpt(key);
 	if(!value)
@@ -196,7 +210,7 @@ inline ValuePtr Object::GetOpt<ValuePtr>(const std::string &key, const ValuePtr
 }
 
 template <>
-inline Object Object::GetOpt<Object>(const std::string &key, const Object &defaultObject) const
+inline Object Object::GetOpt<Object>(const Key &key, const Object &defaultObject) const
 {
 	auto value = FindOpt(key);
 	if(!value)
@@ -213,53 +227,48 @@ inline Object Object::GetOpt<Object>(const std::string &key, const Object &defau
 }
 
 template <>
-inline uint32_t Object::GetOpt<uint32_t>(const std::string &key, const uint32_t &defaultValue) const
+inline uint64_t Object::GetOpt<uint64_t>(const Key &key, const uint64_t &defaultValue) const
 {
 	auto value = FindOpt(key);
 	if(!value || (!value->IsNumber() && !value->IsString()))
 		return defaultValue;
+	else if(value->IsNumber())
+		return value->AsNumber();
 
-	if(value->IsString() && value->AsString().empty())
-		return defaultValue;
-
-	try
-	{
-		return value->IsNumber() ? static_cast<uint32_t>(value->AsNumber()) 
-			: std::stoi(value->AsString());
-	}
-	catch(std::exception &)
-	{
-		return defaultValue;
-	}
+	uint64_t number;
+	return ParseDigits(value->GetStringData(), value->GetStringSize(), number) ? number : defaultValue;
 }
 
 template <>
-inline uint64_t Object::GetOpt<uint64_t>(const std::string &key, const uint64_t &defaultValue) const
+inline uint32_t Object::GetOpt<uint32_t>(const Key &key, const uint32_t &defaultValue) const
 {
-	auto value = FindOpt(key);
-	if(!value || (!value->IsNumber() && !value->IsString()))
-		return defaultValue;
+	return static_cast<uint32_t>(GetOpt<uint64_t>(key, defaultValue));
+}
 
-	if(value->IsString() && value->AsString().empty())
-		return defaultValue;
+inline bool Object::Has(const Key &key) const
+{
+	return FindOpt(key) != nullptr;
+}
 
-	try
-	{
-		return value->IsNumber() ? static_cast<uint32_t>(value->AsNumber()) 
-			: std::stoll(value->AsString());
-	}
-	catch(std::exception &)
-	{
-		return defaultValue;
-	}
+/**
+ * GetArrayView - Returns the member's array without copying it, an empty array
+ * if the member isn't one. Throws if there's no such member
+ */
+inline const Array &Object::GetArrayView(const Key &key) const
+{
+	return Find(key)->AsArray();
 }
 
-inline bool Object::Has(const std::string &key) const
+/**
+ * GetObjectRef - Returns the member's object without copying it, an empty
+ * object if the member isn't one. Throws if there's no such member
+ */
+inline const Object &Object::GetObjectRef(const Key &key) const
 {
-	return FindOpt(key) != nullptr;
+	return Find(key)->AsObject();
 }
 
-inline Type Object::GetType(const std::string &key) const
+inline Type Object::GetType(const Key &key) const
 {
 	auto value = FindOpt(key);
 	if(!value)
@@ -0,0 +1,436 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+namespace {
+
+void Fail()
+{
+	throw std::logic_error("JSON Decode Failure");
+}
+
+bool IsWhitespace(char chr)
+{
+	return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+}
+
+// true, false and null have always been taken in any case
+bool MatchesNoCase(const char *begin, const char *end, const char *word, size_t length)
+{
+	return static_cast<size_t>(end - begin) == length && U8::CompareNoCase(begin, word, static_cast<uint32_t>(length)) == 0;
+}
+
+int HexValue(char chr)
+{
+	if(chr >= '0' && chr <= '9')
+		return chr - '0';
+	else if(chr >= 'a' && chr <= 'f')
+		return chr - 'a' + 10;
+	else if(chr >= 'A' && chr <= 'F')
+		return chr - 'A' + 10;
+	return -1;
+}
+
+/**
+ * ParseHex4 - Reads the 4 hex digits of a \u escape
+ * Returns false if they aren't all there
+ */
+bool ParseHex4(const char *data, const char *end, uint32_t &codepoint)
+{
+	if(end - data < 4)
+		return false;
+
+	codepoint = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		auto value = HexValue(data[i]);
+		if(value < 0)
+			return false;
+		codepoint = codepoint << 4 | static_cast<uint32_t>(value);
+	}
+
+	return true;
+}
+
+}
+
+/**
+ * Parser - Indexes size bytes of json at data, which needn't be null terminated
+ */
+Parser::Parser(const char *data, size_t size) :
+	m_data(data), m_size(size)
+{
+	m_index.Build(data, size);
+}
+
+/**
+ * Parse - Returns the value the input holds, nothing but whitespace may follow it
+ */
+ValuePtr Parser::Parse()
+{
+	auto value = ParseValue(0);
+
+	SkipWhitespace();
+	if(m_pos != m_size)
+		Fail();
+
+	return value;
+}
+
+void Parser::SkipWhitespace()
+{
+	while(m_pos < m_size && IsWhitespace(m_data[m_pos]))
+		m_pos++;
+}
+
+/**
+ * NextStructural - Returns where the next structural character is, or the end
+ * of the input once they've run out
+ */
+size_t Parser::NextStructural() const
+{
+	auto &positions = m_index.GetPositions();
+	return m_next < positions.size() ? positions[m_next] : m_size;
+}
+
+/**
+ * AtStructural - Skips whitespace and returns true if the next character is
+ * the structural chr
+ */
+bool Parser::AtStructural(char chr)
+{
+	SkipWhitespace();
+	return m_pos < m_size && m_pos == NextStructural() && m_data[m_pos] == chr;
+}
+
+/**
+ * TakeStructural - Skips whitespace and moves over the structural character
+ * that has to be next
+ * Returns the character
+ */
+char Parser::TakeStructural()
+{
+	SkipWhitespace();
+	if(m_pos >= m_size || m_pos != NextStructural())
+		Fail();
+
+	m_next++;
+	return m_data[m_pos++];
+}
+
+ValuePtr Parser::ParseValue(uint32_t depth)
+{
+	if(depth > MAX_DEPTH)
+		throw std::logic_error("JSON Decode Failure: nested too deeply");
+
+	SkipWhitespace();
+	if(m_pos >= m_size)
+		Fail();
+
+	if(m_pos != NextStructural())
+		return ParseScalar();
+
+	switch(m_data[m_pos])
+	{
+		case '{':
+			return ParseObject(depth);
+
+		case '[':
+			return ParseArray(depth);
+
+		case '"':
+			return ParseStringValue();
+
+		default:
+			Fail();
+			return ValuePtr();
+	}
+}
+
+ValuePtr Parser::ParseObject(uint32_t depth)
+{
+	TakeStructural();
+
+	Object object;
+	if(AtStructural('}'))
+	{
+		TakeStructural();
+		return std::make_shared<Value>(std::move(object));
+	}
+
+	while(true)
+	{
+		if(!AtStructural('"'))
+			Fail();
+
+		std::string name;
+		ParseString(name);
+
+		if(TakeStructural() != ':')
+			Fail();
+
+		object.Append(std::move(name), ParseValue(depth + 1));
+
+		auto chr = TakeStructural();
+		if(chr == '}')
+		{
+			object.Finish();
+			return std::make_shared<Value>(std::move(object));
+		}
+		else if(chr != ',')
+			Fail();
+	}
+}
+
+ValuePtr Parser::ParseArray(uint32_t depth)
+{
+	TakeStructural();
+
+	Array array;
+	if(AtStructural(']'))
+	{
+		TakeStructural();
+		return std::make_shared<Value>(std::move(array));
+	}
+
+	while(true)
+	{
+		array.push_back(ParseValue(depth + 1));
+
+		auto chr = TakeStructural();
+		if(chr == ']')
+			return std::make_shared<Value>(std::move(array));
+		else if(chr != ',')
+			Fail();
+	}
+}
+
+/**
+ * TakeString - Moves over the string starting at the next structural and
+ * returns its raw contents, its closing quote is always the structural after
+ * it as stage one drops everything a string holds from the index
+ */
+void Parser::TakeString(const char *&begin, const char *&end)
+{
+	auto &positions = m_index.GetPositions();
+	if(m_next + 1 >= positions.size())
+		Fail();
+
+	begin = m_data + positions[m_next] + 1;
+	end = m_data + positions[m_next + 1];
+	m_next += 2;
+	m_pos = end - m_data + 1;
+}
+
+void Parser::ParseString(std::string &str)
+{
+	const char *begin, *end;
+	TakeString(begin, end);
+
+	if(memchr(begin, '\\', end - begin))
+		Unescape(begin, end, str);
+	else
+		str.assign(begin, end);
+}
+
+/**
+ * ParseStringValue - Reads a string value, without escapes it goes straight
+ * from the input into the value
+ */
+ValuePtr Parser::ParseStringValue()
+{
+	const char *begin, *end;
+	TakeString(begin, end);
+
+	if(!memchr(begin, '\\', end - begin))
+		return std::make_shared<Value>(begin, end - begin);
+
+	std::string str;
+	Unescape(begin, end, str);
+	return std::make_shared<Value>(str.data(), str.size());
+}
+
+/**
+ * Unescape - Decodes the escapes in a string's contents, the runs between them
+ * are copied whole
+ */
+void Parser::Unescape(const char *begin, const char *end, std::string &str)
+{
+	str.clear();
+	str.reserve(end - begin);
+
+	while(begin < end)
+	{
+		auto escape = static_cast<const char *>(memchr(begin, '\\', end - begin));
+		if(!escape)
+		{
+			str.append(begin, end);
+			return;
+		}
+
+		str.append(begin, escape);
+		if(escape + 1 >= end)
+			Fail();
+
+		begin = escape + 2;
+		switch(escape[1])
+		{
+			case '"': str += '"'; break;
+			case '\\': str += '\\'; break;
+			case '/': str += '/'; break;
+			case 'b': str += '\b'; break;
+			case 'f': str += '\f'; break;
+			case 'n': str += '\n'; break;
+			case 'r': str += '\r'; break;
+			case 't': str += '\t'; break;
+			case 'u':
+			{
+				uint32_t codepoint;
+				if(!ParseHex4(begin, end, codepoint))
+					Fail();
+				begin += 4;
+
+				// Characters past the basic plane come as a surrogate pair, a
+				// surrogate on its own can't be utf8 so it becomes U+FFFD
+				if(codepoint >= 0xD800 && codepoint <= 0xDBFF)
+				{
+					uint32_t low;
+					if(end - begin >= 6 && begin[0] == '\\' && begin[1] == 'u' && ParseHex4(begin + 2, end, low) &&
+						low >= 0xDC00 && low <= 0xDFFF)
+					{
+						codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+						begin += 6;
+					}
+					else
+						codepoint = 0xFFFD;
+				}
+				else if(codepoint >= 0xDC00 && codepoint <= 0xDFFF)
+					codepoint = 0xFFFD;
+
+				U8::Append(codepoint, str);
+				break;
+			}
+
+			// By the spec, only the above cases are allowed
+			default:
+				Fail();
+		}
+	}
+}
+
+/**
+ * TakeScalar - Moves over the true, false, null or number that runs up to the
+ * next structural character and returns where it is
+ */
+void Parser::TakeScalar(const char *&begin, const char *&end)
+{
+	begin = m_data + m_pos;
+	end = m_data + NextStructural();
+	while(end > begin && IsWhitespace(end[-1]))
+		end--;
+
+	m_pos = end - m_data;
+}
+
+/**
+ * ReadScalar - Reads a scalar, true and false have always come out as the
+ * numbers 1 and 0
+ */
+void Parser::ReadScalar(const char *begin, const char *end, Type &type, uint64_t &number)
+{
+	type = Type_Number;
+	number = 0;
+	if(MatchesNoCase(begin, end, "true", 4))
+		number = 1;
+	else if(MatchesNoCase(begin, end, "null", 4))
+		type = Type_Null;
+	else if(!MatchesNoCase(begin, end, "false", 5))
+		number = ParseNumber(begin, end);
+}
+
+ValuePtr Parser::ParseScalar()
+{
+	const char *begin, *end;
+	TakeScalar(begin, end);
+
+	Type type;
+	uint64_t number;
+	ReadScalar(begin, end, type, number);
+
+	return type == Type_Null ? std::make_shared<Value>() : std::make_shared<Value>(number);
+}
+
+/**
+ * ParseNumber - Reads a json number, numbers are unsigned 64 bit integers
+ * here so the value is cut down to its whole part and negatives wrap as they
+ * always have
+ */
+uint64_t Parser::ParseNumber(const char *begin, const char *end)
+{
+	auto data = begin;
+	auto neg = data < end && *data == '-';
+	if(neg)
+		data++;
+
+	uint64_t number = 0;
+	auto whole = data;
+	if(data < end && *data == '0')
+		data++;
+	else if(data < end && *data >= '1' && *data <= '9')
+		data = ReadDigits(data, end, number);
+	else
+		Fail();
+
+	auto wholeEnd = data;
+	const char *fraction = data, *fractionEnd = data;
+	if(data < end && *data == '.')
+	{
+		fraction = ++data;
+		uint64_t digits = 0;
+		data = fractionEnd = ReadDigits(data, end, digits);
+		if(fraction == fractionEnd)
+			Fail();
+	}
+
+	if(data < end && (*data == 'e' || *data == 'E'))
+	{
+		data++;
+
+		auto negExponent = data < end && *data == '-';
+		if(data < end && (*data == '-' || *data == '+'))
+			data++;
+
+		if(data == end || !IsDigit(*data))
+			Fail();
+
+		// Past 20 the number is either zero or out of range anyway
+		uint64_t exponent = 0;
+		while(data < end && IsDigit(*data))
+			exponent = std::min<uint64_t>(exponent * 10 + (*data++ - '0'), 20);
+
+		if(data != end)
+			Fail();
+
+		// The exponent moves the decimal point, taking fraction digits into the
+		// whole part or dropping whole digits off it
+		if(negExponent)
+		{
+			number = 0;
+			if(exponent < static_cast<uint64_t>(wholeEnd - whole))
+				ReadDigits(whole, wholeEnd - exponent, number);
+		}
+		else
+		{
+			auto taken = std::min<uint64_t>(exponent, fractionEnd - fraction);
+			ReadDigits(fraction, fraction + taken, number);
+			for(auto i = taken; i < exponent; i++)
+				number *= 10;
+		}
+	}
+
+	if(data != end)
+		Fail();
+
+	return neg ? 0 - number : number;
+}
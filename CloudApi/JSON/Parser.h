@@ -0,0 +1,50 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * Parser - Stage two of parsing. Walks a StructuralIndex of the input, so
+ * strings are cut out between their quotes in one copy and scalars are read
+ * from the span up to the next structural character, nothing is looked at a
+ * byte at a time unless it has to be. Failures throw std::logic_error
+ */
+class Parser
+{
+public:
+	static const uint32_t MAX_DEPTH = 1024;
+
+	Parser(const char *data, size_t size);
+
+	ValuePtr Parse();
+
+	static void Unescape(const char *begin, const char *end, std::string &str);
+	static uint64_t ParseNumber(const char *begin, const char *end);
+	static void ReadScalar(const char *begin, const char *end, Type &type, uint64_t &number);
+
+protected:
+	ValuePtr ParseValue(uint32_t depth);
+	ValuePtr ParseObject(uint32_t depth);
+	ValuePtr ParseArray(uint32_t depth);
+	ValuePtr ParseScalar();
+	ValuePtr ParseStringValue();
+	void ParseString(std::string &str);
+	void TakeString(const char *&begin, const char *&end);
+
+	void SkipWhitespace();
+	bool AtStructural(char chr);
+	char TakeStructural();
+	size_t NextStructural() const;
+
+	void TakeScalar(const char *&begin, const char *&end);
+
+	const char *m_data;
+	size_t m_size;
+	size_t m_pos = 0;				// Next byte to look at
+	size_t m_next = 0;				// Next structural in the index
+
+	StructuralIndex m_index;
+};
+
+	}
+}
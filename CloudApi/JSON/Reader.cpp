@@ -0,0 +1,377 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+namespace {
+
+bool IsWhitespace(char chr)
+{
+	return chr == ' ' || chr == '\t' || chr == '\r' || chr == '\n';
+}
+
+bool EndsScalar(char chr)
+{
+	return IsWhitespace(chr) || chr == ',' || chr == ']' || chr == '}';
+}
+
+}
+
+Reader::Reader(Handler &handler) :
+	m_handler(handler)
+{
+}
+
+void Reader::Fail()
+{
+	throw std::logic_error("JSON Decode Failure");
+}
+
+/**
+ * Feed - Parses the next piece of the input
+ */
+void Reader::Feed(const char *data, size_t size)
+{
+	auto end = data + size;
+	while(data < end)
+	{
+		switch(m_state)
+		{
+			case STATE_STRING:
+				data = ScanString(data, end);
+				continue;
+
+			case STATE_SCALAR:
+				data = ScanScalar(data, end);
+				continue;
+
+			default:
+				break;
+		}
+
+		auto chr = *data++;
+		if(IsWhitespace(chr))
+			continue;
+
+		switch(m_state)
+		{
+			case STATE_VALUE:
+				StartValue(chr);
+				break;
+
+			case STATE_FIRST_VALUE:
+				if(chr == ']')
+					Close(chr);
+				else
+					StartValue(chr);
+				break;
+
+			case STATE_FIRST_KEY:
+			case STATE_KEY:
+				if(chr == '}' && m_state == STATE_FIRST_KEY)
+					Close(chr);
+				else if(chr == '"')
+				{
+					m_isKey = true;
+					m_state = STATE_STRING;
+				}
+				else
+					Fail();
+				break;
+
+			case STATE_COLON:
+				if(chr != ':')
+					Fail();
+				m_state = STATE_VALUE;
+				break;
+
+			case STATE_NEXT:
+				if(chr == ',')
+					m_state = m_stack.back() == '{' ? STATE_KEY : STATE_VALUE;
+				else if(chr == ']' || chr == '}')
+					Close(chr);
+				else
+					Fail();
+				break;
+
+			default:
+				// Only whitespace may follow the value
+				Fail();
+		}
+
+		// A string or scalar that just started is scanned from the byte it started on
+		if(m_state == STATE_SCALAR)
+			data--;
+	}
+}
+
+/**
+ * Finish - Checks the input held one whole value, a number at the very end
+ * of it is only known to be complete now
+ */
+void Reader::Finish()
+{
+	if(m_state == STATE_SCALAR && m_stack.empty())
+	{
+		EndScalar(m_token.data(), m_token.data() + m_token.size());
+		m_token.clear();
+	}
+
+	if(m_state != STATE_DONE)
+		throw std::logic_error("JSON Decode Failure: input ended early");
+}
+
+void Reader::StartValue(char chr)
+{
+	switch(chr)
+	{
+		case '{':
+		case '[':
+			if(m_stack.size() >= MAX_DEPTH)
+				throw std::logic_error("JSON Decode Failure: nested too deeply");
+
+			m_stack.push_back(chr);
+			if(chr == '{')
+			{
+				m_handler.StartObject();
+				m_state = STATE_FIRST_KEY;
+			}
+			else
+			{
+				m_handler.StartArray();
+				m_state = STATE_FIRST_VALUE;
+			}
+			break;
+
+		case '"':
+			m_isKey = false;
+			m_state = STATE_STRING;
+			break;
+
+		case ']':
+		case '}':
+		case ',':
+		case ':':
+			Fail();
+			break;
+
+		default:
+			m_state = STATE_SCALAR;
+			break;
+	}
+}
+
+/**
+ * ScanString - Reads string bytes up to the closing quote or the end of the
+ * piece, returns where it stopped
+ */
+const char *Reader::ScanString(const char *data, const char *end)
+{
+	auto begin = data;
+	if(m_escapePending)
+	{
+		m_escapePending = false;
+		data++;
+	}
+
+	while(data < end)
+	{
+		auto chr = static_cast<uint8_t>(*data);
+		if(chr == '"')
+		{
+			if(m_token.empty())
+				EndString(begin, data);
+			else
+			{
+				m_token.append(begin, data);
+				EndString(m_token.data(), m_token.data() + m_token.size());
+				m_token.clear();
+			}
+
+			return data + 1;
+		}
+		else if(chr == '\\')
+		{
+			m_escaped = true;
+			if(++data == end)
+			{
+				m_escapePending = true;
+				break;
+			}
+		}
+		// Raw tabs are let through like the other parsers do, real replies have them
+		else if(chr < 0x20 && chr != '\t')
+			throw std::logic_error("JSON Decode Failure: control character in string");
+		else if(chr & 0x80)
+			m_high = true;
+
+		data++;
+	}
+
+	m_token.append(begin, end);
+	return end;
+}
+
+/**
+ * ScanScalar - Reads a true, false, null or number up to whatever ends it,
+ * returns where it stopped
+ */
+const char *Reader::ScanScalar(const char *data, const char *end)
+{
+	auto begin = data;
+	while(data < end && !EndsScalar(*data))
+		data++;
+
+	if(data == end)
+	{
+		m_token.append(begin, end);
+		return end;
+	}
+
+	if(m_token.empty())
+		EndScalar(begin, data);
+	else
+	{
+		m_token.append(begin, data);
+		EndScalar(m_token.data(), m_token.data() + m_token.size());
+		m_token.clear();
+	}
+
+	return data;
+}
+
+void Reader::EndString(const char *begin, const char *end)
+{
+	if(m_high && !U8::IsValid(begin, end - begin))
+		throw std::logic_error("JSON Decode Failure: invalid utf8");
+
+	if(m_escaped)
+	{
+		Parser::Unescape(begin, end, m_unescaped);
+		begin = m_unescaped.data();
+		end = begin + m_unescaped.size();
+	}
+
+	m_escaped = m_high = false;
+
+	if(m_isKey)
+	{
+		m_handler.Key(begin, end - begin);
+		m_state = STATE_COLON;
+	}
+	else
+	{
+		m_handler.String(begin, end - begin);
+		EndValue();
+	}
+}
+
+void Reader::EndScalar(const char *begin, const char *end)
+{
+	Type type;
+	uint64_t number;
+	Parser::ReadScalar(begin, end, type, number);
+
+	if(type == Type_Null)
+		m_handler.Null();
+	else
+		m_handler.Number(number);
+
+	EndValue();
+}
+
+void Reader::EndValue()
+{
+	m_state = m_stack.empty() ? STATE_DONE : STATE_NEXT;
+}
+
+void Reader::Close(char chr)
+{
+	if(m_stack.back() != (chr == '}' ? '{' : '['))
+		Fail();
+
+	m_stack.pop_back();
+	if(chr == '}')
+		m_handler.EndObject();
+	else
+		m_handler.EndArray();
+
+	EndValue();
+}
+
+void ValueBuilder::StartObject()
+{
+	auto value = std::make_shared<Value>(Object());
+	Add(value);
+	m_stack.push_back(value);
+	m_keys.push_back(std::string());
+}
+
+void ValueBuilder::Key(const char *data, size_t size)
+{
+	m_keys.back().assign(data, size);
+}
+
+void ValueBuilder::EndObject()
+{
+	m_stack.back()->GetObjectStorage()->Finish();
+	m_stack.pop_back();
+	m_keys.pop_back();
+}
+
+void ValueBuilder::StartArray()
+{
+	auto value = std::make_shared<Value>(Array());
+	Add(value);
+	m_stack.push_back(value);
+	m_keys.push_back(std::string());
+}
+
+void ValueBuilder::EndArray()
+{
+	m_stack.pop_back();
+	m_keys.pop_back();
+}
+
+void ValueBuilder::String(const char *data, size_t size)
+{
+	Add(std::make_shared<Value>(data, size));
+}
+
+void ValueBuilder::Number(uint64_t value)
+{
+	Add(std::make_shared<Value>(value));
+}
+
+void ValueBuilder::Null()
+{
+	Add(std::make_shared<Value>());
+}
+
+/**
+ * Add - Puts a value in the innermost open container, the first value is the root
+ */
+void ValueBuilder::Add(ValuePtr value)
+{
+	if(m_stack.empty())
+	{
+		m_value = std::move(value);
+		return;
+	}
+
+	auto &parent = *m_stack.back();
+	if(parent.IsArray())
+		parent.GetArrayStorage()->push_back(std::move(value));
+	else
+		parent.GetObjectStorage()->Append(m_keys.back(), std::move(value));
+}
+
+/**
+ * Take - Returns the finished tree, leaving the builder ready for another
+ */
+ValuePtr ValueBuilder::Take()
+{
+	m_stack.clear();
+	m_keys.clear();
+	return std::move(m_value);
+}
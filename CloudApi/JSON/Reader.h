@@ -0,0 +1,107 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * Handler - Receives what a Reader finds, in document order. Strings and keys
+ * arrive with their escapes decoded and are only valid during the call, true
+ * and false arrive as the numbers 1 and 0 as they do everywhere else
+ */
+class Handler
+{
+public:
+	virtual ~Handler() {}
+
+	virtual void StartObject() = 0;
+	virtual void Key(const char *data, size_t size) = 0;
+	virtual void EndObject() = 0;
+	virtual void StartArray() = 0;
+	virtual void EndArray() = 0;
+	virtual void String(const char *data, size_t size) = 0;
+	virtual void Number(uint64_t value) = 0;
+	virtual void Null() = 0;
+};
+
+/**
+ * ValueBuilder - A handler that puts what it hears together as a Value tree,
+ * for the parts of a streamed reply that are kept as they are
+ */
+class ValueBuilder : public Handler
+{
+public:
+	void StartObject();
+	void Key(const char *data, size_t size);
+	void EndObject();
+	void StartArray();
+	void EndArray();
+	void String(const char *data, size_t size);
+	void Number(uint64_t value);
+	void Null();
+
+	bool IsComplete() const { return m_value && m_stack.empty(); }
+	ValuePtr Take();
+
+protected:
+	void Add(ValuePtr value);
+
+	ValuePtr m_value;
+	std::vector<ValuePtr> m_stack;		// Open containers
+	std::vector<std::string> m_keys;	// Key each open object's next value goes under
+};
+
+/**
+ * Reader - Parses json as it arrives, the input can be fed in pieces of any
+ * size and the handler hears about each value as soon as it's complete. Only
+ * a string or scalar split across two pieces is ever buffered, so memory
+ * doesn't grow with the input. Failures throw std::logic_error
+ */
+class Reader
+{
+public:
+	static const uint32_t MAX_DEPTH = 1024;
+
+	Reader(Handler &handler);
+
+	void Feed(const char *data, size_t size);
+	void Finish();
+
+protected:
+	enum State
+	{
+		STATE_VALUE,				// A value has to come next
+		STATE_FIRST_VALUE,			// After [, a value or ]
+		STATE_FIRST_KEY,			// After {, a key or }
+		STATE_KEY,					// After a , in an object
+		STATE_COLON,
+		STATE_NEXT,					// After a value, a , or the container's close
+		STATE_STRING,
+		STATE_SCALAR,
+		STATE_DONE,
+	};
+
+	static void Fail();
+
+	const char *ScanString(const char *data, const char *end);
+	const char *ScanScalar(const char *data, const char *end);
+	void StartValue(char chr);
+	void EndString(const char *begin, const char *end);
+	void EndScalar(const char *begin, const char *end);
+	void EndValue();
+	void Close(char chr);
+
+	Handler &m_handler;
+	State m_state = STATE_VALUE;
+	std::vector<char> m_stack;			// Open containers, { or [
+
+	// The string or scalar being read, m_token holds what came in earlier pieces
+	std::string m_token;
+	std::string m_unescaped;
+	bool m_isKey = false;
+	bool m_escaped = false;				// The string has an escape to decode
+	bool m_escapePending = false;		// The last piece ended on a backslash
+	bool m_high = false;				// The string has bytes past ascii to check
+};
+
+	}
+}
@@ -0,0 +1,72 @@
+// Built with avx2 enabled, so this must not include Common.h or anything else with
+// inline code shared with the rest of the library
+#include <stdint.h>
+#include <stddef.h>
+
+#include "StructuralKernels.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+namespace {
+
+inline uint64_t ToMask(__m256i low, __m256i high)
+{
+	return static_cast<uint32_t>(_mm256_movemask_epi8(low)) |
+		static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32;
+}
+
+inline __m256i Equals(__m256i v, char c)
+{
+	return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+// [ and { (and ] and }) differ only in bit 5, so setting it folds each pair together
+inline __m256i Operators(__m256i v)
+{
+	auto folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	return _mm256_or_si256(_mm256_or_si256(Equals(folded, '{'), Equals(folded, '}')),
+		_mm256_or_si256(Equals(v, ':'), Equals(v, ',')));
+}
+
+// Signed compare, so bytes with the top bit set count as below 0x20 too and
+// the caller masks them out
+inline __m256i BelowSpace(__m256i v)
+{
+	return _mm256_andnot_si256(Equals(v, '\t'), _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v));
+}
+
+}
+
+#endif
+
+namespace Copy {
+	namespace JSON {
+		namespace StructuralKernels {
+
+bool ClassifyAvx2(const uint8_t *data, size_t blocks, BlockMasks *masks)
+{
+#ifdef __AVX2__
+	for(size_t i = 0; i < blocks; i++, data += 64)
+	{
+		auto low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+		auto high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32));
+
+		auto &block = masks[i];
+		block.quote = ToMask(Equals(low, '"'), Equals(high, '"'));
+		block.backslash = ToMask(Equals(low, '\\'), Equals(high, '\\'));
+		block.op = ToMask(Operators(low), Operators(high));
+		block.high = ToMask(low, high);
+		block.control = ToMask(BelowSpace(low), BelowSpace(high)) & ~block.high;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+		}
+	}
+}
@@ -0,0 +1,295 @@
+#include "Common.h"
+#include "StructuralKernels.h"
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+	#include <arm_neon.h>
+	#define STRUCTURAL_HAS_NEON
+#endif
+
+using namespace Copy;
+using namespace Copy::JSON;
+using namespace Copy::JSON::StructuralKernels;
+
+namespace {
+
+enum Kernel
+{
+	KERNEL_SCALAR,
+	KERNEL_NEON,
+	KERNEL_SSE42,
+	KERNEL_AVX2,
+};
+
+// Input is classified this many blocks at a time, 4KB stays in L1 between the passes
+const size_t s_chunkBlocks = 64;
+
+/**
+ * DetectKernel - Picks the widest classification kernel the cpu and os support
+ */
+Kernel DetectKernel()
+{
+#if defined(STRUCTURAL_HAS_NEON)
+	return KERNEL_NEON;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return KERNEL_AVX2;
+	else if(__builtin_cpu_supports("sse4.2"))
+		return KERNEL_SSE42;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	auto maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	auto sse42 = (info[2] & (1 << 20)) != 0;
+
+	// The os has to save the ymm registers for avx2
+	if(maxLeaf >= 7 && (info[2] & (1 << 27)) && (_xgetbv(0) & 0x06) == 0x06)
+	{
+		__cpuidex(info, 7, 0);
+		if(info[1] & (1 << 5))
+			return KERNEL_AVX2;
+	}
+
+	if(sse42)
+		return KERNEL_SSE42;
+#endif
+	return KERNEL_SCALAR;
+}
+
+Kernel GetKernel()
+{
+	static const auto kernel = DetectKernel();
+	return kernel;
+}
+
+void ClassifyScalar(const uint8_t *data, size_t blocks, BlockMasks *masks)
+{
+	for(size_t i = 0; i < blocks; i++, data += 64)
+	{
+		BlockMasks block = { 0, 0, 0, 0, 0 };
+		for(uint32_t j = 0; j < 64; j++)
+		{
+			auto bit = static_cast<uint64_t>(1) << j;
+			switch(data[j])
+			{
+				case '"': block.quote |= bit; break;
+				case '\\': block.backslash |= bit; break;
+				case '{': case '}': case '[': case ']': case ':': case ',': block.op |= bit; break;
+				case '\t': break;
+				default:
+					if(data[j] < 0x20)
+						block.control |= bit;
+					else if(data[j] & 0x80)
+						block.high |= bit;
+					break;
+			}
+		}
+
+		masks[i] = block;
+	}
+}
+
+#if defined(STRUCTURAL_HAS_NEON)
+
+// Gathers the top bits of 64 compare results into a mask, as movemask would
+uint64_t NeonMask(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+	static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+	auto bits = vld1q_u8(weights);
+
+	auto sum0 = vpaddq_u8(vandq_u8(a, bits), vandq_u8(b, bits));
+	auto sum1 = vpaddq_u8(vandq_u8(c, bits), vandq_u8(d, bits));
+	sum0 = vpaddq_u8(sum0, sum1);
+	sum0 = vpaddq_u8(sum0, sum0);
+	return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+}
+
+void ClassifyNeon(const uint8_t *data, size_t blocks, BlockMasks *masks)
+{
+	auto quote = vdupq_n_u8('"');
+	auto backslash = vdupq_n_u8('\\');
+	auto openBrace = vdupq_n_u8('{');
+	auto closeBrace = vdupq_n_u8('}');
+	auto colon = vdupq_n_u8(':');
+	auto comma = vdupq_n_u8(',');
+	auto fold = vdupq_n_u8(0x20);
+	auto tab = vdupq_n_u8('\t');
+	auto top = vdupq_n_u8(0x80);
+
+	for(size_t i = 0; i < blocks; i++, data += 64)
+	{
+		uint8x16_t v[4], quotes[4], backslashes[4], ops[4], controls[4], highs[4];
+		for(int j = 0; j < 4; j++)
+		{
+			v[j] = vld1q_u8(data + j * 16);
+
+			// [ and { (and ] and }) differ only in bit 5, so setting it folds each pair together
+			auto folded = vorrq_u8(v[j], fold);
+			quotes[j] = vceqq_u8(v[j], quote);
+			backslashes[j] = vceqq_u8(v[j], backslash);
+			ops[j] = vorrq_u8(vorrq_u8(vceqq_u8(folded, openBrace), vceqq_u8(folded, closeBrace)),
+				vorrq_u8(vceqq_u8(v[j], colon), vceqq_u8(v[j], comma)));
+			controls[j] = vbicq_u8(vcltq_u8(v[j], fold), vceqq_u8(v[j], tab));
+			highs[j] = vtstq_u8(v[j], top);
+		}
+
+		auto &block = masks[i];
+		block.quote = NeonMask(quotes[0], quotes[1], quotes[2], quotes[3]);
+		block.backslash = NeonMask(backslashes[0], backslashes[1], backslashes[2], backslashes[3]);
+		block.op = NeonMask(ops[0], ops[1], ops[2], ops[3]);
+		block.control = NeonMask(controls[0], controls[1], controls[2], controls[3]);
+		block.high = NeonMask(highs[0], highs[1], highs[2], highs[3]);
+	}
+}
+
+#endif
+
+void Classify(const uint8_t *data, size_t blocks, BlockMasks *masks)
+{
+	auto kernel = GetKernel();
+
+#if defined(STRUCTURAL_HAS_NEON)
+	if(kernel == KERNEL_NEON)
+		return ClassifyNeon(data, blocks, masks);
+#endif
+	if(kernel == KERNEL_AVX2 && ClassifyAvx2(data, blocks, masks))
+		return;
+	else if(kernel >= KERNEL_SSE42 && ClassifySse42(data, blocks, masks))
+		return;
+
+	ClassifyScalar(data, blocks, masks);
+}
+
+/**
+ * PrefixXor - Each bit becomes the xor of itself and every bit below it, run
+ * over the quote bits that's every byte from an opening quote up to its close
+ */
+inline uint64_t PrefixXor(uint64_t bits)
+{
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+	return bits;
+}
+
+/**
+ * FindEscaped - Returns the bytes escaped by a backslash, carry says the first
+ * byte is escaped by the end of the last block and is set for the next one.
+ * Backslashes are rare enough in json that walking them one by one is cheap
+ */
+inline uint64_t FindEscaped(uint64_t backslash, uint64_t &carry)
+{
+	auto escaped = carry;
+	carry = 0;
+
+	// An escaped backslash escapes nothing
+	backslash &= ~escaped;
+	while(backslash)
+	{
+		auto bit = backslash & (0 - backslash);
+		if(bit == static_cast<uint64_t>(1) << 63)
+		{
+			carry = 1;
+			break;
+		}
+
+		escaped |= bit << 1;
+		backslash &= ~(bit | bit << 1);
+	}
+
+	return escaped;
+}
+
+}
+
+/**
+ * GetKernelName - Returns which classification kernel this cpu runs
+ */
+const char *StructuralIndex::GetKernelName()
+{
+	switch(GetKernel())
+	{
+		case KERNEL_AVX2: return ClassifyAvx2(nullptr, 0, nullptr) ? "avx2" : "scalar";
+		case KERNEL_SSE42: return ClassifySse42(nullptr, 0, nullptr) ? "sse4.2" : "scalar";
+		case KERNEL_NEON: return "neon";
+		default: return "scalar";
+	}
+}
+
+/**
+ * Build - Indexes size bytes of json at data, throws std::logic_error if a
+ * string is unterminated or holds a control character, or the input isn't utf8
+ */
+void StructuralIndex::Build(const char *data, size_t size)
+{
+	if(size > std::numeric_limits<uint32_t>::max())
+		throw std::logic_error("JSON Decode Failure: input over 4GB");
+
+	m_positions.clear();
+	m_positions.reserve(size / 8 + 16);
+
+	auto bytes = reinterpret_cast<const uint8_t *>(data);
+	uint64_t inString = 0;			// All ones while the last block ended inside a string
+	uint64_t escapeCarry = 0;
+	uint64_t high = 0;
+
+	BlockMasks masks[s_chunkBlocks];
+	uint8_t tail[64];
+
+	for(size_t offset = 0; offset < size;)
+	{
+		auto left = size - offset;
+		auto blocks = std::min(s_chunkBlocks, left / 64);
+
+		// The last partial block is padded out with spaces, which are nothing to stage one
+		if(!blocks)
+		{
+			memset(tail, ' ', sizeof(tail));
+			memcpy(tail, bytes + offset, left);
+			Classify(tail, 1, masks);
+			blocks = 1;
+		}
+		else
+			Classify(bytes + offset, blocks, masks);
+
+		for(size_t i = 0; i < blocks; i++)
+		{
+			auto &block = masks[i];
+			auto base = static_cast<uint32_t>(offset + i * 64);
+
+			auto escaped = block.backslash || escapeCarry ? FindEscaped(block.backslash, escapeCarry) : 0;
+			auto quotes = block.quote & ~escaped;
+			auto strings = PrefixXor(quotes) ^ inString;
+			inString = static_cast<uint64_t>(static_cast<int64_t>(strings) >> 63);
+
+			if(block.control & strings)
+				throw std::logic_error("JSON Decode Failure: control character in string");
+
+			high |= block.high;
+
+			auto structural = (block.op & ~strings) | quotes;
+			while(structural)
+			{
+				m_positions.push_back(base + CountTrailingZeros(structural));
+				structural &= structural - 1;
+			}
+		}
+
+		offset += blocks * 64;
+	}
+
+	if(inString)
+		throw std::logic_error("JSON Decode Failure: unterminated string");
+
+	if(high && !U8::IsValid(data, size))
+		throw std::logic_error("JSON Decode Failure: invalid utf8");
+}
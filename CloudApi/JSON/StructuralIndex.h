@@ -0,0 +1,29 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * StructuralIndex - Stage one of parsing. Classifies the input 64 bytes at a
+ * time with the widest SIMD kernel the cpu has (avx2, sse4.2 or neon, with a
+ * scalar fallback) and records where every structural character outside a
+ * string and every unescaped quote is, so stage two jumps from token to token
+ * instead of looking at each byte. Strings are checked for control characters
+ * and the input for well formed utf8 on the way through, blocks that are all
+ * ascii skip the utf8 check entirely
+ */
+class StructuralIndex
+{
+public:
+	void Build(const char *data, size_t size);
+
+	const std::vector<uint32_t> &GetPositions() const { return m_positions; }
+
+	static const char *GetKernelName();
+
+protected:
+	std::vector<uint32_t> m_positions;
+};
+
+	}
+}
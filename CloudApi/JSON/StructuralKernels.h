@@ -0,0 +1,30 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+		namespace StructuralKernels {
+
+/**
+ * BlockMasks - One bit per byte of a 64 byte block of json, for each of the
+ * characters stage one of the parser cares about
+ */
+struct BlockMasks
+{
+	uint64_t quote;			// "
+	uint64_t backslash;		// '\'
+	uint64_t op;			// { } [ ] : ,
+	uint64_t control;		// Below 0x20 other than tab, not allowed in strings
+	uint64_t high;			// Bytes of multi byte utf8 characters
+};
+
+/**
+ * Classification backends, each fills masks for blocks whole 64 byte blocks at
+ * data. They return false when the backend wasn't built for this target, the
+ * caller must check the cpu supports it before calling
+ */
+bool ClassifyAvx2(const uint8_t *data, size_t blocks, BlockMasks *masks);
+bool ClassifySse42(const uint8_t *data, size_t blocks, BlockMasks *masks);
+
+		}
+	}
+}
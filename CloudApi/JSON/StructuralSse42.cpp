@@ -0,0 +1,81 @@
+// Built with sse4.2 enabled, so this must not include Common.h or anything else with
+// inline code shared with the rest of the library
+#include <stdint.h>
+#include <stddef.h>
+
+#include "StructuralKernels.h"
+
+#ifdef __SSE4_2__
+
+#include <nmmintrin.h>
+
+namespace {
+
+inline uint64_t ToMask(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+	return static_cast<uint64_t>(_mm_movemask_epi8(a)) | static_cast<uint64_t>(_mm_movemask_epi8(b)) << 16 |
+		static_cast<uint64_t>(_mm_movemask_epi8(c)) << 32 | static_cast<uint64_t>(_mm_movemask_epi8(d)) << 48;
+}
+
+inline __m128i Equals(__m128i v, char c)
+{
+	return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+// pcmpestrm matches every byte against the whole operator set in one go
+inline uint64_t Operators(const __m128i *v)
+{
+	static const char set[16] = { '{', '}', '[', ']', ':', ',' };
+	auto operators = _mm_loadu_si128(reinterpret_cast<const __m128i *>(set));
+
+	uint64_t mask = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		auto found = _mm_cmpestrm(operators, 6, v[i], 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+		mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_cvtsi128_si32(found))) << (i * 16);
+	}
+
+	return mask;
+}
+
+// Signed compare, so bytes with the top bit set count as below 0x20 too and
+// the caller masks them out
+inline __m128i BelowSpace(__m128i v)
+{
+	return _mm_andnot_si128(Equals(v, '\t'), _mm_cmplt_epi8(v, _mm_set1_epi8(0x20)));
+}
+
+}
+
+#endif
+
+namespace Copy {
+	namespace JSON {
+		namespace StructuralKernels {
+
+bool ClassifySse42(const uint8_t *data, size_t blocks, BlockMasks *masks)
+{
+#ifdef __SSE4_2__
+	for(size_t i = 0; i < blocks; i++, data += 64)
+	{
+		__m128i v[4];
+		for(int j = 0; j < 4; j++)
+			v[j] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + j * 16));
+
+		auto &block = masks[i];
+		block.quote = ToMask(Equals(v[0], '"'), Equals(v[1], '"'), Equals(v[2], '"'), Equals(v[3], '"'));
+		block.backslash = ToMask(Equals(v[0], '\\'), Equals(v[1], '\\'), Equals(v[2], '\\'), Equals(v[3], '\\'));
+		block.op = Operators(v);
+		block.high = ToMask(v[0], v[1], v[2], v[3]);
+		block.control = ToMask(BelowSpace(v[0]), BelowSpace(v[1]), BelowSpace(v[2]), BelowSpace(v[3])) & ~block.high;
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+		}
+	}
+}
@@ -66,70 +66,13 @@ ValuePtr Value::Parse(const char **data)
 	// Is it a number?
 	else if(**data == '-' || (**data >= '0' && **data <= '9'))
 	{
-		// Negative?
-		bool neg = **data == '-';
-		if(neg)
+		// The number runs up to the first character that can't be part of one,
+		// then it's read the way the parser reads numbers
+		auto begin = *data;
+		while(**data == '-' || **data == '+' || **data == '.' || **data == 'e' || **data == 'E' || (**data >= '0' && **data <= '9'))
 			(*data)++;
 
-		uint64_t number = 0;
-
-		// Parse the whole part of the number - only if it wasn't 0
-		if(**data == '0')
-			(*data)++;
-		else if(**data >= '1' && **data <= '9')
-			number = ParseInt(data);
-		else
-			throw std::logic_error("Failed to decode json");
-		
-		// Could be a decimal now...
-		if(**data == '.')
-		{
-			(*data)++;
-
-			// Not get any digits?
-			if(!(**data >= '0' && **data <= '9'))
-				throw std::logic_error("Failed to decode json");
-			
-			// Find the decimal and sort the decimal place out
-			// Use ParseDecimal as ParseInt won't work with decimals less than 0.1
-			// thanks to Javier Abadia for the report & fix
-			double decimal = ParseDecimal(data);
-			
-			// @@ TODO: Realistically this will do nothing, and we don't
-			// really support floating point numbers in JSON
-			number += static_cast<uint64_t>(decimal);
-		}
-
-		// Could be an exponent now...
-		if(**data == 'E' || **data == 'e')
-		{
-			(*data)++;
-
-			// Check signage of expo
-			bool neg_expo = false;
-			if(**data == '-' || **data == '+')
-			{
-				neg_expo = **data == '-';
-				(*data)++;
-			}
-			
-			// Not get any digits?
-			if(!(**data >= '0' && **data <= '9'))
-				throw std::logic_error("Failed to decode json");
-
-			// @@ TODO: Realistically this will do nothing, and we don't
-			// really support floating point numbers in JSON
-			uint64_t expo = ParseInt(data);
-			for(double i = 0.0; i < expo; i++)
-				number = static_cast<uint64_t>(neg_expo ? (number / 10.0) : (number * 10.0));
-		}
-
-		// Was it neg?
-		if(neg) 
-			number *= -1;
-
-		// @@ TODO support decimal points (maybe never)
-		return std::make_shared<Value>(static_cast<uint64_t>(number));
+		return std::make_shared<Value>(Parser::ParseNumber(begin, *data));
 	}
 
 	// An object?
@@ -149,7 +92,7 @@ ValuePtr Value::Parse(const char **data)
 			if(object.Size() == 0 && **data == '}')
 			{
 				(*data)++;
-				return std::make_shared<Value>(object);
+				return std::make_shared<Value>(std::move(object));
 			}
 			
 			// We want a string now...
@@ -175,7 +118,7 @@ ValuePtr Value::Parse(const char **data)
 				throw std::logic_error("Failed to decode json");
 			
 			// Add the name:value
-			object.Put(name, value);
+			object.Append(std::move(name), value);
 			
 			// More whitespace?
 			if(!SkipWhitespace(data))
@@ -185,7 +128,8 @@ ValuePtr Value::Parse(const char **data)
 			if(**data == '}')
 			{
 				(*data)++;
-				return std::make_shared<Value>(object);
+				object.Finish();
+				return std::make_shared<Value>(std::move(object));
 			}
 			
 			// Want a , now
@@ -216,7 +160,7 @@ ValuePtr Value::Parse(const char **data)
 			if(array.size() == 0 && **data == ']')
 			{
 				(*data)++;
-				return std::make_shared<Value>(array);
+				return std::make_shared<Value>(std::move(array));
 			}
 			
 			// Get the value
@@ -235,7 +179,7 @@ ValuePtr Value::Parse(const char **data)
 			if(**data == ']')
 			{
 				(*data)++;
-				return std::make_shared<Value>(array);
+				return std::make_shared<Value>(std::move(array));
 			}
 			
 			// Want a , now
@@ -261,7 +205,8 @@ ValuePtr Value::Parse(const char **data)
  */
 Value::Value()
 {
-	m_type = Type_Null;
+	memset(m_bytes, 0, sizeof(m_bytes));
+	SetType(Type_Null);
 }
 
 /** 
@@ -273,8 +218,22 @@ Value::Value()
  */
 Value::Value(const std::string &value)
 {
-	m_type = Type_String;
-	m_string = value;
+	SetString(value.data(), value.size());
+}
+
+Value::Value(std::string &&value)
+{
+	SetString(value.data(), value.size());
+}
+
+/** 
+ * Constructor for a JSON Value of type String from size bytes at data
+ *
+ * @access public
+ */
+Value::Value(const char *data, size_t size)
+{
+	SetString(data, size);
 }
 
 /** 
@@ -286,8 +245,9 @@ Value::Value(const std::string &value)
  */
 Value::Value(uint64_t value)
 {
-	m_type = Type_Number;
-	m_number = value;
+	memset(m_bytes, 0, sizeof(m_bytes));
+	Store(value);
+	SetType(Type_Number);
 }
 
 /** 
@@ -299,8 +259,16 @@ Value::Value(uint64_t value)
  */
 Value::Value(const Array &value)
 {
-	m_type = Type_Array;
-	m_array = value;
+	memset(m_bytes, 0, sizeof(m_bytes));
+	Store(new Array(value));
+	SetType(Type_Array);
+}
+
+Value::Value(Array &&value)
+{
+	memset(m_bytes, 0, sizeof(m_bytes));
+	Store(new Array(std::move(value)));
+	SetType(Type_Array);
 }
 
 /** 
@@ -312,30 +280,144 @@ Value::Value(const Array &value)
  */
 Value::Value(const Object &value)
 {
-	m_type = Type_Object;
-	m_object = value;
+	memset(m_bytes, 0, sizeof(m_bytes));
+	Store(new Object(value));
+	SetType(Type_Object);
+}
+
+Value::Value(Object &&value)
+{
+	memset(m_bytes, 0, sizeof(m_bytes));
+	Store(new Object(std::move(value)));
+	SetType(Type_Object);
 }
 
 Value::Value(const Value &value)
 {
-	m_type = value.m_type;
+	CopyFrom(value);
+}
+
+Value::Value(Value &&value)
+{
+	MoveFrom(value);
+}
+
+Value::~Value()
+{
+	Release();
+}
+
+Value & Value::operator = (const Value &value)
+{
+	if(&value == this)
+		return *this;
+
+	Release();
+	CopyFrom(value);
+	return *this;
+}
+
+Value & Value::operator = (Value &&value)
+{
+	if(&value == this)
+		return *this;
+
+	Release();
+	MoveFrom(value);
+	return *this;
+}
 
-	switch (m_type)
+/**
+ * SetString - Makes this a string, short ones are kept inline and the rest are
+ * copied out to a null terminated buffer of their own
+ */
+void Value::SetString(const char *data, size_t size)
+{
+	if(size > std::numeric_limits<uint32_t>::max())
+		throw std::logic_error("JSON string over 4GB");
+
+	memset(m_bytes, 0, sizeof(m_bytes));
+	if(size <= INLINE_CAPACITY)
+	{
+		memcpy(m_bytes, data, size);
+		m_bytes[INLINE_SIZE_OFFSET] = static_cast<char>(size);
+	}
+	else
+	{
+		auto chars = new char[size + 1];
+		memcpy(chars, data, size);
+		chars[size] = '\0';
+
+		Store(chars);
+		Store(static_cast<uint32_t>(size), SIZE_OFFSET);
+		m_bytes[INLINE_SIZE_OFFSET] = static_cast<char>(OUT_OF_LINE);
+	}
+
+	SetType(Type_String);
+}
+
+/**
+ * CopyFrom - Copies value's out of line storage, arrays and objects only copy
+ * the pointers to their values so the copy is as shallow as it ever was
+ */
+void Value::CopyFrom(const Value &value)
+{
+	switch(value.GetType())
 	{
 		case Type_String:
-			m_string = value.m_string;
+			SetString(value.GetStringData(), value.GetStringSize());
 			break;
-		case Type_Bool:
-			m_bool = value.m_bool;
+
+		case Type_Array:
+			memset(m_bytes, 0, sizeof(m_bytes));
+			Store(new Array(*value.GetArrayStorage()));
+			SetType(Type_Array);
 			break;
-		case Type_Number:
-			m_number = value.m_number;
+
+		case Type_Object:
+			memset(m_bytes, 0, sizeof(m_bytes));
+			Store(new Object(*value.GetObjectStorage()));
+			SetType(Type_Object);
+			break;
+
+		default:
+			memcpy(m_bytes, value.m_bytes, sizeof(m_bytes));
+			break;
+	}
+}
+
+/**
+ * MoveFrom - Takes value's storage, leaving it null
+ */
+void Value::MoveFrom(Value &value)
+{
+	memcpy(m_bytes, value.m_bytes, sizeof(m_bytes));
+
+	memset(value.m_bytes, 0, sizeof(value.m_bytes));
+	value.SetType(Type_Null);
+}
+
+/**
+ * Release - Frees any out of line storage
+ */
+void Value::Release()
+{
+	switch(GetType())
+	{
+		case Type_String:
+			if(static_cast<uint8_t>(m_bytes[INLINE_SIZE_OFFSET]) == OUT_OF_LINE)
+				delete [] Load<char *>();
+			break;
+
 		case Type_Array:
-			m_array = value.m_array;
+			delete GetArrayStorage();
+			break;
+
 		case Type_Object:
-			// @@ TODO: if any shared pointers to other values are contained within,
-			// we'll only be doing a shallow copy
-			m_object = value.m_object;
+			delete GetObjectStorage();
+			break;
+
+		default:
 			break;
 	}
 }
@@ -349,7 +431,7 @@ Value::Value(const Value &value)
  */
 bool Value::IsNull() const
 {
-	return m_type == Type_Null;
+	return GetType() == Type_Null;
 }
 
 /** 
@@ -361,7 +443,7 @@ bool Value::IsNull() const
  */
 bool Value::IsString() const
 {
-	return m_type == Type_String;
+	return GetType() == Type_String;
 }
 
 /** 
@@ -373,7 +455,7 @@ bool Value::IsString() const
  */
 bool Value::IsBool() const
 {
-	return m_type == Type_Bool;
+	return GetType() == Type_Bool;
 }
 
 /** 
@@ -385,7 +467,7 @@ bool Value::IsBool() const
  */
 bool Value::IsNumber() const
 {
-	return m_type == Type_Number;
+	return GetType() == Type_Number;
 }
 
 /** 
@@ -397,7 +479,7 @@ bool Value::IsNumber() const
  */
 bool Value::IsArray() const
 {
-	return m_type == Type_Array;
+	return GetType() == Type_Array;
 }
 
 /** 
@@ -409,7 +491,7 @@ bool Value::IsArray() const
  */
 bool Value::IsObject() const
 {
-	return m_type == Type_Object;
+	return GetType() == Type_Object;
 }
 
 /** 
@@ -422,7 +504,7 @@ bool Value::IsObject() const
  */
 std::string Value::AsString() const
 {
-	return m_string;
+	return std::string(GetStringData(), GetStringSize());
 }
 
 /** 
@@ -435,7 +517,7 @@ std::string Value::AsString() const
  */
 bool Value::AsBool() const
 {
-	return m_bool;
+	return IsBool() && Load<bool>();
 }
 
 /** 
@@ -448,7 +530,7 @@ bool Value::AsBool() const
  */
 uint64_t Value::AsNumber() const
 {
-	return m_number;
+	return IsNumber() ? Load<uint64_t>() : 0;
 }
 
 /** 
@@ -457,11 +539,12 @@ uint64_t Value::AsNumber() const
  *
  * @access public
  *
- * @return Array Returns the array value
+ * @return Array Returns the array value, which is empty if this isn't one
  */
 const Array &Value::AsArray() const
 {
-	return m_array;
+	static const Array empty;
+	return IsArray() ? *GetArrayStorage() : empty;
 }
 
 /** 
@@ -470,11 +553,40 @@ const Array &Value::AsArray() const
  *
  * @access public
  *
- * @return Object Returns the object value
+ * @return Object Returns the object value, which is empty if this isn't one
  */
 const Object &Value::AsObject() const
 {
-	return m_object;
+	static const Object empty;
+	return IsObject() ? *GetObjectStorage() : empty;
+}
+
+/** 
+ * Retrieves where the String value's bytes are, they're only null terminated
+ * when the string is stored out of line
+ *
+ * @access public
+ */
+const char *Value::GetStringData() const
+{
+	if(!IsString())
+		return "";
+
+	return static_cast<uint8_t>(m_bytes[INLINE_SIZE_OFFSET]) == OUT_OF_LINE ? Load<char *>() : m_bytes;
+}
+
+/** 
+ * Retrieves the length of the String value in bytes, 0 if this isn't one
+ *
+ * @access public
+ */
+uint32_t Value::GetStringSize() const
+{
+	if(!IsString())
+		return 0;
+
+	auto inlineSize = static_cast<uint8_t>(m_bytes[INLINE_SIZE_OFFSET]);
+	return inlineSize == OUT_OF_LINE ? Load<uint32_t>(SIZE_OFFSET) : inlineSize;
 }
 
 /** 
@@ -487,25 +599,32 @@ const Object &Value::AsObject() const
  */
 std::string Value::Stringify(bool prettify) const
 {
+	if(!prettify)
+	{
+		Writer writer;
+		writer.Write(*this);
+		return writer.Take();
+	}
+
 	std::string ret_string;
 	
-	switch (m_type)
+	switch (GetType())
 	{
 		case Type_Null:
 			ret_string = "null";
 			break;
 		
 		case Type_String:
-			ret_string = StringifyString(m_string);
+			ret_string = StringifyString(AsString());
 			break;
 		
 		case Type_Bool:
-			ret_string = m_bool ? "true" : "false";
+			ret_string = AsBool() ? "true" : "false";
 			break;
 		
 		case Type_Number:
 		{
-			ret_string = std::to_string(m_number);
+			ret_string = std::to_string(AsNumber());
 			break;
 		}
 		
@@ -515,13 +634,14 @@ std::string Value::Stringify(bool prettify) const
 			if(prettify)
 				ret_string += "\n";
 
-			Array::const_iterator iter = m_array.begin();
-			while(iter != m_array.end())
+			auto &array = *GetArrayStorage();
+			Array::const_iterator iter = array.begin();
+			while(iter != array.end())
 			{
 				ret_string += (*iter)->Stringify();
 				
 				// Not at the end - add a separator
-				if(++iter != m_array.end())
+				if(++iter != array.end())
 					ret_string += ",";
 
 				if(prettify)
@@ -540,16 +660,17 @@ std::string Value::Stringify(bool prettify) const
 				break;
 			}
 
+			auto &fields = GetObjectStorage()->m_fields;
 			ret_string = "{";
-			auto iter = m_object.m_fields.begin();
-			while(iter != m_object.m_fields.end())
+			auto iter = fields.begin();
+			while(iter != fields.end())
 			{
-				ret_string += StringifyString((*iter).first);
+				ret_string += StringifyString(iter->key);
 				ret_string += ":";
-				ret_string += (*iter).second->Stringify();
+				ret_string += iter->value->Stringify();
 				
 				// Not at the end - add a separator
-				if(++iter != m_object.m_fields.end())
+				if(++iter != fields.end())
 					ret_string += ",";
 			}
 			ret_string += "}";
@@ -587,18 +708,19 @@ void Value::PrettifyObjectHelper(const Value &node, std::string &output, int lev
 	output +="{\n";
 
 	// start iterating from the current node
-	auto iter = node.m_object.m_fields.begin();
-	while(iter != node.m_object.m_fields.end())
+	auto &fields = node.GetObjectStorage()->m_fields;
+	auto iter = fields.begin();
+	while(iter != fields.end())
 	{
-		output += nextIndent + StringifyString(iter->first);
+		output += nextIndent + StringifyString(iter->key);
 		output += ":";
 
 		std::string nextObj;
-		PrettifyObjectHelper(*iter->second, nextObj, level+1);
+		PrettifyObjectHelper(*iter->value, nextObj, level+1);
 		output += nextObj;
 	
 		// Not at the end - add a separator
-		if(++iter != node.m_object.m_fields.end())
+		if(++iter != fields.end())
 			output += ",\n";
 	}
 	output += "\n" + indent + "}";
@@ -606,7 +728,7 @@ void Value::PrettifyObjectHelper(const Value &node, std::string &output, int lev
 
 Type Value::GetType() const
 {
-	return m_type;
+	return static_cast<Type>(m_bytes[TYPE_OFFSET]);
 }
 
 /** 
@@ -622,81 +744,8 @@ Type Value::GetType() const
  */
 std::string Value::StringifyString(const std::string &str)
 {
-	std::string str_out = "\"";
-	
-	auto iter = static_cast<const char *>(str.c_str());
-	while(*iter)
-	{
-		uint8_t chr = *iter;
-
-		if(chr == '"' || chr == '\\' || chr == '/')
-		{
-			str_out += '\\';
-			str_out += (char)chr;
-		}
-		else if(chr == '\b')
-		{
-			str_out += "\\b";
-		}
-		else if(chr == '\f')
-		{
-			str_out += "\\f";
-		}
-		else if(chr == '\n')
-		{
-			str_out += "\\n";
-		}
-		else if(chr == '\r')
-		{
-			str_out += "\\r";
-		}
-		else if(chr == '\t')
-		{
-			str_out += "\\t";
-		}
-		else if(chr < ' ' || chr & 0x80) // Control character or extended character
-		{
-			uint32_t codepoint;
-			uint32_t charlen = U8::CharSize(iter);
-			
-			// Total character length determines mask of first byte
-			if(charlen == 1)
-				codepoint = (uint32_t)(chr & 0x7F); // 0xxxxxxx
-			else if(charlen == 2)
-				codepoint = (uint32_t)(chr & 0x1F); // 110xxxxx
-			else if(charlen == 3)
-				codepoint = (uint32_t)(chr & 0x0F); // 1110xxxx
-			else if(charlen == 4)
-				codepoint = (uint32_t)(chr & 0x07); // 11110xxx
-			else // Invalid character length
-				return str_out + "\"";
-
-			for(uint32_t i = 1; i < charlen; i++)
-			{
-				if((iter[i] & 0xC0) != 0x80) // All remaining bytes must be of form 10xxxxxx
-					return str_out + "\"";
-				codepoint = ((codepoint << 6) | (uint32_t)(iter[i] & 0x3F)); // Grab next 6 bits
-			}
-
-			str_out += "\\u";
-			for(uint32_t i = 0; i < 4; i++)
-			{
-				uint32_t value = (codepoint >> (12 - 4*i)) & 0xf;
-				if(value <= 9)
-					str_out += (char)('0' + value);
-				else if(value >= 10 && value <= 15)
-					str_out += (char)('A' + (value - 10));
-			}
-		}
-		else
-		{
-			str_out += (char)chr;
-		}
-		
-		iter = U8::NextChar(iter);
-	}
-	
-	str_out += "\"";
+	std::string str_out;
+	Writer::EscapeString(str.data(), str.size(), str_out);
 	return str_out;
 }
 
@@ -705,12 +754,17 @@ ValuePtr Value::Create(const std::string &value)
 	return std::make_shared<Value>(value);
 }
 
+ValuePtr Value::Create(std::string &&value)
+{
+	return std::make_shared<Value>(std::move(value));
+}
+
 ValuePtr Value::Create(const std::vector<std::string> &vectorOfStrings)
 {
 	Array arrayValue;
 	for(auto &entry : vectorOfStrings)
 		arrayValue.push_back(Create(entry));
-	return Create(arrayValue);
+	return Create(std::move(arrayValue));
 }
 
 ValuePtr Value::Create(uint64_t value)
@@ -723,11 +777,21 @@ ValuePtr Value::Create(const Array &value)
 	return std::make_shared<Value>(value);
 }
 
+ValuePtr Value::Create(Array &&value)
+{
+	return std::make_shared<Value>(std::move(value));
+}
+
 ValuePtr Value::Create(const Object &value)
 {
 	return std::make_shared<Value>(value);
 }
 
+ValuePtr Value::Create(Object &&value)
+{
+	return std::make_shared<Value>(std::move(value));
+}
+
 ValuePtr Value::Create(const ValuePtr &value)
 {
 	return value;
@@ -31,19 +31,34 @@ class Value
 {
 public:
 	friend class Object;
+	friend class Builder;
+	friend class ValueBuilder;
+	friend class Writer;
 	Value();
 	Value(const std::string &value);
+	Value(std::string &&value);
+	Value(const char *data, size_t size);
 	Value(uint64_t value);
 	Value(const Array &value);
+	Value(Array &&value);
 	Value(const Object &value);
+	Value(Object &&value);
 	Value(const Value &value);
+	Value(Value &&value);
+	~Value();
+
+	Value & operator = (const Value &value);
+	Value & operator = (Value &&value);
 
 	static ValuePtr Create(const std::string &value);
+	static ValuePtr Create(std::string &&value);
 	static ValuePtr Create(const std::vector<std::string> &vectorOfStrings);
 	static ValuePtr Create(uint64_t value);
 	static ValuePtr Create(const Array &value);
+	static ValuePtr Create(Array &&value);
 
 	static ValuePtr Create(const Object &value);
+	static ValuePtr Create(Object &&value);
 	static ValuePtr Create(const ValuePtr &value);
 
 	static ValuePtr CreateNull();
@@ -60,6 +75,9 @@ public:
 	uint64_t AsNumber() const;
 	const Array &AsArray() const;
 	const Object &AsObject() const;
+
+	const char *GetStringData() const;
+	uint32_t GetStringSize() const;
 	
 	std::string Stringify(bool prettify=false) const;
 	
@@ -70,14 +88,45 @@ public:
 private:
 	static std::string StringifyString(const std::string &str);
 	static void PrettifyObjectHelper(const Value &node, std::string &output, int level);
-	
-	Type m_type;
-	std::string m_string;
-	bool m_bool;
-	uint64_t m_number;
-	Array m_array;
-	Object m_object;
-};
 
+	// A value is 16 bytes. Numbers, bools and the pointers to out of line strings,
+	// arrays and objects sit in the first 8, with an out of line string's length
+	// after them. Strings of up to INLINE_CAPACITY bytes are kept in place of all
+	// that, and the last two bytes are the inline length and the type
+	static const uint32_t INLINE_CAPACITY = 14;
+	static const uint8_t OUT_OF_LINE = 0xFF;
+	static const size_t SIZE_OFFSET = 8;
+	static const size_t INLINE_SIZE_OFFSET = 14;
+	static const size_t TYPE_OFFSET = 15;
+
+	template<class T>
+	T Load(size_t offset = 0) const
+	{
+		T value;
+		memcpy(&value, m_bytes + offset, sizeof(value));
+		return value;
+	}
+
+	template<class T>
+	void Store(const T &value, size_t offset = 0)
+	{
+		memcpy(m_bytes + offset, &value, sizeof(value));
+	}
+
+	void SetType(Type type) { m_bytes[TYPE_OFFSET] = static_cast<char>(type); }
+	void SetString(const char *data, size_t size);
+	void CopyFrom(const Value &value);
+	void MoveFrom(Value &value);
+	void Release();
+
+	Array *GetArrayStorage() const { return Load<Array *>(); }
+	Object *GetObjectStorage() const { return Load<Object *>(); }
+
+	union
+	{
+		uint64_t m_align;
+		char m_bytes[16];
+	};
+};
 	}
 }
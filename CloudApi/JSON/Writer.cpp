@@ -0,0 +1,355 @@
+#include "Common.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define WRITER_HAS_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#include <arm_neon.h>
+	#define WRITER_HAS_NEON
+#endif
+
+using namespace Copy;
+using namespace Copy::JSON;
+
+namespace {
+
+const char s_hexDigits[] = "0123456789ABCDEF";
+
+inline bool NeedsEscape(uint8_t chr)
+{
+	return chr < 0x20 || chr >= 0x80 || chr == '"' || chr == '\\' || chr == '/';
+}
+
+/**
+ * FindEscape - Returns how many bytes at data can be copied as they are
+ */
+size_t FindEscape(const uint8_t *data, size_t size)
+{
+	size_t pos = 0;
+
+#if defined(WRITER_HAS_SSE2)
+	// A signed compare against 0x20 picks out control characters and every
+	// byte past ascii at once
+	auto space = _mm_set1_epi8(0x20);
+	auto quote = _mm_set1_epi8('"');
+	auto backslash = _mm_set1_epi8('\\');
+	auto slash = _mm_set1_epi8('/');
+
+	for(; pos + 16 <= size; pos += 16)
+	{
+		auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+		auto found = _mm_or_si128(_mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, quote)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, backslash), _mm_cmpeq_epi8(v, slash)));
+
+		auto mask = static_cast<uint32_t>(_mm_movemask_epi8(found));
+		if(mask)
+			return pos + CountTrailingZeros(mask);
+	}
+#elif defined(WRITER_HAS_NEON)
+	auto space = vdupq_n_u8(0x20);
+	auto high = vdupq_n_u8(0x80);
+	auto quote = vdupq_n_u8('"');
+	auto backslash = vdupq_n_u8('\\');
+	auto slash = vdupq_n_u8('/');
+
+	// Blocks that need an escape are finished off below a byte at a time
+	for(; pos + 16 <= size; pos += 16)
+	{
+		auto v = vld1q_u8(data + pos);
+		auto found = vorrq_u8(vorrq_u8(vcltq_u8(v, space), vcgeq_u8(v, high)),
+			vorrq_u8(vceqq_u8(v, quote), vorrq_u8(vceqq_u8(v, backslash), vceqq_u8(v, slash))));
+		if(vmaxvq_u8(found))
+			break;
+	}
+#endif
+
+	while(pos < size && !NeedsEscape(data[pos]))
+		pos++;
+
+	return pos;
+}
+
+/**
+ * FormatNumber - Writes value's digits to the end of digits, returns how many
+ */
+size_t FormatNumber(uint64_t value, char (&digits)[20])
+{
+	auto pos = sizeof(digits);
+	do
+	{
+		digits[--pos] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while(value);
+
+	return sizeof(digits) - pos;
+}
+
+void AppendEscape(uint32_t codepoint, std::string &output)
+{
+	char escape[6] = { '\\', 'u' };
+	for(int i = 0; i < 4; i++)
+		escape[2 + i] = s_hexDigits[codepoint >> (12 - 4 * i) & 0xF];
+
+	output.append(escape, sizeof(escape));
+}
+
+/**
+ * DecodeUtf8 - Reads the character at data, returns its length or 0 if it
+ * isn't well formed
+ */
+size_t DecodeUtf8(const uint8_t *data, size_t size, uint32_t &codepoint)
+{
+	auto chr = data[0];
+	size_t length;
+	uint32_t minimum;
+	if(chr >= 0xC2 && chr <= 0xDF)
+	{
+		length = 2;
+		minimum = 0x80;
+		codepoint = chr & 0x1F;
+	}
+	else if(chr >= 0xE0 && chr <= 0xEF)
+	{
+		length = 3;
+		minimum = 0x800;
+		codepoint = chr & 0x0F;
+	}
+	else if(chr >= 0xF0 && chr <= 0xF4)
+	{
+		length = 4;
+		minimum = 0x10000;
+		codepoint = chr & 0x07;
+	}
+	else
+		return 0;
+
+	if(length > size)
+		return 0;
+
+	for(size_t i = 1; i < length; i++)
+	{
+		if((data[i] & 0xC0) != 0x80)
+			return 0;
+		codepoint = codepoint << 6 | (data[i] & 0x3F);
+	}
+
+	if(codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+		return 0;
+
+	return length;
+}
+
+}
+
+Writer::Writer()
+{
+}
+
+/**
+ * Separate - Puts a comma between this value and the one before it
+ */
+void Writer::Separate()
+{
+	if(m_needsComma)
+		m_output += ',';
+}
+
+void Writer::StartObject()
+{
+	Separate();
+	m_output += '{';
+	m_needsComma = false;
+}
+
+void Writer::Key(const char *data, size_t size)
+{
+	Separate();
+	EscapeString(data, size, m_output);
+	m_output += ':';
+	m_needsComma = false;
+}
+
+void Writer::EndObject()
+{
+	m_output += '}';
+	m_needsComma = true;
+}
+
+void Writer::StartArray()
+{
+	Separate();
+	m_output += '[';
+	m_needsComma = false;
+}
+
+void Writer::EndArray()
+{
+	m_output += ']';
+	m_needsComma = true;
+}
+
+void Writer::String(const char *data, size_t size)
+{
+	Separate();
+	EscapeString(data, size, m_output);
+	m_needsComma = true;
+}
+
+void Writer::Number(uint64_t value)
+{
+	Separate();
+
+	char digits[20];
+	auto length = FormatNumber(value, digits);
+	m_output.append(digits + sizeof(digits) - length, length);
+	m_needsComma = true;
+}
+
+/**
+ * NumberString - Writes a number as a string of its digits, which is how the
+ * cloud api takes numbers in requests
+ */
+void Writer::NumberString(uint64_t value)
+{
+	Separate();
+
+	char digits[20];
+	auto length = FormatNumber(value, digits);
+	m_output += '"';
+	m_output.append(digits + sizeof(digits) - length, length);
+	m_output += '"';
+	m_needsComma = true;
+}
+
+void Writer::Bool(bool value)
+{
+	Separate();
+	m_output += value ? "true" : "false";
+	m_needsComma = true;
+}
+
+void Writer::Null()
+{
+	Separate();
+	m_output += "null";
+	m_needsComma = true;
+}
+
+/**
+ * Write - Writes a whole value tree
+ */
+void Writer::Write(const Value &value)
+{
+	switch(value.GetType())
+	{
+		case Type_Null:
+			Null();
+			break;
+
+		case Type_String:
+			String(value.GetStringData(), value.GetStringSize());
+			break;
+
+		case Type_Bool:
+			Bool(value.AsBool());
+			break;
+
+		case Type_Number:
+			Number(value.AsNumber());
+			break;
+
+		case Type_Array:
+			StartArray();
+			for(auto &item : *value.GetArrayStorage())
+				Write(*item);
+			EndArray();
+			break;
+
+		case Type_Object:
+			Write(*value.GetObjectStorage());
+			break;
+	}
+}
+
+void Writer::Write(const Object &object)
+{
+	StartObject();
+	for(auto &field : object.m_fields)
+	{
+		Key(field.key);
+		Write(*field.value);
+	}
+	EndObject();
+}
+
+/**
+ * Take - Returns the output, leaving the writer empty
+ */
+std::string Writer::Take()
+{
+	std::string output;
+	output.swap(m_output);
+	m_needsComma = false;
+	return output;
+}
+
+/**
+ * EscapeString - Appends a quoted and escaped string to output. Characters past
+ * the basic plane become surrogate pairs and bytes that aren't utf8 U+FFFD
+ */
+void Writer::EscapeString(const char *data, size_t size, std::string &output)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(data);
+
+	output += '"';
+	while(size)
+	{
+		auto run = FindEscape(bytes, size);
+		output.append(reinterpret_cast<const char *>(bytes), run);
+		bytes += run;
+		size -= run;
+		if(!size)
+			break;
+
+		auto chr = *bytes;
+		size_t length = 1;
+		switch(chr)
+		{
+			case '"': output += "\\\""; break;
+			case '\\': output += "\\\\"; break;
+			case '/': output += "\\/"; break;
+			case '\b': output += "\\b"; break;
+			case '\f': output += "\\f"; break;
+			case '\n': output += "\\n"; break;
+			case '\r': output += "\\r"; break;
+			case '\t': output += "\\t"; break;
+			default:
+			{
+				uint32_t codepoint = chr;
+				if(chr >= 0x80)
+				{
+					length = DecodeUtf8(bytes, size, codepoint);
+					if(!length)
+					{
+						length = 1;
+						codepoint = 0xFFFD;
+					}
+				}
+
+				if(codepoint >= 0x10000)
+				{
+					codepoint -= 0x10000;
+					AppendEscape(0xD800 + (codepoint >> 10), output);
+					AppendEscape(0xDC00 + (codepoint & 0x3FF), output);
+				}
+				else
+					AppendEscape(codepoint, output);
+				break;
+			}
+		}
+
+		bytes += length;
+		size -= length;
+	}
+	output += '"';
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+namespace Copy {
+	namespace JSON {
+
+/**
+ * Writer - Encodes json straight into one growing output buffer, as a Handler
+ * so a Reader can drive it as well as a Value tree. Strings are scanned 16
+ * bytes at a time for anything that needs escaping and the runs in between
+ * are copied whole. Output is what Value::Stringify has always produced,
+ * with / and everything past ascii written as \u escapes
+ */
+class Writer : public Handler
+{
+public:
+	Writer();
+
+	void StartObject();
+	void Key(const char *data, size_t size);
+	void EndObject();
+	void StartArray();
+	void EndArray();
+	void String(const char *data, size_t size);
+	void Number(uint64_t value);
+	void Null();
+
+	void Key(const std::string &key) { Key(key.data(), key.size()); }
+	void String(const std::string &str) { String(str.data(), str.size()); }
+	void Bool(bool value);
+	void NumberString(uint64_t value);
+
+	void Write(const Value &value);
+	void Write(const Object &object);
+
+	void Reserve(size_t size) { m_output.reserve(size); }
+	const std::string &GetOutput() const { return m_output; }
+	std::string Take();
+
+	static void EscapeString(const char *data, size_t size, std::string &output);
+
+protected:
+	void Separate();
+
+	std::string m_output;
+	bool m_needsComma = false;			// A value came before, and not a key
+};
+
+	}
+}
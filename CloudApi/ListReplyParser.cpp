@@ -0,0 +1,447 @@
+#include "CloudApi.h"
+
+using namespace Copy;
+
+namespace Copy {
+	namespace JSON {
+
+template<>
+struct Binding<CloudApi::CloudPartReply>
+{
+	template<class Visitor, class Bound>
+	static void Fields(Visitor &visitor, Bound &part)
+	{
+		visitor(Key("offset"), part.offset);
+		visitor(Key("size"), part.size);
+		visitor(Key("fingerprint"), part.fingerprint);
+	}
+};
+
+template<>
+struct Binding<CloudApi::CloudRevisionReply>
+{
+	template<class Visitor, class Bound>
+	static void Fields(Visitor &visitor, Bound &revision)
+	{
+		visitor(Key("parts"), revision.parts);
+	}
+};
+
+template<>
+struct Binding<CloudApi::CloudObjReply>
+{
+	template<class Visitor, class Bound>
+	static void Fields(Visitor &visitor, Bound &obj)
+	{
+		visitor(Key("path"), obj.path);
+		visitor(Key("type"), obj.type);
+		visitor(Key("object_type"), obj.objectType);
+		visitor(Key("object_id"), obj.id);
+		visitor(Key("removed_time"), obj.removedTime);
+		visitor(Key("created_time"), obj.createdTime);
+		visitor(Key("modified_time"), obj.modifiedTime);
+		visitor(Key("children_count"), obj.childCount);
+		visitor(Key("size"), obj.size);
+		visitor(Key("attributes"), obj.attributes);
+		visitor(Key("revisions"), obj.revisions);
+	}
+};
+
+	}
+}
+
+/**
+ * ListReplyParser - headerFields are the reply's, which have all arrived by the
+ * time its body does. includeRoot is set on the first page of a listing, when
+ * the listed path itself is wanted as well
+ */
+CloudApi::ListReplyParser::ListReplyParser(const Http::HeaderFields &headerFields, bool includeRoot, CloudObjCallback callback) :
+	m_headerFields(headerFields), m_includeRoot(includeRoot), m_callback(std::move(callback)), m_reader(*this)
+{
+}
+
+/**
+ * Feed - Parses the next piece of the reply
+ */
+void CloudApi::ListReplyParser::Feed(const uint8_t *data, size_t size)
+{
+	m_reader.Feed(reinterpret_cast<const char *>(data), size);
+}
+
+/**
+ * Finish - Checks the whole reply was received and was a valid json rpc reply,
+ * returns the listing's watermark and, on the first page, its root
+ */
+CloudApi::ListResult CloudApi::ListReplyParser::Finish()
+{
+	m_reader.Finish();
+
+	// The same checks JSONRPC makes of a response
+	auto &id = m_fields[FIELD_ID];
+	if(m_fields[FIELD_JSONRPC].GetString() != "2.0" || m_fields[FIELD_METHOD].present || m_fields[FIELD_PARAMS].present ||
+		!id.present || !(id.type == JSON::Type_String || id.type == JSON::Type_Number || id.type == JSON::Type_Null))
+		throw CloudException(CLOUD_RESPONSE_FAILURE, "JSON response not valid JSONRPC");
+
+	// An error object was checked as it closed, this catches any other kind
+	CheckError();
+
+	if(!m_fields[FIELD_RESULT].present)
+		throw std::logic_error(std::string("Failed to find field ") + GetFieldName(FIELD_RESULT));
+
+	ListResult result;
+	result.index = m_fields[FIELD_WATERMARK].GetNumber(FIELD_WATERMARK);
+	result.more = static_cast<uint32_t>(m_fields[FIELD_MORE].GetNumber(FIELD_MORE)) > 0;
+
+	// Force sync index to increment so we don't loop forever
+	if(!result.index)
+		result.index = 1;
+
+	if(m_fields[FIELD_CHILDREN].type == JSON::Type_Null)
+		return result;
+
+	if(m_includeRoot)
+		result.root = std::move(m_root);
+
+	return result;
+}
+
+void CloudApi::ListReplyParser::StartObject()
+{
+	if(IsBinding())
+		return m_binder.StartObject();
+
+	Open(JSON::Type_Object);
+}
+
+void CloudApi::ListReplyParser::Key(const char *data, size_t size)
+{
+	if(IsBinding())
+		return m_binder.Key(data, size);
+
+	m_key.assign(data, size);
+
+	// A repeated member replaces the one before it, as in a Value tree. A
+	// repeated result starts over, apart from children already handed on
+	auto id = FindField(m_contexts.back(), m_key);
+	if(id == FIELD_RESULT)
+	{
+		ResetFields(FIELD_WATERMARK, FIELD_CHILDREN);
+		m_root = CloudObj();
+	}
+
+	m_target = id != FIELD_COUNT ? &m_fields[id] : nullptr;
+}
+
+void CloudApi::ListReplyParser::EndObject()
+{
+	if(IsBinding())
+	{
+		m_binder.EndObject();
+		if(!m_binder.IsComplete())
+			return;
+	}
+
+	Close();
+}
+
+void CloudApi::ListReplyParser::StartArray()
+{
+	if(IsBinding())
+		return m_binder.StartArray();
+
+	Open(JSON::Type_Array);
+}
+
+void CloudApi::ListReplyParser::EndArray()
+{
+	if(IsBinding())
+		return m_binder.EndArray();
+
+	Close();
+}
+
+void CloudApi::ListReplyParser::String(const char *data, size_t size)
+{
+	if(IsBinding())
+		return m_binder.String(data, size);
+
+	Scalar(JSON::Type_String, data, size, 0);
+}
+
+void CloudApi::ListReplyParser::Number(uint64_t value)
+{
+	if(IsBinding())
+		return m_binder.Number(value);
+
+	Scalar(JSON::Type_Number, nullptr, 0, value);
+}
+
+void CloudApi::ListReplyParser::Null()
+{
+	if(IsBinding())
+		return m_binder.Null();
+
+	Scalar(JSON::Type_Null, nullptr, 0, 0);
+}
+
+/**
+ * FindField - Returns which field key is in context, or FIELD_COUNT if it isn't read
+ */
+CloudApi::ListReplyParser::FieldId CloudApi::ListReplyParser::FindField(Context context, const std::string &key)
+{
+	static const struct
+	{
+		Context context;
+		const char *key;
+		FieldId id;
+	} fields[] =
+	{
+		{ CONTEXT_ROOT, "jsonrpc", FIELD_JSONRPC },
+		{ CONTEXT_ROOT, "id", FIELD_ID },
+		{ CONTEXT_ROOT, "method", FIELD_METHOD },
+		{ CONTEXT_ROOT, "params", FIELD_PARAMS },
+		{ CONTEXT_ROOT, "result", FIELD_RESULT },
+		{ CONTEXT_ROOT, "error", FIELD_ERROR },
+		{ CONTEXT_RESULT, "list_watermark", FIELD_WATERMARK },
+		{ CONTEXT_RESULT, "more_items", FIELD_MORE },
+		{ CONTEXT_RESULT, "children", FIELD_CHILDREN },
+		{ CONTEXT_ERROR, "code", FIELD_CODE },
+		{ CONTEXT_ERROR, "message", FIELD_MESSAGE },
+	};
+
+	for(auto &field : fields)
+	{
+		if(field.context == context && key == field.key)
+			return field.id;
+	}
+
+	return FIELD_COUNT;
+}
+
+const char *CloudApi::ListReplyParser::GetFieldName(FieldId id)
+{
+	static const char *names[FIELD_COUNT] =
+	{
+		"jsonrpc", "id", "method", "params", "result", "error", "list_watermark", "more_items", "children", "code",
+		"message",
+	};
+
+	return names[id];
+}
+
+/**
+ * Open - Works out what the container starting after the last key is
+ */
+void CloudApi::ListReplyParser::Open(JSON::Type type)
+{
+	auto isObject = type == JSON::Type_Object;
+	if(m_contexts.empty())
+	{
+		m_contexts.push_back(isObject ? CONTEXT_ROOT : CONTEXT_SKIP);
+		return;
+	}
+
+	auto parent = m_contexts.back();
+	auto target = m_target;
+	m_target = nullptr;
+	if(target)
+	{
+		target->present = true;
+		target->type = type;
+	}
+
+	auto context = CONTEXT_SKIP;
+	switch(parent)
+	{
+		case CONTEXT_ROOT:
+			if(isObject && m_key == "result")
+				context = CONTEXT_RESULT;
+			else if(isObject && m_key == "error")
+			{
+				ResetFields(FIELD_CODE, FIELD_MESSAGE);
+				context = CONTEXT_ERROR;
+			}
+			break;
+
+		case CONTEXT_RESULT:
+			if(isObject && m_key == "object")
+			{
+				context = CONTEXT_OBJECT;
+				m_isRoot = true;
+			}
+			else if(!isObject && m_key == "children")
+				context = CONTEXT_CHILDREN;
+			break;
+
+		case CONTEXT_CHILDREN:
+			if(isObject)
+			{
+				context = CONTEXT_OBJECT;
+				m_isRoot = false;
+			}
+			break;
+
+		default:
+			break;
+	}
+
+	m_contexts.push_back(context);
+
+	if(context == CONTEXT_OBJECT)
+	{
+		// The revisions array's storage is kept from one object to the next
+		auto revisions = std::move(m_object.revisions);
+		revisions.clear();
+		m_object = CloudObjReply();
+		m_object.revisions = std::move(revisions);
+
+		m_binder.Reset(m_object);
+		m_binder.StartObject();
+	}
+}
+
+/**
+ * Close - Finishes off the container that just ended
+ */
+void CloudApi::ListReplyParser::Close()
+{
+	auto context = m_contexts.back();
+	m_contexts.pop_back();
+	m_target = nullptr;
+
+	if(context == CONTEXT_ERROR)
+		CheckError();
+	else if(context == CONTEXT_OBJECT)
+		FinishObject();
+}
+
+void CloudApi::ListReplyParser::Scalar(JSON::Type type, const char *data, size_t size, uint64_t number)
+{
+	if(!m_target)
+		return;
+
+	auto &field = *m_target;
+	m_target = nullptr;
+
+	field.present = true;
+	field.type = type;
+	field.number = number;
+	field.string.assign(data, size);
+
+	if(&field == &m_fields[FIELD_ERROR])
+		CheckError();
+}
+
+void CloudApi::ListReplyParser::ResetFields(FieldId first, FieldId last)
+{
+	for(auto id = static_cast<uint32_t>(first); id <= static_cast<uint32_t>(last); id++)
+	{
+		auto &field = m_fields[id];
+		field.present = false;
+		field.type = JSON::Type_Null;
+		field.string.clear();
+		field.number = 0;
+	}
+}
+
+/**
+ * CheckError - Throws the cloud's error once the reply's error member is complete
+ */
+void CloudApi::ListReplyParser::CheckError()
+{
+	auto result = m_headerFields.find("X-Request-Result");
+	if(result != m_headerFields.end() && result->second == "success")
+		return;
+
+	auto &error = m_fields[FIELD_ERROR];
+	if(!error.present || error.type == JSON::Type_Null)
+		return;
+
+	auto errorCode = static_cast<uint32_t>(m_fields[FIELD_CODE].GetNumber(FIELD_CODE));
+
+	auto &message = m_fields[FIELD_MESSAGE];
+	if(!message.present)
+		throw std::logic_error(std::string("Failed to find field ") + GetFieldName(FIELD_MESSAGE));
+
+	throw CloudException(MapCloudError(errorCode), message.GetString());
+}
+
+/**
+ * FinishObject - Builds the CloudObj for the object that just closed, as
+ * ParseCloudObj would, and hands it on if it's a listed child
+ */
+void CloudApi::ListReplyParser::FinishObject()
+{
+	if(m_isRoot && !m_includeRoot)
+		return;
+
+	auto &reply = m_object;
+	if(!reply.path.has)
+		return;
+
+	CloudObj obj;
+
+	auto type = reply.type.has ? reply.type.value : reply.objectType.has ? reply.objectType.value : std::string();
+
+	obj.id = reply.id;
+	obj.removedTime = reply.removedTime;
+	obj.createdTime = reply.createdTime;
+	obj.modifiedTime = reply.modifiedTime;
+	obj.childCount = static_cast<uint32_t>(reply.childCount);
+	if(reply.attributes && reply.attributes->IsObject())
+		obj.attributes = std::move(reply.attributes);
+	obj.path = std::move(reply.path.value);
+
+	if(!(type == "file" || type == "dir" || type == "share" || type == "company"))
+		return;
+	obj.type = type;
+
+	// Only the first revision's parts are read
+	if(type == "file")
+	{
+		obj.size = reply.size;
+
+		if(!reply.revisions.empty())
+		{
+			auto &parts = reply.revisions.front().parts;
+			obj.parts.reserve(parts.size());
+			for(auto &partReply : parts)
+			{
+				if(!partReply.offset.has)
+					throw std::logic_error("Failed to find field offset");
+				else if(!partReply.size.has)
+					throw std::logic_error("Failed to find field size");
+				else if(!partReply.fingerprint.has)
+					throw std::logic_error("Failed to find field fingerprint");
+
+				PartInfo part;
+				part.offset = partReply.offset.value;
+				part.size = static_cast<uint32_t>(partReply.size.value);
+
+				auto &hex = partReply.fingerprint.value;
+				if(!Fingerprint::FromHex(hex.data(), hex.size(), part.fingerprint))
+					throw CloudException(CLOUD_RESPONSE_FAILURE, std::string("Invalid part fingerprint ") + hex);
+
+				obj.parts.push_back(part);
+			}
+		}
+	}
+
+	if(m_isRoot)
+		m_root = std::move(obj);
+	else if(obj)
+		m_callback(obj);
+}
+
+/**
+ * GetNumber - Reads a required number, which may come as a string of digits
+ */
+uint64_t CloudApi::ListReplyParser::Field::GetNumber(FieldId id) const
+{
+	if(!present)
+		throw std::logic_error(std::string("Failed to find field ") + GetFieldName(id));
+	else if(type != JSON::Type_Number && type != JSON::Type_String)
+		throw std::logic_error(std::string("Field was not of type json=type Number of String ") + GetFieldName(id));
+
+	return type == JSON::Type_Number ? number : std::stoull(string);
+}
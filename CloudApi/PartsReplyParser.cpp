@@ -0,0 +1,220 @@
+#include "CloudApi.h"
+
+using namespace Copy;
+
+/**
+ * PartsReplyParser - parts are the parts that were requested, in request order,
+ * callback is handed each one as it completes
+ */
+CloudApi::PartsReplyParser::PartsReplyParser(std::vector<PartInfo> parts, PartCallback callback) :
+	m_parts(std::move(parts)), m_callback(std::move(callback))
+{
+}
+
+/**
+ * Feed - Parses the next piece of the reply
+ */
+void CloudApi::PartsReplyParser::Feed(const uint8_t *data, size_t size)
+{
+	while(size)
+	{
+		switch(m_state)
+		{
+			case STATE_HEADER:
+				if(Gather(&m_header, sizeof(PARTS_HEADER), data, size))
+					ParseHeader();
+				break;
+
+			case STATE_ITEM:
+				if(Gather(&m_item, sizeof(PART_ITEM), data, size))
+					ParseItem();
+				break;
+
+			case STATE_PAYLOAD:
+			{
+				auto payload = data;
+				auto length = Take(m_payloadLeft + m_paddingLeft, data, size);
+
+				// Anything past the payload is padding up to the item's data size
+				auto payloadLength = std::min<size_t>(length, m_payloadLeft);
+				ConsumePayload(payload, payloadLength);
+				m_paddingLeft -= static_cast<uint32_t>(length - payloadLength);
+
+				if(!m_payloadLeft && !m_paddingLeft)
+					FinishItem();
+				break;
+			}
+
+			case STATE_DONE:
+				throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: more data than the header describes");
+		}
+	}
+}
+
+/**
+ * Finish - Checks the whole reply was received, returns the count of parts delivered with data
+ */
+uint32_t CloudApi::PartsReplyParser::Finish()
+{
+	if(m_state != STATE_DONE)
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: not enough data from cloud");
+	else if(m_itemCount != m_header.partCount)
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: didn't get expected part count from cloud");
+
+	return m_partCount;
+}
+
+/**
+ * Take - Consumes up to wanted bytes of the input, returns how many were taken
+ */
+size_t CloudApi::PartsReplyParser::Take(size_t wanted, const uint8_t *&data, size_t &size)
+{
+	auto length = std::min(wanted, size);
+
+	if(m_state != STATE_HEADER)
+	{
+		if(length > m_bodyLeft)
+			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: part extends past the reply body");
+		m_bodyLeft -= length;
+	}
+
+	data += length;
+	size -= length;
+	return length;
+}
+
+/**
+ * Gather - Collects a fixed size structure that may be split across pieces,
+ * returns true once all of it has arrived
+ */
+bool CloudApi::PartsReplyParser::Gather(void *target, size_t targetSize, const uint8_t *&data, size_t &size)
+{
+	auto source = data;
+	auto length = Take(targetSize - m_gathered, data, size);
+
+	memcpy(static_cast<uint8_t *>(target) + m_gathered, source, length);
+	m_gathered += length;
+
+	if(m_gathered < targetSize)
+		return false;
+
+	m_gathered = 0;
+	return true;
+}
+
+void CloudApi::PartsReplyParser::ParseHeader()
+{
+	m_header.signature = NET32_CPU(m_header.signature);
+	m_header.headerSize = NET32_CPU(m_header.headerSize);
+	m_header.version = NET32_CPU(m_header.version);
+	m_header.bodySize = NET32_CPU(m_header.bodySize);
+	m_header.partCount = NET32_CPU(m_header.partCount);
+	m_header.errorCode = NET32_CPU(m_header.errorCode);
+
+	if(m_header.signature != BINARY_PARTS_HEADER_SIG)
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: Invalid header signature");
+	else if(m_header.errorCode)
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, std::string("PartsReplyParser: Error code ") + std::to_string(m_header.errorCode));
+	else if(m_header.headerSize != sizeof(PARTS_HEADER))
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: Invalid header size");
+	else if(m_header.partCount != m_parts.size())
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: didn't get expected part count from cloud");
+
+	m_bodyLeft = m_header.bodySize;
+	m_state = m_bodyLeft ? STATE_ITEM : STATE_DONE;
+}
+
+void CloudApi::PartsReplyParser::ParseItem()
+{
+	m_item.signature = NET32_CPU(m_item.signature);
+	m_item.dataSize = NET32_CPU(m_item.dataSize);
+	m_item.version = NET32_CPU(m_item.version);
+	m_item.shareId = NET32_CPU(m_item.shareId);
+	m_item.partSize = NET32_CPU(m_item.partSize);
+	m_item.payloadSize = NET32_CPU(m_item.payloadSize);
+	m_item.errorCode = NET32_CPU(m_item.errorCode);
+	m_item.fingerprint[sizeof(m_item.fingerprint) - 1] = '\0';
+
+	if(m_item.signature != BINARY_PARTS_ITEM_SIG)
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: invalid part signature");
+	else if(m_item.version != BINARY_PART_ITEM_VERSION)
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: invalid part structure version");
+	else if(m_item.dataSize < sizeof(PART_ITEM) + static_cast<uint64_t>(m_item.payloadSize))
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: invalid part data size");
+	else if(m_itemCount >= m_parts.size())
+		throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: more parts than were requested");
+
+	m_part = std::move(m_parts[m_itemCount++]);
+	m_part.data.Release();
+	m_part.errorDesc.clear();
+	m_payloadRead = 0;
+	m_payloadLeft = m_item.payloadSize;
+	m_paddingLeft = m_item.dataSize - sizeof(PART_ITEM) - m_item.payloadSize;
+
+	// On error the payload is the error message
+	if(m_item.errorCode)
+		m_part.errorCode = m_item.errorCode;
+	else
+	{
+		Fingerprint fingerprint;
+		if(!Fingerprint::FromHex(m_item.fingerprint, strlen(m_item.fingerprint), fingerprint) ||
+			m_part.fingerprint != fingerprint)
+			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: invalid part fingerprint");
+		else if(m_item.partSize != m_part.size)
+			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: invalid part size");
+		else if(m_item.payloadSize != m_item.partSize)
+			throw CloudException(CLOUD_MALFORMED_PART_RESPONSE, "PartsReplyParser: invalid part payload size");
+
+		m_part.errorCode = 0;
+		m_part.data.Resize(m_item.partSize);
+
+		m_fingerprint.Reset();
+	}
+
+	m_state = STATE_PAYLOAD;
+
+	if(!m_payloadLeft && !m_paddingLeft)
+		FinishItem();
+}
+
+/**
+ * ConsumePayload - Copies payload bytes into the current part, hashing them on the way
+ */
+void CloudApi::PartsReplyParser::ConsumePayload(const uint8_t *data, size_t size)
+{
+	if(!size)
+		return;
+
+	if(m_part.errorCode)
+		m_part.errorDesc.append(reinterpret_cast<const char *>(data), size);
+	else
+	{
+		m_part.data.Copy(m_payloadRead, size, data);
+		m_fingerprint.Update(data, size);
+	}
+
+	m_payloadRead += static_cast<uint32_t>(size);
+	m_payloadLeft -= static_cast<uint32_t>(size);
+}
+
+void CloudApi::PartsReplyParser::FinishItem()
+{
+	if(!m_part.errorCode)
+	{
+		auto actualHash = m_fingerprint.Final();
+
+		if(actualHash != m_part.fingerprint)
+		{
+			throw CloudException(INVALID_PART_FINGERPRINT, std::string("Failed to validate part fingerprint ") +
+				actualHash.ToHex() + " " + m_part.fingerprint.ToHex());
+		}
+
+		m_partCount++;
+	}
+
+	m_state = m_bodyLeft ? STATE_ITEM : STATE_DONE;
+
+	auto part = std::move(m_part);
+	m_part = PartInfo();
+	m_callback(part);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+namespace Copy {
+	namespace Transfer {
+
+/**
+ * BoundedQueue - Hands items from one pipeline stage to the next. Push blocks
+ * while the queue is full, which is what slows a fast producer down to the pace
+ * of its consumer instead of letting it buffer the whole file. Close lets the
+ * consumer drain what's left, Abort wakes everyone up and drops it
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+	BoundedQueue(size_t capacity) :
+		m_capacity(std::max<size_t>(capacity, 1))
+	{
+	}
+
+	/**
+	 * Push - Waits for room and queues item
+	 * Returns false if the queue was aborted, item is dropped
+	 */
+	bool Push(T item)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_notFull.wait(lock, [this]() { return m_aborted || m_items.size() < m_capacity; });
+		if(m_aborted)
+			return false;
+
+		m_items.push_back(std::move(item));
+		m_notEmpty.notify_one();
+		return true;
+	}
+
+	/**
+	 * Pop - Waits for the next item
+	 * Returns false once the queue is closed and drained, or aborted
+	 */
+	bool Pop(T &item)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_notEmpty.wait(lock, [this]() { return m_aborted || m_closed || !m_items.empty(); });
+		if(m_aborted || m_items.empty())
+			return false;
+
+		item = std::move(m_items.front());
+		m_items.pop_front();
+		m_notFull.notify_one();
+		return true;
+	}
+
+	/**
+	 * TryPop - Takes the next item if one is waiting
+	 * Returns false straight away if there isn't one
+	 */
+	bool TryPop(T &item)
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(m_aborted || m_items.empty())
+			return false;
+
+		item = std::move(m_items.front());
+		m_items.pop_front();
+		m_notFull.notify_one();
+		return true;
+	}
+
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_closed = true;
+		m_notEmpty.notify_all();
+	}
+
+	void Abort()
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_aborted = true;
+		m_items.clear();
+		m_notEmpty.notify_all();
+		m_notFull.notify_all();
+	}
+
+protected:
+	BoundedQueue(const BoundedQueue &);
+	BoundedQueue & operator = (const BoundedQueue &);
+
+	size_t m_capacity;
+
+	std::mutex m_lock;
+	std::condition_variable m_notFull;
+	std::condition_variable m_notEmpty;
+	std::deque<T> m_items;
+	bool m_closed = false;
+	bool m_aborted = false;
+};
+
+	}
+}
@@ -0,0 +1,237 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Transfer;
+
+DownloadEngine::DownloadEngine(CloudApi &cloudApi) :
+	DownloadEngine(cloudApi, Config())
+{
+}
+
+DownloadEngine::DownloadEngine(CloudApi &cloudApi, const Config &config) :
+	m_cloudApi(cloudApi), m_config(config)
+{
+}
+
+/**
+ * DownloadFile - Lists cloudPath for its parts and downloads it to filePath
+ */
+void DownloadEngine::DownloadFile(const std::string &cloudPath, const std::string &filePath)
+{
+	CloudApi::ListConfig config;
+	config.path = cloudPath;
+	config.includeParts = true;
+
+	auto result = m_cloudApi.ListPath(config);
+	if(!result.root)
+		throw CloudApi::CloudException(CloudApi::CLOUD_OBJECT_MISSING, "DownloadFile: " + cloudPath + " doesn't exist");
+
+	DownloadFile(result.root, filePath);
+}
+
+void DownloadEngine::DownloadFile(const CloudApi::CloudObj &cloudObj, const std::string &filePath)
+{
+	DownloadFile(cloudObj.parts, cloudObj.size, filePath);
+}
+
+/**
+ * DownloadFile - Downloads parts into a file of size bytes at filePath, replacing
+ * anything already there. Nothing at filePath changes if the download fails
+ */
+void DownloadEngine::DownloadFile(const std::vector<CloudApi::PartInfo> &parts, uint64_t size, const std::string &filePath)
+{
+	auto start = std::chrono::steady_clock::now();
+	m_stats = Stats();
+
+	for(auto &part : parts)
+		size = std::max(size, part.offset + part.size);
+
+	auto tempPath = filePath + ".download";
+	IO::File file(tempPath, IO::File::MODE_WRITE);
+
+	try
+	{
+		file.Allocate(size);
+		FetchParts(parts, file);
+
+		if(m_config.sync)
+			file.Sync();
+		file.Close();
+
+		IO::File::Rename(tempPath, filePath);
+	}
+	catch(...)
+	{
+		file.Close();
+		IO::File::Remove(tempPath);
+		throw;
+	}
+
+	m_stats.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * FetchParts - Fetches each distinct part once, in requests of at most
+ * maxRequestSize bytes with up to connections of them running at once, and
+ * writes it to every offset it appears at
+ */
+void DownloadEngine::FetchParts(const std::vector<CloudApi::PartInfo> &parts, IO::File &file)
+{
+	std::vector<CloudApi::PartInfo> unique;
+	std::vector<std::vector<uint64_t>> offsets;
+	std::unordered_map<Fingerprint, size_t> index;
+
+	for(auto &part : parts)
+	{
+		auto found = index.insert(std::make_pair(part.fingerprint, unique.size()));
+		if(found.second)
+		{
+			CloudApi::PartInfo request;
+			request.fingerprint = part.fingerprint;
+			request.size = part.size;
+			request.offset = part.offset;
+			unique.push_back(std::move(request));
+			offsets.push_back(std::vector<uint64_t>());
+		}
+
+		offsets[found.first->second].push_back(part.offset);
+	}
+
+	// The callbacks all run on the engine's event thread, so the fetch stats need
+	// no locking. Writes go to the writer thread, a full queue holds replies back
+	BoundedQueue<PartWrite> writes(std::max<uint32_t>(m_config.ioDepth, 1));
+	std::exception_ptr writeError;
+
+	auto writer = std::thread([this, &writes, &file, &writeError]()
+		{
+			try
+			{
+				WriteParts(writes, file);
+			}
+			catch(...)
+			{
+				writeError = std::current_exception();
+				writes.Abort();
+			}
+		});
+
+	auto write = [this, &unique, &offsets, &writes](size_t next, CloudApi::PartInfo &received)
+		{
+			if(received.errorCode)
+				throw CloudApi::CloudException(CloudApi::PART_NOT_FOUND, "DownloadFile: " + received.errorDesc);
+
+			if(received.data.Size() != unique[next].size)
+				throw CloudApi::CloudException(CloudApi::INVALID_PART_SIZE, "DownloadFile: part size doesn't match the file's part list");
+
+			m_stats.partsFetched++;
+			m_stats.bytesFetched += received.data.Size();
+
+			PartWrite partWrite = { &offsets[next], std::make_shared<Data>(std::move(received.data)) };
+			if(!writes.Push(std::move(partWrite)))
+				throw std::logic_error("DownloadFile: writing the file failed");
+		};
+
+	std::list<std::future<void>> requests;
+	std::exception_ptr error;
+
+	auto wait = [&requests, &error]()
+		{
+			try
+			{
+				requests.front().get();
+			}
+			catch(...)
+			{
+				if(!error)
+					error = std::current_exception();
+			}
+			requests.pop_front();
+		};
+
+	size_t begin = 0;
+	while(begin < unique.size() && !error)
+	{
+		// Every request carries at least one part, however large
+		auto end = begin + 1;
+		auto batchSize = unique[begin].size;
+		while(end < unique.size() && batchSize + unique[end].size <= m_config.maxRequestSize)
+			batchSize += unique[end++].size;
+
+		// Replies come back in request order
+		auto next = begin;
+		try
+		{
+			requests.push_back(m_cloudApi.GetPartsAsync(
+				std::vector<CloudApi::PartInfo>(unique.begin() + begin, unique.begin() + end),
+				[write, next](CloudApi::PartInfo &received) mutable { write(next++, received); }, m_config.shareId));
+		}
+		catch(...)
+		{
+			error = std::current_exception();
+		}
+
+		begin = end;
+
+		if(requests.size() >= std::max<uint32_t>(m_config.connections, 1))
+			wait();
+	}
+
+	// The callbacks queue writes, so let every request finish before the writer
+	// is told there's nothing more coming
+	while(!requests.empty())
+		wait();
+
+	if(error)
+		writes.Abort();
+	else
+		writes.Close();
+	writer.join();
+
+	// A failed write shows up in the callbacks too, its own error says more
+	if(writeError)
+		std::rethrow_exception(writeError);
+	if(error)
+		std::rethrow_exception(error);
+}
+
+/**
+ * WriteParts - Runs on the writer thread, queueing a write for every offset of
+ * each part that comes in and submitting whatever has piled up whenever the
+ * queue runs dry
+ */
+void DownloadEngine::WriteParts(BoundedQueue<PartWrite> &writes, IO::File &file)
+{
+	IO::RequestQueue queue(m_config.ioDepth);
+
+	while(true)
+	{
+		// Only block for more parts when there's nothing to wait on instead
+		PartWrite partWrite;
+		if(queue.GetInFlight() ? writes.TryPop(partWrite) : writes.Pop(partWrite))
+		{
+			auto data = partWrite.data;
+			for(auto offset : *partWrite.offsets)
+			{
+				if(data->IsEmpty())
+					continue;
+
+				const auto &bytes = *data;
+				queue.Write(file, offset, bytes.Cast<uint8_t>(), bytes.Size(), [this, data](size_t written)
+					{
+						m_stats.partsWritten++;
+						m_stats.bytesWritten += written;
+					});
+			}
+
+			if(data->IsEmpty())
+				m_stats.partsWritten += partWrite.offsets->size();
+			continue;
+		}
+
+		if(!queue.GetInFlight())
+			break;
+
+		queue.Submit();
+		queue.Wait(1);
+	}
+}
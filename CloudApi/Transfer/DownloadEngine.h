@@ -0,0 +1,63 @@
+#pragma once
+
+namespace Copy {
+	namespace Transfer {
+
+/**
+ * DownloadEngine - Downloads a file with many parts requests running at once.
+ * Each part is written at its own offset as soon as it has been verified, in
+ * whatever order the replies come back, and a fingerprint that repeats in the
+ * file is fetched once and written everywhere it appears. The file is built
+ * under a temporary name next to the target and renamed over it once complete,
+ * so the target is never seen half written. Replies are handed to a writer
+ * thread that keeps ioDepth writes in flight through an IO::RequestQueue, so
+ * the network thread never waits on the disk
+ */
+class DownloadEngine
+{
+public:
+	struct Config
+	{
+		uint32_t connections = 8;					// Parts requests running at once, up to maxAsyncRequests
+		uint32_t maxRequestSize = 4 * 1024 * 1024;	// Part bytes asked for per request
+		bool sync = true;							// Flush to disk before the rename
+		uint32_t ioDepth = 32;						// File writes in flight at once
+		uint64_t shareId = 0;
+	};
+
+	struct Stats
+	{
+		double elapsedSeconds = 0;
+		uint64_t partsFetched = 0;
+		uint64_t bytesFetched = 0;
+		uint64_t partsWritten = 0;		// Includes every copy of a repeated part
+		uint64_t bytesWritten = 0;
+	};
+
+	DownloadEngine(CloudApi &cloudApi);
+	DownloadEngine(CloudApi &cloudApi, const Config &config);
+
+	void DownloadFile(const std::string &cloudPath, const std::string &filePath);
+	void DownloadFile(const CloudApi::CloudObj &cloudObj, const std::string &filePath);
+	void DownloadFile(const std::vector<CloudApi::PartInfo> &parts, uint64_t size, const std::string &filePath);
+
+	const Stats &GetStats() const { return m_stats; }
+
+protected:
+	// A verified part on its way to every offset it appears at
+	struct PartWrite
+	{
+		const std::vector<uint64_t> *offsets;
+		std::shared_ptr<Data> data;
+	};
+
+	void FetchParts(const std::vector<CloudApi::PartInfo> &parts, IO::File &file);
+	void WriteParts(BoundedQueue<PartWrite> &writes, IO::File &file);
+
+	CloudApi &m_cloudApi;
+	Config m_config;
+	Stats m_stats;
+};
+
+	}
+}
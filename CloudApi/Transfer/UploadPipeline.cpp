@@ -0,0 +1,524 @@
+#include "Common.h"
+
+using namespace Copy;
+using namespace Copy::Transfer;
+
+UploadPipeline::UploadPipeline(CloudApi &cloudApi) :
+	UploadPipeline(cloudApi, Config())
+{
+}
+
+UploadPipeline::UploadPipeline(CloudApi &cloudApi, const Config &config) :
+	m_cloudApi(cloudApi), m_config(config),
+	m_hashThreads(config.hashThreads ? config.hashThreads : std::max<uint32_t>(std::thread::hardware_concurrency(), 1))
+{
+	if(!m_config.readSize || !m_config.hashBatch || !m_config.hasPartsBatch || !m_config.sendThreads ||
+		!m_config.ioDepth || !m_config.ioSize)
+	{
+		throw std::logic_error("UploadPipeline: readSize, hashBatch, hasPartsBatch, sendThreads, ioDepth and ioSize "
+			"must be non zero");
+	}
+
+	// The chunker would fingerprint on its own thread, that's the hash stage's job
+	m_config.chunker.fingerprint = false;
+}
+
+double UploadPipeline::SecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+/**
+ * Upload - Uploads the file at filePath to cloudPath
+ * Returns the parts the file was created from, without their data
+ */
+std::vector<CloudApi::PartInfo> UploadPipeline::Upload(const std::string &filePath, const std::string &cloudPath)
+{
+	if(m_config.mapFile)
+	{
+		IO::MappedFile mapped(filePath);
+		mapped.Advise(IO::MappedFile::ADVICE_SEQUENTIAL);
+
+		m_mapped = &mapped;
+		try
+		{
+			auto parts = Run([this, &mapped]() { ReadStage(mapped); }, cloudPath);
+			m_mapped = nullptr;
+			return parts;
+		}
+		catch(...)
+		{
+			m_mapped = nullptr;
+			throw;
+		}
+	}
+
+	IO::File file(filePath, IO::File::MODE_READ, m_config.directIo);
+	return Run([this, &file]() { ReadStage(file); }, cloudPath);
+}
+
+/**
+ * Upload - Uploads everything left in stream to cloudPath
+ * Returns the parts the file was created from, without their data
+ */
+std::vector<CloudApi::PartInfo> UploadPipeline::Upload(std::istream &stream, const std::string &cloudPath)
+{
+	return Run([this, &stream]() { ReadStage(stream); }, cloudPath);
+}
+
+/**
+ * Run - Runs the pipeline with readStage feeding it
+ */
+std::vector<CloudApi::PartInfo> UploadPipeline::Run(const std::function<void ()> &readStage, const std::string &cloudPath)
+{
+	auto start = Clock::now();
+
+	m_blocks.reset(new BoundedQueue<Data>(m_config.queueDepth));
+	m_unhashed.reset(new BoundedQueue<PartBatch>(m_config.queueDepth));
+	m_hashed.reset(new BoundedQueue<PartBatch>(m_config.queueDepth));
+	m_needed.reset(new BoundedQueue<PartBatch>(m_config.queueDepth));
+	m_hashersLeft = m_hashThreads;
+	m_error = nullptr;
+	m_parts.clear();
+
+	m_stats = Stats();
+	m_stats.hash.threads = m_hashThreads;
+	m_stats.send.threads = m_config.sendThreads;
+
+	// Each stage closes the queue it feeds when it's done, which winds down the
+	// stage after it. A failure anywhere aborts every queue
+	std::vector<std::thread> threads;
+	threads.emplace_back([this, &readStage]() { RunStage(readStage); });
+	threads.emplace_back([this]() { RunStage([this]() { ChunkStage(); }); });
+	for(uint32_t i = 0; i < m_hashThreads; i++)
+		threads.emplace_back([this]() { RunStage([this]() { HashStage(); }); });
+	threads.emplace_back([this]() { RunStage([this]() { DedupeStage(); }); });
+	for(uint32_t i = 0; i < m_config.sendThreads; i++)
+		threads.emplace_back([this]() { RunStage([this]() { SendStage(); }); });
+
+	for(auto &thread : threads)
+		thread.join();
+
+	if(m_error)
+		std::rethrow_exception(m_error);
+
+	// Parts reach the dedupe stage in whatever order the hashers finish them
+	std::sort(m_parts.begin(), m_parts.end(),
+		[](const CloudApi::PartInfo &a, const CloudApi::PartInfo &b) { return a.offset < b.offset; });
+
+	m_cloudApi.CreateFile(cloudPath, m_parts);
+
+	m_stats.elapsedSeconds = SecondsSince(start);
+	return std::move(m_parts);
+}
+
+/**
+ * RunStage - Runs a stage on its own thread, the first error is kept for
+ * Upload to throw and the rest of the pipeline is torn down
+ */
+void UploadPipeline::RunStage(const std::function<void ()> &stage)
+{
+	try
+	{
+		stage();
+	}
+	catch(...)
+	{
+		Fail(std::current_exception());
+	}
+}
+
+void UploadPipeline::Fail(std::exception_ptr error)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if(!m_error)
+			m_error = error;
+	}
+
+	m_blocks->Abort();
+	m_unhashed->Abort();
+	m_hashed->Abort();
+	m_needed->Abort();
+}
+
+/**
+ * ReadStage - Reads the stream in readSize blocks
+ */
+void UploadPipeline::ReadStage(std::istream &stream)
+{
+	StageStats stats;
+
+	while(true)
+	{
+		auto start = Clock::now();
+
+		Data block(m_config.readSize);
+		stream.read(block.Cast<char>(), block.Size());
+		block.Resize(static_cast<size_t>(stream.gcount()));
+		if(stream.bad())
+			throw std::logic_error("UploadPipeline: failed to read the file");
+
+		stats.busySeconds += SecondsSince(start);
+		if(block.IsEmpty())
+			break;
+
+		stats.items++;
+		stats.bytes += block.Size();
+
+		start = Clock::now();
+		auto pushed = m_blocks->Push(std::move(block));
+		stats.stalledSeconds += SecondsSince(start);
+		if(!pushed)
+			return;
+	}
+
+	m_blocks->Close();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.read = stats;
+}
+
+/**
+ * ReadStage - Hands out views of the mapped file readSize at a time, asking
+ * the kernel to read the next block in while this one is being chunked
+ */
+void UploadPipeline::ReadStage(IO::MappedFile &file)
+{
+	StageStats stats;
+	auto whole = file.View(0, static_cast<size_t>(file.GetSize()));
+
+	for(uint64_t offset = 0; offset < file.GetSize(); offset += m_config.readSize)
+	{
+		auto start = Clock::now();
+
+		auto size = static_cast<size_t>(std::min<uint64_t>(m_config.readSize, file.GetSize() - offset));
+		file.WillNeed(offset + size, m_config.readSize);
+
+		// Slices of one view join up across blocks, so no part gets copied
+		auto block = whole.Slice(static_cast<size_t>(offset), size);
+
+		stats.busySeconds += SecondsSince(start);
+		stats.items++;
+		stats.bytes += size;
+
+		start = Clock::now();
+		auto pushed = m_blocks->Push(std::move(block));
+		stats.stalledSeconds += SecondsSince(start);
+		if(!pushed)
+			return;
+	}
+
+	m_blocks->Close();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.read = stats;
+}
+
+/**
+ * ReadStage - Reads the file ioSize at a time with up to ioDepth reads in
+ * flight, into blocks of a pool registered with the queue. Reads finish in any
+ * order, they're copied out in file order into readSize blocks so a pool block
+ * is free again as soon as its read is used, however long the parts from it
+ * take to get through the rest of the pipeline
+ */
+void UploadPipeline::ReadStage(IO::File &file)
+{
+	struct PendingRead
+	{
+		uint32_t block;
+		size_t expected;
+		size_t bytes;
+		bool done;
+	};
+
+	StageStats stats;
+	auto fileSize = file.GetSize();
+
+	IO::BlockPool pool(m_config.ioDepth, m_config.ioSize);
+	IO::RequestQueue queue(m_config.ioDepth);
+	queue.RegisterBlocks(pool);
+
+	// Reads are whole blocks at block aligned offsets, which O_DIRECT needs
+	auto readSize = pool.GetBlockSize();
+	std::deque<PendingRead> pending;
+	uint64_t nextRead = 0;
+	Data block;
+
+	while(nextRead < fileSize || !pending.empty())
+	{
+		auto start = Clock::now();
+
+		uint32_t index;
+		while(nextRead < fileSize && pool.TryAcquire(index))
+		{
+			PendingRead read = { index, static_cast<size_t>(std::min<uint64_t>(readSize, fileSize - nextRead)), 0, false };
+			pending.push_back(read);
+
+			auto *entry = &pending.back();
+			queue.Read(file, nextRead, pool.GetBlock(index), readSize,
+				[entry](size_t bytes) { entry->bytes = bytes; entry->done = true; }, static_cast<int32_t>(index));
+			nextRead += readSize;
+		}
+
+		queue.Submit();
+		queue.Wait(1);
+
+		while(!pending.empty() && pending.front().done)
+		{
+			auto &read = pending.front();
+			if(read.bytes != read.expected)
+				throw std::logic_error("UploadPipeline: " + file.GetPath() + " changed while it was being read");
+
+			if(block.IsEmpty())
+				block.Reserve(m_config.readSize);
+			block.Append(read.bytes, pool.GetBlock(read.block));
+			pool.Release(read.block);
+			pending.pop_front();
+
+			if(block.Size() < m_config.readSize && (nextRead < fileSize || !pending.empty()))
+				continue;
+
+			stats.busySeconds += SecondsSince(start);
+			stats.items++;
+			stats.bytes += block.Size();
+
+			start = Clock::now();
+			auto pushed = m_blocks->Push(std::move(block));
+			stats.stalledSeconds += SecondsSince(start);
+			block = Data();
+			if(!pushed)
+				return;
+
+			start = Clock::now();
+		}
+
+		stats.busySeconds += SecondsSince(start);
+	}
+
+	m_blocks->Close();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.read = stats;
+}
+
+/**
+ * ChunkStage - Splits the blocks into parts and hands them on hashBatch at a time
+ */
+void UploadPipeline::ChunkStage()
+{
+	StageStats stats;
+	Chunker::FastCdc chunker(m_config.chunker);
+	PartBatch batch;
+
+	auto addPart = [&](CloudApi::PartInfo &part)
+		{
+			// Pages of a mapped file are let go as each part is done with
+			if(m_mapped)
+				part.data = m_mapped->View(part.offset, static_cast<size_t>(part.size), true);
+
+			stats.items++;
+			stats.bytes += part.size;
+			batch.push_back(std::move(part));
+			if(batch.size() < m_config.hashBatch)
+				return true;
+
+			auto start = Clock::now();
+			auto pushed = m_unhashed->Push(std::move(batch));
+			stats.stalledSeconds += SecondsSince(start);
+			batch = PartBatch();
+			return pushed;
+		};
+
+	Data block;
+	while(m_blocks->Pop(block))
+	{
+		auto start = Clock::now();
+		auto parts = chunker.Feed(block);
+		stats.busySeconds += SecondsSince(start);
+		block = Data();
+
+		for(auto &part : parts)
+		{
+			if(!addPart(part))
+				return;
+		}
+	}
+
+	for(auto &part : chunker.Finish())
+	{
+		if(!addPart(part))
+			return;
+	}
+
+	if(!batch.empty() && !m_unhashed->Push(std::move(batch)))
+		return;
+
+	m_unhashed->Close();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.chunk = stats;
+}
+
+/**
+ * HashStage - Fingerprints batches of parts, one of these runs per hash thread
+ */
+void UploadPipeline::HashStage()
+{
+	StageStats stats;
+	PartBatch batch;
+
+	while(m_unhashed->Pop(batch))
+	{
+		auto start = Clock::now();
+
+		std::vector<const uint8_t *> data;
+		std::vector<size_t> sizes;
+		std::vector<Fingerprint> fingerprints(batch.size());
+		for(auto &part : batch)
+		{
+			const auto &partData = part.data;
+			data.push_back(partData.Cast<uint8_t>());
+			sizes.push_back(partData.Size());
+			stats.bytes += part.size;
+		}
+
+		CreateFingerprints(data.data(), sizes.data(), batch.size(), fingerprints.data());
+		for(size_t i = 0; i < batch.size(); i++)
+			batch[i].fingerprint = fingerprints[i];
+
+		stats.items += batch.size();
+		stats.busySeconds += SecondsSince(start);
+
+		start = Clock::now();
+		auto pushed = m_hashed->Push(std::move(batch));
+		stats.stalledSeconds += SecondsSince(start);
+		if(!pushed)
+			return;
+	}
+
+	// The last hasher out closes the queue behind it
+	if(--m_hashersLeft == 0)
+		m_hashed->Close();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.hash.items += stats.items;
+	m_stats.hash.bytes += stats.bytes;
+	m_stats.hash.busySeconds += stats.busySeconds;
+	m_stats.hash.stalledSeconds += stats.stalledSeconds;
+}
+
+/**
+ * DedupeStage - Asks the cloud about parts hasPartsBatch at a time and batches
+ * up the ones it's missing for the senders. Parts that repeat within the file
+ * are only sent once
+ */
+void UploadPipeline::DedupeStage()
+{
+	StageStats stats;
+	std::unordered_set<Fingerprint> queued;
+	PartBatch asking, sending;
+	uint64_t sendingSize = 0;
+	uint64_t partsSkipped = 0, bytesSkipped = 0;
+
+	auto pushSending = [&]()
+		{
+			auto start = Clock::now();
+			auto pushed = m_needed->Push(std::move(sending));
+			stats.stalledSeconds += SecondsSince(start);
+			sending = PartBatch();
+			sendingSize = 0;
+			return pushed;
+		};
+
+	auto ask = [&]()
+		{
+			auto start = Clock::now();
+			auto result = m_cloudApi.HasParts(asking, m_config.shareId);
+			stats.busySeconds += SecondsSince(start);
+			stats.items += asking.size();
+
+			std::vector<bool> needed(asking.size());
+			for(auto index : result.needed)
+				needed[index] = true;
+
+			for(size_t i = 0; i < asking.size(); i++)
+			{
+				auto &part = asking[i];
+				stats.bytes += part.size;
+
+				CloudApi::PartInfo info;
+				info.fingerprint = part.fingerprint;
+				info.offset = part.offset;
+				info.size = part.size;
+				m_parts.push_back(std::move(info));
+
+				if(!needed[i] || !queued.insert(part.fingerprint).second)
+				{
+					partsSkipped++;
+					bytesSkipped += part.size;
+					continue;
+				}
+
+				sendingSize += part.size;
+				sending.push_back(std::move(part));
+				if(sendingSize >= m_config.sendBatchSize && !pushSending())
+					return false;
+			}
+
+			asking.clear();
+			return true;
+		};
+
+	PartBatch batch;
+	while(m_hashed->Pop(batch))
+	{
+		for(auto &part : batch)
+		{
+			asking.push_back(std::move(part));
+			if(asking.size() >= m_config.hasPartsBatch && !ask())
+				return;
+		}
+	}
+
+	if(!asking.empty() && !ask())
+		return;
+
+	if(!sending.empty() && !pushSending())
+		return;
+
+	m_needed->Close();
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.dedupe = stats;
+	m_stats.partsSkipped = partsSkipped;
+	m_stats.bytesSkipped = bytesSkipped;
+}
+
+/**
+ * SendStage - Sends batches of parts the cloud is missing, one of these runs
+ * per send thread
+ */
+void UploadPipeline::SendStage()
+{
+	StageStats stats;
+	PartBatch batch;
+
+	while(m_needed->Pop(batch))
+	{
+		auto start = Clock::now();
+		m_cloudApi.SendParts(batch, m_config.shareId);
+		stats.busySeconds += SecondsSince(start);
+
+		stats.items += batch.size();
+		for(auto &part : batch)
+			stats.bytes += part.size;
+
+		batch.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_stats.send.items += stats.items;
+	m_stats.send.bytes += stats.bytes;
+	m_stats.send.busySeconds += stats.busySeconds;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+namespace Copy {
+	namespace Transfer {
+
+/**
+ * UploadPipeline - Uploads a file with every stage running at once: a reader,
+ * the chunker, a pool of hashing workers, HasParts batching and a pool of
+ * senders, joined by bounded queues. Disk, cpu and network overlap so the
+ * upload runs at the pace of the slowest of them rather than their sum, and
+ * the queues cap how much of the file is held in memory. Once every part is
+ * in the cloud the file is created from them. Files are mapped rather than
+ * read, so parts are fingerprinted and sent straight out of the page cache.
+ * Unmapped files are read by one thread keeping ioDepth reads in flight
+ * through an IO::RequestQueue
+ */
+class UploadPipeline
+{
+public:
+	struct Config
+	{
+		Chunker::Config chunker;
+		uint32_t readSize = 8 * 1024 * 1024;		// Bytes read from the file at a time
+		uint32_t queueDepth = 8;					// Items each queue holds before its producer blocks
+		uint32_t hashThreads = 0;					// 0 uses one per core
+		uint32_t hashBatch = 8;						// Parts fingerprinted together
+		uint32_t hasPartsBatch = 64;				// Parts asked about per HasParts request
+		uint32_t sendBatchSize = 8 * 1024 * 1024;	// Part bytes per SendParts request
+		uint32_t sendThreads = 4;					// SendParts requests running at once
+		uint64_t shareId = 0;
+		bool mapFile = true;						// Map files instead of reading them into memory
+		uint32_t ioDepth = 32;						// Reads in flight when the file isn't mapped
+		uint32_t ioSize = 256 * 1024;				// Bytes per read when the file isn't mapped
+		bool directIo = false;						// Read unmapped files around the page cache
+	};
+
+	// Where a stage spent its time, busy and stalled are summed over its threads
+	struct StageStats
+	{
+		uint32_t threads = 1;
+		uint64_t items = 0;
+		uint64_t bytes = 0;
+		double busySeconds = 0;			// Doing its own work
+		double stalledSeconds = 0;		// Blocked on a full queue downstream
+
+		double Utilization(double elapsedSeconds) const
+		{
+			return elapsedSeconds > 0 ? busySeconds / (elapsedSeconds * threads) : 0;
+		}
+	};
+
+	struct Stats
+	{
+		StageStats read;
+		StageStats chunk;
+		StageStats hash;
+		StageStats dedupe;
+		StageStats send;
+		double elapsedSeconds = 0;
+		uint64_t partsSkipped = 0;		// Parts the cloud already had or that repeat in the file
+		uint64_t bytesSkipped = 0;
+	};
+
+	UploadPipeline(CloudApi &cloudApi);
+	UploadPipeline(CloudApi &cloudApi, const Config &config);
+
+	std::vector<CloudApi::PartInfo> Upload(const std::string &filePath, const std::string &cloudPath);
+	std::vector<CloudApi::PartInfo> Upload(std::istream &stream, const std::string &cloudPath);
+
+	const Stats &GetStats() const { return m_stats; }
+
+protected:
+	typedef std::vector<CloudApi::PartInfo> PartBatch;
+	typedef std::chrono::steady_clock Clock;
+
+	static double SecondsSince(Clock::time_point start);
+
+	std::vector<CloudApi::PartInfo> Run(const std::function<void ()> &readStage, const std::string &cloudPath);
+	void RunStage(const std::function<void ()> &stage);
+	void Fail(std::exception_ptr error);
+
+	void ReadStage(std::istream &stream);
+	void ReadStage(IO::MappedFile &file);
+	void ReadStage(IO::File &file);
+	void ChunkStage();
+	void HashStage();
+	void DedupeStage();
+	void SendStage();
+
+	CloudApi &m_cloudApi;
+	Config m_config;
+	uint32_t m_hashThreads;
+	IO::MappedFile *m_mapped = nullptr;			// The file being uploaded, when it's mapped
+
+	std::unique_ptr<BoundedQueue<Data>> m_blocks;
+	std::unique_ptr<BoundedQueue<PartBatch>> m_unhashed;
+	std::unique_ptr<BoundedQueue<PartBatch>> m_hashed;
+	std::unique_ptr<BoundedQueue<PartBatch>> m_needed;
+	std::atomic<uint32_t> m_hashersLeft;
+
+	std::mutex m_lock;
+	std::exception_ptr m_error;
+	Stats m_stats;
+	std::vector<CloudApi::PartInfo> m_parts;		// Every part without its data, in dedupe order
+};
+
+	}
+}
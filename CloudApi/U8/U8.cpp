@@ -1,9 +1,29 @@
 #include "Common.h"
 #include "U8.h"
+#include "U8Kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define U8_HAS_SSE2
+#endif
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
 
 using namespace Copy;
 
-// Table defining lengths of character sequences in UTF-8
+namespace {
+
+enum Kernel
+{
+	KERNEL_SCALAR,
+	KERNEL_SSSE3,
+	KERNEL_AVX2,
+};
+
+// Table defining lengths of character sequences in UTF-8, bytes that can't
+// start a character are taken one at a time
 static uint8_t g_u8CharSize[256] =
 {
 	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,     // 0x00
@@ -21,9 +41,138 @@ static uint8_t g_u8CharSize[256] =
 	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,     // 0xC0
 	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,     // 0xD0
 	3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,     // 0xE0
-	4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 1, 1      // 0xF0
+	4, 4, 4, 4, 4, 4, 4, 4, 1, 1, 1, 1, 1, 1, 1, 1      // 0xF0	Illegal past 0xF7
 };
 
+/**
+ * DetectKernel - Picks the widest validation kernel the cpu and os support
+ */
+Kernel DetectKernel()
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return KERNEL_AVX2;
+	else if(__builtin_cpu_supports("ssse3"))
+		return KERNEL_SSSE3;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	auto maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	auto ssse3 = (info[2] & (1 << 9)) != 0;
+
+	// The os has to save the ymm registers for avx2
+	if(maxLeaf >= 7 && (info[2] & (1 << 27)) && (_xgetbv(0) & 0x06) == 0x06)
+	{
+		__cpuidex(info, 7, 0);
+		if(info[1] & (1 << 5))
+			return KERNEL_AVX2;
+	}
+
+	if(ssse3)
+		return KERNEL_SSSE3;
+#endif
+	return KERNEL_SCALAR;
+}
+
+Kernel GetKernel()
+{
+	static const auto kernel = DetectKernel();
+	return kernel;
+}
+
+inline bool IsContinuation(uint8_t chr)
+{
+	return (chr & 0xC0) == 0x80;
+}
+
+/**
+ * ValidateScalar - Checks a character at a time, skipping runs of ascii
+ */
+bool ValidateScalar(const uint8_t *bytes, size_t size)
+{
+	auto end = bytes + size;
+
+	while(bytes < end)
+	{
+		uint8_t lead = *bytes;
+		if(lead < 0x80)
+		{
+			bytes += U8::AsciiLength(reinterpret_cast<const char *>(bytes), end - bytes);
+			continue;
+		}
+
+		// The second byte's range is narrowed for the leads that could start an
+		// overlong form, a surrogate or something past U+10FFFF
+		size_t length;
+		uint8_t low = 0x80, high = 0xBF;
+		if(lead >= 0xC2 && lead <= 0xDF)
+			length = 2;
+		else if(lead >= 0xE0 && lead <= 0xEF)
+		{
+			length = 3;
+			if(lead == 0xE0)
+				low = 0xA0;
+			else if(lead == 0xED)
+				high = 0x9F;
+		}
+		else if(lead >= 0xF0 && lead <= 0xF4)
+		{
+			length = 4;
+			if(lead == 0xF0)
+				low = 0x90;
+			else if(lead == 0xF4)
+				high = 0x8F;
+		}
+		else
+			return false;
+
+		if(static_cast<size_t>(end - bytes) < length || bytes[1] < low || bytes[1] > high)
+			return false;
+
+		for(size_t i = 2; i < length; i++)
+		{
+			if(!IsContinuation(bytes[i]))
+				return false;
+		}
+
+		bytes += length;
+	}
+
+	return true;
+}
+
+#if defined(U8_HAS_SSE2)
+
+/**
+ * CrossesPage - Returns true if 16 bytes from data run into the next 4KB page,
+ * where a string that has ended might not be mapped
+ */
+inline bool CrossesPage(const char *data)
+{
+	return (reinterpret_cast<uintptr_t>(data) & 4095) > 4096 - 16;
+}
+
+#endif
+
+}
+
+/**
+ * GetKernelName - Returns which validation kernel this cpu runs
+ */
+const char *U8::GetKernelName()
+{
+	bool valid;
+	switch(GetKernel())
+	{
+		case KERNEL_AVX2: return Kernels::ValidateAvx2(nullptr, 0, valid) ? "avx2" : "scalar";
+		case KERNEL_SSSE3: return Kernels::ValidateSsse3(nullptr, 0, valid) ? "ssse3" : "scalar";
+		default: return "scalar";
+	}
+}
+
 /**
  * CharSize - This function will return the number of bytes required for the
  *	given UTF-8 character.
@@ -34,29 +183,125 @@ uint32_t U8::CharSize(const char *text)
 }
 
 /**
- * NextChar - Proceeds to the next logical utf8 character
+ * NextChar - Proceeds to the next logical utf8 character. A character cut short
+ *	ends at the first byte that doesn't continue it, so this never steps past
+ *	a nul
  */
 char *U8::NextChar(const char *str)
 {
-	return const_cast<char *>(&str[CharSize(str)]);
+	auto bytes = reinterpret_cast<const uint8_t *>(str);
+	if(bytes[0] < 0x80)
+		return const_cast<char *>(str + 1);
+
+	uint32_t size = CharSize(str), pos = 1;
+	while(pos < size && IsContinuation(bytes[pos]))
+		pos++;
+
+	return const_cast<char *>(str + pos);
 }
 
 /**
- * StringLength - Returns the logical character count in a utf8 string
+ * StringLength - Returns the logical character count in a nul terminated utf8
+ *	string
  */
 uint32_t U8::StringLength(const char *str)
 {
-	uint32_t count = 0;
+	return static_cast<uint32_t>(StringLength(str, strlen(str)));
+}
+
+/**
+ * StringLength - Returns the logical character count in size bytes of utf8,
+ *	which is every byte that isn't a continuation
+ */
+size_t U8::StringLength(const char *str, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(str);
+	size_t count = 0, pos = 0;
 
-	while(*str)
+#if defined(U8_HAS_SSE2)
+	// Continuations are 0x80-0xBF, the only bytes at or below -65 signed. Each
+	// lane counts the bytes that start a character for up to 255 blocks, then
+	// sad adds the lanes up
+	auto continuation = _mm_set1_epi8(-65);
+	auto zero = _mm_setzero_si128();
+	while(pos + 16 <= size)
 	{
-		count++;
-		str = NextChar(str);
+		auto counts = zero;
+		for(uint32_t blocks = 0; blocks < 255 && pos + 16 <= size; blocks++, pos += 16)
+		{
+			auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + pos));
+			counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(v, continuation));
+		}
+
+		auto sums = _mm_sad_epu8(counts, zero);
+		count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
 	}
+#endif
+
+	for(; pos < size; pos++)
+		count += !IsContinuation(bytes[pos]);
 
 	return count;
 }
 
+/**
+ * AsciiLength - Returns how many bytes at the start of str are ascii
+ */
+size_t U8::AsciiLength(const char *str, size_t size)
+{
+	auto bytes = reinterpret_cast<const uint8_t *>(str);
+	size_t pos = 0;
+
+#if defined(U8_HAS_SSE2)
+	for(; pos + 16 <= size; pos += 16)
+	{
+		auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes + pos))));
+		if(mask)
+			return pos + CountTrailingZeros(mask);
+	}
+#else
+	for(; pos + 8 <= size; pos += 8)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + pos, sizeof(word));
+		if(word & 0x8080808080808080ull)
+			break;
+	}
+#endif
+
+	while(pos < size && bytes[pos] < 0x80)
+		pos++;
+
+	return pos;
+}
+
+/**
+ * Append - Appends a code point to str as utf8
+ */
+void U8::Append(uint32_t codepoint, std::string &str)
+{
+	if(codepoint < 0x80)
+		str += static_cast<char>(codepoint);
+	else if(codepoint < 0x800)
+	{
+		str += static_cast<char>(0xC0 | codepoint >> 6);
+		str += static_cast<char>(0x80 | (codepoint & 0x3F));
+	}
+	else if(codepoint < 0x10000)
+	{
+		str += static_cast<char>(0xE0 | codepoint >> 12);
+		str += static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+		str += static_cast<char>(0x80 | (codepoint & 0x3F));
+	}
+	else
+	{
+		str += static_cast<char>(0xF0 | codepoint >> 18);
+		str += static_cast<char>(0x80 | (codepoint >> 12 & 0x3F));
+		str += static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+		str += static_cast<char>(0x80 | (codepoint & 0x3F));
+	}
+}
+
 /**
  * CompareNoCase - This function will compare two strings and return 0 if the two
  *	strings are identical, without comparing case (for ascii characters only),
@@ -107,25 +352,48 @@ int U8::CompareNoCase(const char *str1, const char *str2, uint32_t count)
  */
 int U8::Compare(const char *str1, const char *str2, uint32_t count)
 {
-	uint32_t size;
+#if defined(U8_HAS_SSE2)
+	// While more characters are left than a block can hold, blocks that match
+	// and have no nul are skipped 16 bytes at a time
+	auto zero = _mm_setzero_si128();
+	auto continuation = _mm_set1_epi8(-65);
+	while(count > 16 && !CrossesPage(str1) && !CrossesPage(str2))
+	{
+		auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str1));
+		auto v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str2));
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(v1, v2)) != 0xFFFF || _mm_movemask_epi8(_mm_cmpeq_epi8(v1, zero)))
+			break;
+
+		// A character the block cuts in two is left for the next one
+		auto starts = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(v1, continuation)));
+		uint32_t advance = 16;
+		if(starts)
+		{
+			auto last = 31 - CountLeadingZeros(starts);
+			if(last + CharSize(str1 + last) > 16)
+			{
+				advance = last;
+				starts &= ~(1u << last);
+			}
+		}
+
+		if(!advance)
+			break;
+
+		str1 += advance;
+		str2 += advance;
+		count -= CountBits(starts);
+	}
+#endif
 
 	// Loop until a difference found, end of string, or count exhausted
 	while(*str1 && count)
 	{
-		// Get the size of this chr
-		size = CharSize(str1);
-
-		// While we have bytes in the character to compare
-		while(size)
+		// Compare the bytes of this character, a nul cuts it short
+		auto size = CharSize(str1);
+		while(size && *str1 && *str1 == *str2)
 		{
-			// If this character is different
-			if(*str1 != *str2)
-				break;
-
-			// One less byte in this character
 			size--;
-
-			// Point to the next byte
 			str1++;
 			str2++;
 		}
@@ -150,3 +418,28 @@ int U8::Compare(const char *str1, const char *str2, uint32_t count)
 	else
 		return 0;
 }
+
+/**
+ * IsValid - Returns true if size bytes at str are well formed utf8, no overlong
+ *	forms, surrogates or code points past U+10FFFF
+ */
+bool U8::IsValid(const char *str, size_t size)
+{
+	// Leading ascii is skipped before any kernel is set up, past that even a
+	// short string checks faster in a kernel than a character at a time
+	auto ascii = AsciiLength(str, size);
+	auto bytes = reinterpret_cast<const uint8_t *>(str) + ascii;
+	size -= ascii;
+
+	if(size)
+	{
+		bool valid;
+		auto kernel = GetKernel();
+		if(kernel == KERNEL_AVX2 && Kernels::ValidateAvx2(bytes, size, valid))
+			return valid;
+		else if(kernel >= KERNEL_SSSE3 && Kernels::ValidateSsse3(bytes, size, valid))
+			return valid;
+	}
+
+	return ValidateScalar(bytes, size);
+}
@@ -6,8 +6,13 @@ namespace Copy {
 uint32_t CharSize(const char *text);
 char *NextChar(const char *str);
 uint32_t StringLength(const char *str);
+size_t StringLength(const char *str, size_t size);
 int CompareNoCase(const char *str1, const char *str2, uint32_t length = -1);
 int Compare(const char *str1, const char *str2, uint32_t length = -1);
+bool IsValid(const char *str, size_t size);
+size_t AsciiLength(const char *str, size_t size);
+void Append(uint32_t codepoint, std::string &str);
+const char *GetKernelName();
 
 	}
 }
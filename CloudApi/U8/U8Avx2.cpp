@@ -0,0 +1,134 @@
+// Built with avx2 enabled, so this must not include Common.h or anything else with
+// inline code shared with the rest of the library
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "U8Kernels.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+using namespace Copy::U8::Kernels;
+
+namespace {
+
+// The same 16 entries in both lanes, pshufb looks up within each lane
+inline __m256i Table(const uint8_t (&table)[16])
+{
+	return _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(table)));
+}
+
+/**
+ * Previous - The bytes count places back, the first ones from the end of the
+ * last block
+ */
+template<int count>
+inline __m256i Previous(__m256i v, __m256i previous)
+{
+	return _mm256_alignr_epi8(v, _mm256_permute2x128_si256(previous, v, 0x21), 16 - count);
+}
+
+inline __m256i HighNibble(__m256i v)
+{
+	return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+}
+
+/**
+ * Checker - Carries what the last 32 bytes left unfinished into the next 32
+ */
+class Checker
+{
+public:
+	Checker() :
+		m_firstHigh(Table(s_firstHigh)), m_firstLow(Table(s_firstLow)), m_secondHigh(Table(s_secondHigh)),
+		m_error(_mm256_setzero_si256()), m_previous(_mm256_setzero_si256()), m_incomplete(_mm256_setzero_si256())
+	{
+		// The last three bytes of a block can't be leads still waiting for more
+		static const uint8_t limits[32] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1 };
+		m_limits = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(limits));
+	}
+
+	void Check(__m256i v)
+	{
+		// An ascii block is only wrong if the one before it ended mid character
+		if(!_mm256_movemask_epi8(v))
+		{
+			m_error = _mm256_or_si256(m_error, m_incomplete);
+			m_incomplete = _mm256_setzero_si256();
+			m_previous = v;
+			return;
+		}
+
+		auto previous1 = Previous<1>(v, m_previous);
+		auto special = _mm256_and_si256(_mm256_and_si256(_mm256_shuffle_epi8(m_firstHigh, HighNibble(previous1)),
+			_mm256_shuffle_epi8(m_firstLow, _mm256_and_si256(previous1, _mm256_set1_epi8(0x0F)))),
+			_mm256_shuffle_epi8(m_secondHigh, HighNibble(v)));
+
+		// Two continuations in a row are only allowed two or three bytes after a 3 or 4 byte lead
+		auto previous2 = Previous<2>(v, m_previous);
+		auto previous3 = Previous<3>(v, m_previous);
+		auto third = _mm256_subs_epu8(previous2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		auto fourth = _mm256_subs_epu8(previous3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		auto needsTwo = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+		m_error = _mm256_or_si256(m_error, _mm256_xor_si256(needsTwo, special));
+		m_incomplete = _mm256_subs_epu8(v, m_limits);
+		m_previous = v;
+	}
+
+	bool IsValid()
+	{
+		auto error = _mm256_or_si256(m_error, m_incomplete);
+		return _mm256_testz_si256(error, error) != 0;
+	}
+
+private:
+	__m256i m_firstHigh;
+	__m256i m_firstLow;
+	__m256i m_secondHigh;
+	__m256i m_limits;
+
+	__m256i m_error;
+	__m256i m_previous;
+	__m256i m_incomplete;
+};
+
+}
+
+#endif
+
+namespace Copy {
+	namespace U8 {
+		namespace Kernels {
+
+bool ValidateAvx2(const uint8_t *data, size_t size, bool &valid)
+{
+#ifdef __AVX2__
+	Checker checker;
+
+	size_t pos = 0;
+	for(; pos + 32 <= size; pos += 32)
+		checker.Check(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos)));
+
+	// The tail is padded with nul, which is ascii
+	if(pos < size)
+	{
+		uint8_t tail[32] = { 0 };
+		memcpy(tail, data + pos, size - pos);
+		checker.Check(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(tail)));
+	}
+
+	valid = checker.IsValid();
+	return true;
+#else
+	return false;
+#endif
+}
+
+		}
+	}
+}
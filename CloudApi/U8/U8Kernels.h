@@ -0,0 +1,89 @@
+#pragma once
+
+namespace Copy {
+	namespace U8 {
+		namespace Kernels {
+
+/**
+ * Validation by table lookup (Keiser and Lemire), every byte is checked against
+ * the one before it in three 16 entry tables indexed by the high nibble of the
+ * previous byte, its low nibble and the high nibble of this byte. Each bit is
+ * one kind of error, a byte pair is bad when all three tables agree on a bit.
+ * The tables only depend on nibbles so pshufb does each lookup for a whole
+ * register at once
+ */
+enum Error
+{
+	TOO_SHORT = 1 << 0,			// A lead not followed by enough continuations
+	TOO_LONG = 1 << 1,			// A continuation after ascii
+	OVERLONG_3 = 1 << 2,		// E0 80-9F
+	TOO_LARGE = 1 << 3,			// F4 90-BF, or any continuation after F5-FF
+	SURROGATE = 1 << 4,			// ED A0-BF
+	OVERLONG_2 = 1 << 5,		// C0 or C1 lead
+	TOO_LARGE_1000 = 1 << 6,	// F5-FF 80-8F
+	OVERLONG_4 = 1 << 6,		// F0 80-8F
+	TWO_CONTS = 1 << 7,			// Two continuations, fine only inside a 3 or 4 byte character
+	CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS,
+};
+
+static const uint8_t s_firstHigh[16] =
+{
+	// Ascii
+	TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+	// Continuation
+	TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+	// Two byte leads, C0 and C1 are overlong
+	TOO_SHORT | OVERLONG_2,
+	TOO_SHORT,
+	// Three byte leads
+	TOO_SHORT | OVERLONG_3 | SURROGATE,
+	// Four byte leads
+	TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+};
+
+static const uint8_t s_firstLow[16] =
+{
+	CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+	CARRY | OVERLONG_2,
+	CARRY,
+	CARRY,
+	CARRY | TOO_LARGE,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+	CARRY | TOO_LARGE | TOO_LARGE_1000,
+};
+
+static const uint8_t s_secondHigh[16] =
+{
+	// Ascii
+	TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+	// 80-8F
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+	// 90-9F
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+	// A0-BF
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+	TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+	// Leads
+	TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+};
+
+/**
+ * Validation backends, each checks size bytes at data. They return false when
+ * the backend wasn't built for this target, the caller must check the cpu
+ * supports it before calling
+ */
+bool ValidateAvx2(const uint8_t *data, size_t size, bool &valid);
+bool ValidateSsse3(const uint8_t *data, size_t size, bool &valid);
+
+		}
+	}
+}
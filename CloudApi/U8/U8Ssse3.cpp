@@ -0,0 +1,122 @@
+// Built with ssse3 enabled, so this must not include Common.h or anything else with
+// inline code shared with the rest of the library
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "U8Kernels.h"
+
+#ifdef __SSSE3__
+
+#include <tmmintrin.h>
+
+using namespace Copy::U8::Kernels;
+
+namespace {
+
+inline __m128i Table(const uint8_t (&table)[16])
+{
+	return _mm_loadu_si128(reinterpret_cast<const __m128i *>(table));
+}
+
+inline __m128i HighNibble(__m128i v)
+{
+	return _mm_and_si128(_mm_srli_epi16(v, 4), _mm_set1_epi8(0x0F));
+}
+
+/**
+ * Checker - Carries what the last 16 bytes left unfinished into the next 16
+ */
+class Checker
+{
+public:
+	Checker() :
+		m_firstHigh(Table(s_firstHigh)), m_firstLow(Table(s_firstLow)), m_secondHigh(Table(s_secondHigh)),
+		m_error(_mm_setzero_si128()), m_previous(_mm_setzero_si128()), m_incomplete(_mm_setzero_si128())
+	{
+		// The last three bytes of a block can't be leads still waiting for more
+		static const uint8_t limits[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1 };
+		m_limits = Table(limits);
+	}
+
+	void Check(__m128i v)
+	{
+		// An ascii block is only wrong if the one before it ended mid character
+		if(!_mm_movemask_epi8(v))
+		{
+			m_error = _mm_or_si128(m_error, m_incomplete);
+			m_incomplete = _mm_setzero_si128();
+			m_previous = v;
+			return;
+		}
+
+		auto previous1 = _mm_alignr_epi8(v, m_previous, 15);
+		auto special = _mm_and_si128(_mm_and_si128(_mm_shuffle_epi8(m_firstHigh, HighNibble(previous1)),
+			_mm_shuffle_epi8(m_firstLow, _mm_and_si128(previous1, _mm_set1_epi8(0x0F)))),
+			_mm_shuffle_epi8(m_secondHigh, HighNibble(v)));
+
+		// Two continuations in a row are only allowed two or three bytes after a 3 or 4 byte lead
+		auto previous2 = _mm_alignr_epi8(v, m_previous, 14);
+		auto previous3 = _mm_alignr_epi8(v, m_previous, 13);
+		auto third = _mm_subs_epu8(previous2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+		auto fourth = _mm_subs_epu8(previous3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+		auto needsTwo = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+
+		m_error = _mm_or_si128(m_error, _mm_xor_si128(needsTwo, special));
+		m_incomplete = _mm_subs_epu8(v, m_limits);
+		m_previous = v;
+	}
+
+	bool IsValid()
+	{
+		auto error = _mm_or_si128(m_error, m_incomplete);
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+	}
+
+private:
+	__m128i m_firstHigh;
+	__m128i m_firstLow;
+	__m128i m_secondHigh;
+	__m128i m_limits;
+
+	__m128i m_error;
+	__m128i m_previous;
+	__m128i m_incomplete;
+};
+
+}
+
+#endif
+
+namespace Copy {
+	namespace U8 {
+		namespace Kernels {
+
+bool ValidateSsse3(const uint8_t *data, size_t size, bool &valid)
+{
+#ifdef __SSSE3__
+	Checker checker;
+
+	size_t pos = 0;
+	for(; pos + 16 <= size; pos += 16)
+		checker.Check(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos)));
+
+	// The tail is padded with nul, which is ascii
+	if(pos < size)
+	{
+		uint8_t tail[16] = { 0 };
+		memcpy(tail, data + pos, size - pos);
+		checker.Check(_mm_loadu_si128(reinterpret_cast<const __m128i *>(tail)));
+	}
+
+	valid = checker.IsValid();
+	return true;
+#else
+	return false;
+#endif
+}
+
+		}
+	}
+}
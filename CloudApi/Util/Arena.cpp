@@ -0,0 +1,73 @@
+#include "Common.h"
+
+using namespace Copy;
+
+const size_t Arena::ALIGNMENT;
+const size_t Arena::MAX_BLOCK_SIZE;
+
+/**
+ * Arena - blockSize is the first block's size, each block after that is twice
+ * the last up to MAX_BLOCK_SIZE
+ */
+Arena::Arena(size_t blockSize) :
+	m_blockSize(std::max<size_t>(blockSize, 1024))
+{
+}
+
+Arena::~Arena()
+{
+	Reset();
+}
+
+/**
+ * Allocate - Returns size bytes aligned to ALIGNMENT, valid until the arena is
+ * reset or destroyed
+ */
+void *Arena::Allocate(size_t size)
+{
+	size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	m_size += size;
+
+	if(size > static_cast<size_t>(m_end - m_next))
+		return AllocateBlock(size);
+
+	auto bytes = m_next;
+	m_next += size;
+	return bytes;
+}
+
+/**
+ * AllocateBlock - Starts a new block for an allocation that doesn't fit in the
+ * current one. Allocations over a quarter of a block get one of their own, and the
+ * current block stays in use for what comes after them
+ */
+void *Arena::AllocateBlock(size_t size)
+{
+	if(size > m_blockSize / 4)
+	{
+		auto block = BufferPool::Get().Allocate(size);
+		m_blocks.push_back(block);
+		return block->Bytes();
+	}
+
+	auto block = BufferPool::Get().Allocate(m_blockSize);
+	m_blocks.push_back(block);
+	m_blockSize = std::min(m_blockSize * 2, MAX_BLOCK_SIZE);
+
+	m_next = block->Bytes() + size;
+	m_end = block->Bytes() + block->capacity;
+	return block->Bytes();
+}
+
+/**
+ * Reset - Hands every block back to the pool, everything allocated is gone
+ */
+void Arena::Reset()
+{
+	for(auto block : m_blocks)
+		BufferPool::Get().Release(block);
+
+	m_blocks.clear();
+	m_next = m_end = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+namespace Copy {
+
+/**
+ * Arena - A monotonic allocator. Memory is handed out from BufferPool blocks
+ * one allocation after another and nothing is freed on its own, every block
+ * goes back to the pool at once when the arena is reset or destroyed. Nothing
+ * allocated here has its destructor run, so it's for plain structures only
+ */
+class Arena
+{
+public:
+	static const size_t ALIGNMENT = 8;
+	static const size_t MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	Arena(size_t blockSize = 64 * 1024);
+	~Arena();
+
+	void *Allocate(size_t size);
+
+	template<class T>
+	T *Allocate(size_t count)
+	{
+		return static_cast<T *>(Allocate(count * sizeof(T)));
+	}
+
+	void Reset();
+
+	size_t GetSize() const { return m_size; }
+
+protected:
+	Arena(const Arena &);
+	Arena & operator = (const Arena &);
+
+	void *AllocateBlock(size_t size);
+
+	std::vector<BufferPool::Block *> m_blocks;
+	uint8_t *m_next = nullptr;
+	uint8_t *m_end = nullptr;
+	size_t m_blockSize;
+	size_t m_size = 0;				// Bytes handed out
+};
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace Copy {
+
+	/**
+	 * CountTrailingZeros - Returns the position of the lowest set bit, bits
+	 * must not be 0
+	 */
+	inline uint32_t CountTrailingZeros(uint32_t bits)
+	{
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, bits);
+		return index;
+	#else
+		return __builtin_ctz(bits);
+	#endif
+	}
+
+	inline uint32_t CountTrailingZeros(uint64_t bits)
+	{
+	#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return index;
+	#elif defined(_MSC_VER)
+		unsigned long index;
+		if(_BitScanForward(&index, static_cast<uint32_t>(bits)))
+			return index;
+		_BitScanForward(&index, static_cast<uint32_t>(bits >> 32));
+		return index + 32;
+	#else
+		return __builtin_ctzll(bits);
+	#endif
+	}
+
+	/**
+	 * CountLeadingZeros - Returns how many bits sit above the highest set bit,
+	 * bits must not be 0
+	 */
+	inline uint32_t CountLeadingZeros(uint32_t bits)
+	{
+	#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, bits);
+		return 31 - index;
+	#else
+		return __builtin_clz(bits);
+	#endif
+	}
+
+	/**
+	 * CountBits - Returns how many bits are set, without needing popcnt
+	 */
+	inline uint32_t CountBits(uint32_t bits)
+	{
+		bits = bits - (bits >> 1 & 0x55555555);
+		bits = (bits & 0x33333333) + (bits >> 2 & 0x33333333);
+		return ((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101 >> 24;
+	}
+}
@@ -0,0 +1,148 @@
+#include "Common.h"
+
+using namespace Copy;
+
+/**
+ * Get - The pool every Data draws from. It's never destroyed, Data living in
+ * other statics can still hand their blocks back during exit
+ */
+BufferPool &BufferPool::Get()
+{
+	static BufferPool *pool = new BufferPool();
+	return *pool;
+}
+
+/**
+ * BufferPool - cacheLimit caps the bytes kept on the free lists, blocks freed
+ * past it go back to the heap
+ */
+BufferPool::BufferPool(size_t cacheLimit) :
+	m_cacheLimit(cacheLimit), m_cachedBytes(0), m_allocations(0), m_reuses(0)
+{
+}
+
+BufferPool::~BufferPool()
+{
+	Trim();
+}
+
+/**
+ * ClassOf - Returns the class whose blocks hold capacity bytes, or NO_CLASS
+ * when it's bigger than any of them
+ */
+uint32_t BufferPool::ClassOf(size_t capacity)
+{
+	uint32_t bits = MIN_CLASS_BITS;
+	while(bits <= MAX_CLASS_BITS && (static_cast<size_t>(1) << bits) < capacity)
+		bits++;
+
+	return bits - MIN_CLASS_BITS;
+}
+
+/**
+ * Allocate - Returns a block of at least capacity bytes holding one reference,
+ * its bytes are left as they are
+ */
+BufferPool::Block *BufferPool::Allocate(size_t capacity)
+{
+	auto sizeClass = ClassOf(capacity);
+	Block *block = nullptr;
+
+	if(sizeClass != NO_CLASS)
+	{
+		auto &freeList = m_classes[sizeClass];
+		std::lock_guard<std::mutex> lock(freeList.lock);
+		if(!freeList.free.empty())
+		{
+			block = freeList.free.back();
+			freeList.free.pop_back();
+		}
+	}
+
+	if(block)
+	{
+		m_cachedBytes -= block->capacity;
+		m_reuses++;
+	}
+	else
+	{
+		auto blockCapacity = sizeClass != NO_CLASS ? static_cast<size_t>(1) << (sizeClass + MIN_CLASS_BITS) : capacity;
+		auto memory = malloc(HEADER_SIZE + blockCapacity);
+		if(!memory)
+			throw std::bad_alloc();
+
+		block = new(memory) Block();
+		block->sizeClass = sizeClass;
+		block->capacity = blockCapacity;
+		m_allocations++;
+	}
+
+	block->refs.store(1, std::memory_order_relaxed);
+	return block;
+}
+
+/**
+ * Release - Drops a reference, the last one puts the block on its free list or
+ * back on the heap if the cache is full
+ */
+void BufferPool::Release(Block *block)
+{
+	if(block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	if(block->sizeClass != NO_CLASS && m_cachedBytes + block->capacity <= m_cacheLimit)
+	{
+		auto &freeList = m_classes[block->sizeClass];
+		std::lock_guard<std::mutex> lock(freeList.lock);
+		freeList.free.push_back(block);
+		m_cachedBytes += block->capacity;
+		return;
+	}
+
+	Free(block);
+}
+
+void BufferPool::Free(Block *block)
+{
+	block->~Block();
+	free(block);
+}
+
+/**
+ * SetCacheLimit - Changes how many bytes the free lists may hold, anything
+ * already over it is only let go by Trim
+ */
+void BufferPool::SetCacheLimit(size_t cacheLimit)
+{
+	m_cacheLimit = cacheLimit;
+}
+
+/**
+ * Trim - Gives every free block back to the heap
+ */
+void BufferPool::Trim()
+{
+	for(auto &sizeClass : m_classes)
+	{
+		std::vector<Block *> blocks;
+		{
+			std::lock_guard<std::mutex> lock(sizeClass.lock);
+			blocks.swap(sizeClass.free);
+		}
+
+		for(auto block : blocks)
+		{
+			m_cachedBytes -= block->capacity;
+			Free(block);
+		}
+	}
+}
+
+BufferPool::Stats BufferPool::GetStats() const
+{
+	Stats stats;
+	stats.allocations = m_allocations;
+	stats.reuses = m_reuses;
+	stats.cachedBytes = m_cachedBytes;
+	return stats;
+}
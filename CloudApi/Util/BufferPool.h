@@ -0,0 +1,80 @@
+#pragma once
+
+namespace Copy {
+
+/**
+ * BufferPool - Where Data gets its storage. Sizes are rounded up to a power of
+ * two class and freed blocks are kept on their class's free list, so buffers
+ * of the same size (parts, request bodies) are recycled rather than going back
+ * to the heap. Blocks carry their own reference count, which is what lets Data
+ * share and slice storage without a separate control block. Blocks too big for
+ * any class go straight to the heap and back
+ */
+class BufferPool
+{
+public:
+	static const uint32_t MIN_CLASS_BITS = 6;		// 64 bytes
+	static const uint32_t MAX_CLASS_BITS = 26;		// 64MB
+	static const uint32_t CLASS_COUNT = MAX_CLASS_BITS - MIN_CLASS_BITS + 1;
+	static const uint32_t NO_CLASS = CLASS_COUNT;
+
+	/**
+	 * Block - A header followed by capacity bytes
+	 */
+	struct Block
+	{
+		std::atomic<uint32_t> refs;
+		uint32_t sizeClass;
+		size_t capacity;
+
+		uint8_t *Bytes() { return reinterpret_cast<uint8_t *>(this) + HEADER_SIZE; }
+
+		void AddRef() { refs.fetch_add(1, std::memory_order_relaxed); }
+		bool IsShared() const { return refs.load(std::memory_order_acquire) != 1; }
+	};
+
+	// Keeps the bytes after the header as aligned as the heap would have them
+	static const size_t HEADER_SIZE = 64;
+
+	struct Stats
+	{
+		uint64_t allocations = 0;		// Blocks taken from the heap
+		uint64_t reuses = 0;			// Blocks taken from a free list
+		uint64_t cachedBytes = 0;		// Capacity sitting on the free lists
+	};
+
+	static BufferPool &Get();
+
+	BufferPool(size_t cacheLimit = 256 * 1024 * 1024);
+	~BufferPool();
+
+	Block *Allocate(size_t capacity);
+	void Release(Block *block);
+
+	void SetCacheLimit(size_t cacheLimit);
+	void Trim();
+
+	Stats GetStats() const;
+
+protected:
+	BufferPool(const BufferPool &);
+	BufferPool & operator = (const BufferPool &);
+
+	struct SizeClass
+	{
+		std::mutex lock;
+		std::vector<Block *> free;
+	};
+
+	static uint32_t ClassOf(size_t capacity);
+	static void Free(Block *block);
+
+	SizeClass m_classes[CLASS_COUNT];
+
+	std::atomic<size_t> m_cacheLimit;
+	std::atomic<uint64_t> m_cachedBytes;
+	std::atomic<uint64_t> m_allocations;
+	std::atomic<uint64_t> m_reuses;
+};
+
+}
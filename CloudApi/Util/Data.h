@@ -2,12 +2,22 @@
 
 namespace Copy {
 
+/**
+ * Data - A byte buffer. Its storage is a reference counted BufferPool block, so
+ * copies and slices share the block rather than the bytes, and a buffer's
+ * storage is recycled for the next one once the last reference is gone. It can
+ * also be a view of memory owned by something else (a mapped file, say), a view
+ * holds on to its owner so the memory stays valid for as long as the view or
+ * any copy of it is around. Reading never copies, anything that changes the
+ * bytes or size of shared storage or a view first copies them into a block of
+ * its own. Growing leaves the new bytes uninitialized
+ */
 class Data
 {
 public:
-	Data(size_t size) 
+	Data(size_t size)
 	{
-		m_data.resize(size);
+		Resize(size);
 	}
 
 	Data()
@@ -16,39 +26,125 @@ public:
 
 	Data(const std::string &string)
 	{
-		for(auto &chr : string)
-			m_data.push_back(chr);
+		Append(string.size(), string.data());
 	}
 
-	size_t Size() const { return m_data.size(); }
-	void Resize(size_t size) { m_data.resize(size); }
+	Data(const Data &data) :
+		m_bytes(data.m_bytes), m_size(data.m_size), m_block(data.m_block), m_owner(data.m_owner)
+	{
+		if(m_block)
+			m_block->AddRef();
+	}
+
+	Data(Data &&data) :
+		m_bytes(data.m_bytes), m_size(data.m_size), m_block(data.m_block), m_owner(std::move(data.m_owner))
+	{
+		data.m_bytes = nullptr;
+		data.m_size = 0;
+		data.m_block = nullptr;
+	}
+
+	~Data()
+	{
+		Release();
+	}
+
+	Data & operator = (Data data)
+	{
+		std::swap(m_bytes, data.m_bytes);
+		std::swap(m_size, data.m_size);
+		std::swap(m_block, data.m_block);
+		std::swap(m_owner, data.m_owner);
+		return *this;
+	}
+
+	/**
+	 * View - Wraps size bytes at data without copying them, owner keeps them valid
+	 */
+	static Data View(const void *data, size_t size, std::shared_ptr<const void> owner)
+	{
+		Data view;
+		view.m_bytes = static_cast<const uint8_t *>(data);
+		view.m_size = size;
+		view.m_owner = std::move(owner);
+		return view;
+	}
+
+	bool IsView() const { return m_owner != nullptr; }
+
+	/**
+	 * Slice - Returns length bytes from offset, sharing this buffer's storage
+	 */
+	Data Slice(size_t offset, size_t length) const
+	{
+		auto bytes = Cast<uint8_t>(offset, length);
+
+		Data slice(*this);
+		slice.m_bytes = bytes;
+		slice.m_size = length;
+		return slice;
+	}
+
+	/**
+	 * Extend - Grows this over next when next carries straight on from it in
+	 * the same storage, so two neighbouring slices join up without a copy
+	 * Returns false, leaving this alone, if they aren't neighbours
+	 */
+	bool Extend(const Data &next)
+	{
+		auto sameStorage = (m_block && m_block == next.m_block) || (m_owner && m_owner == next.m_owner);
+		if(!sameStorage || m_bytes + m_size != next.m_bytes)
+			return false;
+
+		m_size += next.m_size;
+		return true;
+	}
+
+	size_t Size() const { return m_size; }
+
+	/**
+	 * Capacity - Returns how big this can get before its storage is replaced
+	 */
+	size_t Capacity() const { return m_block && !m_owner ? m_block->Bytes() + m_block->capacity - m_bytes : m_size; }
+
+	void Resize(size_t size)
+	{
+		Own(size);
+		m_size = size;
+	}
 
 	size_t PtrToOffset(void *ptr)
 	{
 		// Check to see if it exists
-		if(&m_data[0] > ptr)
+		if(Bytes() > ptr)
 			throw std::logic_error("Invalid cast");
-		
-		auto offset = (size_t) ((uint64_t)ptr - (uint64_t)&m_data[0]);
+
+		auto offset = (size_t) ((uint64_t)ptr - (uint64_t)Bytes());
 
 		if(offset >= Size())
 			throw std::logic_error("Invalid cast");
-		
+
 		return offset;
 	}
 
 	std::string ToString()
 	{
-		std::string string;
-		for(auto &chr : m_data)
-			string.push_back(chr);
-		return string;
+		return std::string(reinterpret_cast<const char *>(Bytes()), Size());
 	}
 
+	/**
+	 * Release - Lets go of the storage, a block goes back to the pool once
+	 * nothing else shares it
+	 */
 	void Release()
 	{
-		m_data.resize(0);
-		m_data.shrink_to_fit();
+		if(m_block)
+			BufferPool::Get().Release(m_block);
+
+		m_bytes = nullptr;
+		m_size = 0;
+		m_block = nullptr;
+		m_owner.reset();
 	}
 
 	template<typename T>
@@ -58,9 +154,22 @@ public:
 		return Cast<T>(Size() - length);
 	}
 
+	/**
+	 * Grow - Adds length uninitialized bytes at the end, storage that runs out
+	 * is replaced by one at least twice the size so appending stays linear
+	 */
 	void Grow(size_t length)
 	{
-		Resize(Size() + length);
+		auto size = m_size + length;
+		if(size > Capacity() || !IsWritable())
+			Own(std::max(size, Capacity() * 2));
+
+		m_size = size;
+	}
+
+	void Reserve(size_t length)
+	{
+		Own(length);
 	}
 
 	void Copy(size_t length, const Data &data)
@@ -95,7 +204,7 @@ public:
 		if(Size() - offset < expectedSize)
 			throw std::logic_error("Bad cast");
 
-		return reinterpret_cast<const T *>(&m_data[offset]);
+		return reinterpret_cast<const T *>(Bytes() + offset);
 	}
 
 	template<typename T>
@@ -104,13 +213,17 @@ public:
 		if(Size() - offset < expectedSize)
 			throw std::logic_error("Bad cast");
 
-		return reinterpret_cast<T *>(&m_data[offset]);
+		Own();
+		return reinterpret_cast<T *>(const_cast<uint8_t *>(m_bytes) + offset);
 	}
 
 	void Append(size_t length, const void *data)
 	{
+		if(!length)
+			return;
+
 		Grow(length);
-		Copy(Size() - length, length, data);
+		memcpy(const_cast<uint8_t *>(m_bytes) + m_size - length, data, length);
 	}
 
 	void Append(const Data &data)
@@ -118,16 +231,43 @@ public:
 		Append(data.Size(), data.Cast<uint8_t>());
 	}
 
-	bool IsEmpty() const { return m_data.empty(); }
+	bool IsEmpty() const { return !Size(); }
 
-	std::vector<uint8_t>::iterator begin() { return m_data.begin(); }
-	std::vector<uint8_t>::iterator end() { return m_data.end(); }
+	uint8_t *begin() { Own(); return const_cast<uint8_t *>(m_bytes); }
+	uint8_t *end() { Own(); return const_cast<uint8_t *>(m_bytes) + m_size; }
 
-	std::vector<uint8_t>::const_iterator begin() const { return m_data.begin(); }
-	std::vector<uint8_t>::const_iterator end() const { return m_data.end(); }
+	const uint8_t *begin() const { return Bytes(); }
+	const uint8_t *end() const { return Bytes() + Size(); }
 
 protected:
-	std::vector<uint8_t> m_data;
+	const uint8_t *Bytes() const { return m_bytes; }
+
+	bool IsWritable() const { return m_block && !m_owner && !m_block->IsShared(); }
+
+	// Makes sure the bytes are this buffer's alone with room for capacity of
+	// them, copying them into a fresh block if not
+	void Own(size_t capacity = 0)
+	{
+		capacity = std::max(capacity, m_size);
+		if(IsWritable() ? capacity <= Capacity() : !capacity)
+			return;
+
+		auto block = BufferPool::Get().Allocate(capacity);
+		if(m_size)
+			memcpy(block->Bytes(), m_bytes, m_size);
+
+		auto size = m_size;
+		Release();
+
+		m_block = block;
+		m_bytes = block->Bytes();
+		m_size = size;
+	}
+
+	const uint8_t *m_bytes = nullptr;
+	size_t m_size = 0;
+	BufferPool::Block *m_block = nullptr;		// Pooled storage, null for views
+	std::shared_ptr<const void> m_owner;		// What keeps a view's memory valid
 };
 
 }
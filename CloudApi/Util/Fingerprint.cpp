@@ -0,0 +1,295 @@
+#include "Common.h"
+#include "FingerprintLanes.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define FINGERPRINT_HAS_SSE2
+#endif
+
+using namespace Copy;
+
+namespace {
+
+const char s_hexDigits[] = "0123456789abcdef";
+
+// Small enough that a block is still in L1 when the second digest reads it
+const size_t s_fingerprintBlockSize = 4096;
+
+int HexValue(char c)
+{
+	if(c >= '0' && c <= '9')
+		return c - '0';
+	else if(c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	else if(c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/**
+ * EncodeScalar - Writes size bytes as size * 2 lower case hex characters
+ */
+void EncodeScalar(const uint8_t *bytes, size_t size, char *hex)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		hex[i * 2] = s_hexDigits[bytes[i] >> 4];
+		hex[i * 2 + 1] = s_hexDigits[bytes[i] & 0xf];
+	}
+}
+
+/**
+ * DecodeScalar - Reads size bytes from size * 2 hex characters
+ * Returns false on a character that isn't hex
+ */
+bool DecodeScalar(const char *hex, size_t size, uint8_t *bytes)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		auto high = HexValue(hex[i * 2]);
+		auto low = HexValue(hex[i * 2 + 1]);
+		if(high < 0 || low < 0)
+			return false;
+
+		bytes[i] = static_cast<uint8_t>(high << 4 | low);
+	}
+
+	return true;
+}
+
+#ifdef FINGERPRINT_HAS_SSE2
+
+// Nibbles to ascii, digits above 9 are moved up to 'a'
+__m128i NibblesToHex(__m128i nibbles)
+{
+	auto letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('a' - '0' - 10));
+	return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+/**
+ * Encode16 - Writes 16 bytes as 32 hex characters
+ */
+void Encode16(const uint8_t *bytes, char *hex)
+{
+	auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bytes));
+	auto mask = _mm_set1_epi8(0x0f);
+
+	auto high = _mm_and_si128(_mm_srli_epi16(input, 4), mask);
+	auto low = _mm_and_si128(input, mask);
+
+	// Each byte becomes its high then its low nibble
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(hex), NibblesToHex(_mm_unpacklo_epi8(high, low)));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(hex + 16), NibblesToHex(_mm_unpackhi_epi8(high, low)));
+}
+
+// Hex characters to nibbles, valid is set to all ones for each character that was hex
+__m128i HexToNibbles(__m128i chars, __m128i &valid)
+{
+	auto digit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+
+	auto lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+	auto letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+	valid = _mm_or_si128(digit, letter);
+
+	return _mm_or_si128(
+		_mm_and_si128(digit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+		_mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+}
+
+// Joins the high/low nibble pairs in each 16 bit lane into one byte
+__m128i JoinNibbles(__m128i nibbles)
+{
+	auto high = _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00f0));
+	auto low = _mm_srli_epi16(nibbles, 8);
+	return _mm_or_si128(high, low);
+}
+
+/**
+ * Decode16 - Reads 16 bytes from 32 hex characters
+ * Returns false on a character that isn't hex
+ */
+bool Decode16(const char *hex, uint8_t *bytes)
+{
+	__m128i valid1, valid2;
+	auto nibbles1 = HexToNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hex)), valid1);
+	auto nibbles2 = HexToNibbles(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hex + 16)), valid2);
+
+	if(_mm_movemask_epi8(_mm_and_si128(valid1, valid2)) != 0xffff)
+		return false;
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(bytes), _mm_packus_epi16(JoinNibbles(nibbles1), JoinNibbles(nibbles2)));
+	return true;
+}
+
+#endif
+
+enum LaneBackend
+{
+	LANES_NONE,
+	LANES_AVX2,
+	LANES_AVX512,
+};
+
+/**
+ * DetectLaneBackend - Picks the widest multi-buffer backend the cpu and os support
+ */
+LaneBackend DetectLaneBackend()
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx512f"))
+		return LANES_AVX512;
+	else if(__builtin_cpu_supports("avx2"))
+		return LANES_AVX2;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7)
+		return LANES_NONE;
+
+	// The os has to save the ymm (and for avx512 the zmm/opmask) registers
+	__cpuid(info, 1);
+	if(!(info[2] & (1 << 27)))
+		return LANES_NONE;
+
+	auto xcr0 = _xgetbv(0);
+	__cpuidex(info, 7, 0);
+	if((xcr0 & 0xe6) == 0xe6 && (info[1] & (1 << 16)))
+		return LANES_AVX512;
+	else if((xcr0 & 0x06) == 0x06 && (info[1] & (1 << 5)))
+		return LANES_AVX2;
+#endif
+	return LANES_NONE;
+}
+
+}
+
+/**
+ * CreateFingerprints - Fingerprints count buffers, when the cpu allows they are
+ * hashed side by side in SIMD lanes (8 with avx2, 16 with avx512)
+ */
+void Copy::CreateFingerprints(const uint8_t *const *data, const size_t *sizes, size_t count, Fingerprint *fingerprints)
+{
+	static_assert(sizeof(Fingerprint) == Fingerprint::SIZE, "Fingerprint must be its bytes only");
+	static const auto backend = DetectLaneBackend();
+
+	// A lane runs a little slower than a lone scalar hash, it takes a few buffers to pay off
+	auto digests = reinterpret_cast<uint8_t *>(fingerprints);
+	if(backend == LANES_AVX512 && count >= 3 && FingerprintLanes::HashAvx512(data, sizes, count, digests))
+		return;
+	else if(backend >= LANES_AVX2 && count >= 3 && FingerprintLanes::HashAvx2(data, sizes, count, digests))
+		return;
+
+	FingerprintContext context;
+	for(size_t i = 0; i < count; i++)
+	{
+		context.Reset();
+		context.Update(data[i], sizes[i]);
+		fingerprints[i] = context.Final();
+	}
+}
+
+/**
+ * FromHex - Decodes a hex fingerprint
+ * Returns false if it isn't a well formed fingerprint
+ */
+bool Fingerprint::FromHex(const char *hex, size_t length, Fingerprint &fingerprint)
+{
+	if(length != HEX_SIZE)
+		return false;
+
+	auto bytes = fingerprint.m_bytes;
+
+#ifdef FINGERPRINT_HAS_SSE2
+	if(!Decode16(hex, bytes) || !Decode16(hex + 32, bytes + 16))
+		return false;
+
+	return DecodeScalar(hex + 64, SIZE - 32, bytes + 32);
+#else
+	return DecodeScalar(hex, SIZE, bytes);
+#endif
+}
+
+/**
+ * FromHex - Decodes a hex fingerprint, throws if it isn't well formed
+ */
+Fingerprint Fingerprint::FromHex(const std::string &hex)
+{
+	Fingerprint fingerprint;
+	if(!FromHex(hex.data(), hex.size(), fingerprint))
+		throw std::logic_error(std::string("Invalid fingerprint ") + hex);
+
+	return fingerprint;
+}
+
+/**
+ * ToHex - Writes the fingerprint as HEX_SIZE lower case hex characters, hex is
+ * not terminated
+ */
+void Fingerprint::ToHex(char *hex) const
+{
+#ifdef FINGERPRINT_HAS_SSE2
+	Encode16(m_bytes, hex);
+	Encode16(m_bytes + 16, hex + 32);
+	EncodeScalar(m_bytes + 32, SIZE - 32, hex + 64);
+#else
+	EncodeScalar(m_bytes, SIZE, hex);
+#endif
+}
+
+std::string Fingerprint::ToHex() const
+{
+	char hex[HEX_SIZE];
+	ToHex(hex);
+	return std::string(hex, HEX_SIZE);
+}
+
+FingerprintContext::FingerprintContext()
+{
+	Reset();
+}
+
+/**
+ * Reset - Starts a new fingerprint
+ */
+void FingerprintContext::Reset()
+{
+	MD5_Init(&m_md5);
+	SHA1_Init(&m_sha1);
+}
+
+/**
+ * Update - Adds the next piece of data to the fingerprint
+ */
+void FingerprintContext::Update(const void *data, size_t size)
+{
+	auto bytes = static_cast<const uint8_t *>(data);
+
+	while(size)
+	{
+		auto length = std::min(size, s_fingerprintBlockSize);
+
+		MD5_Update(&m_md5, bytes, length);
+		SHA1_Update(&m_sha1, bytes, length);
+
+		bytes += length;
+		size -= length;
+	}
+}
+
+/**
+ * Final - Returns the fingerprint of everything added since the last Reset, the
+ * context must be reset before it is used again
+ */
+Fingerprint FingerprintContext::Final()
+{
+	Fingerprint fingerprint;
+	MD5_Final(fingerprint.GetMd5(), &m_md5);
+	SHA1_Final(fingerprint.GetSha1(), &m_sha1);
+	return fingerprint;
+}
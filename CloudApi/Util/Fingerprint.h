@@ -0,0 +1,88 @@
+#pragma once
+
+namespace Copy {
+
+/**
+ * Fingerprint - Identifies a part by its md5 digest followed by its sha1 digest.
+ * It is held as raw bytes and only spelled out as hex at the wire and json
+ * boundaries. A default constructed fingerprint is all zeros and tests false
+ */
+class Fingerprint
+{
+public:
+	static const size_t MD5_SIZE = 16;
+	static const size_t SHA1_SIZE = 20;
+	static const size_t SIZE = MD5_SIZE + SHA1_SIZE;
+	static const size_t HEX_SIZE = SIZE * 2;
+
+	Fingerprint()
+	{
+		memset(m_bytes, 0, sizeof(m_bytes));
+	}
+
+	static bool FromHex(const char *hex, size_t length, Fingerprint &fingerprint);
+	static Fingerprint FromHex(const std::string &hex);
+
+	void ToHex(char *hex) const;
+	std::string ToHex() const;
+
+	uint8_t *GetBytes() { return m_bytes; }
+	const uint8_t *GetBytes() const { return m_bytes; }
+
+	uint8_t *GetMd5() { return m_bytes; }
+	uint8_t *GetSha1() { return m_bytes + MD5_SIZE; }
+
+	// The leading md5 bytes are already well mixed
+	size_t Hash() const
+	{
+		size_t hash;
+		memcpy(&hash, m_bytes, sizeof(hash));
+		return hash;
+	}
+
+	explicit operator bool () const { return *this != Fingerprint(); }
+
+	bool operator == (const Fingerprint &fingerprint) const { return memcmp(m_bytes, fingerprint.m_bytes, SIZE) == 0; }
+	bool operator != (const Fingerprint &fingerprint) const { return !(*this == fingerprint); }
+	bool operator < (const Fingerprint &fingerprint) const { return memcmp(m_bytes, fingerprint.m_bytes, SIZE) < 0; }
+
+protected:
+	uint8_t m_bytes[SIZE];
+};
+
+/**
+ * FingerprintContext - Builds a fingerprint from data handed over in pieces, md5 and
+ * sha1 take turns on each block so it is only pulled through the cache once
+ */
+class FingerprintContext
+{
+public:
+	FingerprintContext();
+
+	void Reset();
+	void Update(const void *data, size_t size);
+	Fingerprint Final();
+
+protected:
+	MD5_CTX m_md5;
+	SHA_CTX m_sha1;
+};
+
+void CreateFingerprints(const uint8_t *const *data, const size_t *sizes, size_t count, Fingerprint *fingerprints);
+
+inline std::ostream &operator << (std::ostream &stream, const Fingerprint &fingerprint)
+{
+	return stream << fingerprint.ToHex();
+}
+
+}
+
+namespace std {
+
+template<>
+struct hash<Copy::Fingerprint>
+{
+	size_t operator () (const Copy::Fingerprint &fingerprint) const { return fingerprint.Hash(); }
+};
+
+}
@@ -0,0 +1,108 @@
+// Built with avx2 enabled, so this must not include Common.h or anything else with
+// inline code shared with the rest of the library
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "FingerprintLanes.h"
+
+#ifdef __AVX2__
+
+#include <immintrin.h>
+#include "FingerprintLanes.hpp"
+
+namespace {
+
+// 8 lanes of 32 bit words
+struct Avx2
+{
+	typedef __m256i Vec;
+	static const size_t LANES = 8;
+
+	static Vec Load(const uint32_t *words) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words)); }
+	static void Store(uint32_t *words, Vec v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(words), v); }
+	static Vec Set1(uint32_t word) { return _mm256_set1_epi32(static_cast<int>(word)); }
+
+	static Vec Add(Vec a, Vec b) { return _mm256_add_epi32(a, b); }
+	static Vec Xor(Vec a, Vec b) { return _mm256_xor_si256(a, b); }
+
+	template<int N>
+	static Vec Rotl(Vec v) { return _mm256_or_si256(_mm256_slli_epi32(v, N), _mm256_srli_epi32(v, 32 - N)); }
+
+	static Vec Md5F(Vec b, Vec c, Vec d) { return _mm256_xor_si256(d, _mm256_and_si256(b, _mm256_xor_si256(c, d))); }
+	static Vec Md5G(Vec b, Vec c, Vec d) { return _mm256_xor_si256(c, _mm256_and_si256(d, _mm256_xor_si256(b, c))); }
+	static Vec Md5H(Vec b, Vec c, Vec d) { return _mm256_xor_si256(_mm256_xor_si256(b, c), d); }
+	static Vec Md5I(Vec b, Vec c, Vec d)
+	{
+		return _mm256_xor_si256(c, _mm256_or_si256(b, _mm256_xor_si256(d, _mm256_set1_epi32(-1))));
+	}
+
+	static Vec Sha1Ch(Vec b, Vec c, Vec d) { return Md5F(b, c, d); }
+	static Vec Sha1Parity(Vec b, Vec c, Vec d) { return Md5H(b, c, d); }
+	static Vec Sha1Maj(Vec b, Vec c, Vec d)
+	{
+		return _mm256_or_si256(_mm256_and_si256(b, c), _mm256_and_si256(d, _mm256_or_si256(b, c)));
+	}
+
+	static Vec ByteSwap(Vec v)
+	{
+		const auto mask = _mm256_setr_epi8(
+			3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+			3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+		return _mm256_shuffle_epi8(v, mask);
+	}
+
+	/**
+	 * LoadWords - Transposes one block per lane into 16 vectors, vector i holds
+	 * word i of every lane's block
+	 */
+	static void LoadWords(const uint8_t *const *blocks, Vec words[16])
+	{
+		for(int half = 0; half < 2; half++)
+		{
+			Vec r[8];
+			for(int l = 0; l < 8; l++)
+				r[l] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks[l] + half * 32));
+
+			auto t0 = _mm256_unpacklo_epi32(r[0], r[1]), t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+			auto t2 = _mm256_unpacklo_epi32(r[2], r[3]), t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+			auto t4 = _mm256_unpacklo_epi32(r[4], r[5]), t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+			auto t6 = _mm256_unpacklo_epi32(r[6], r[7]), t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+			auto u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+			auto u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+			auto u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+			auto u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+
+			auto out = words + half * 8;
+			out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+			out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+			out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+			out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+			out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+			out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+			out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+			out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+		}
+	}
+};
+
+}
+
+#endif
+
+namespace Copy {
+	namespace FingerprintLanes {
+
+bool HashAvx2(const uint8_t *const *data, const size_t *sizes, size_t count, uint8_t *digests)
+{
+#ifdef __AVX2__
+	HashLanes<Avx2>(data, sizes, count, digests);
+	return true;
+#else
+	return false;
+#endif
+}
+
+	}
+}
@@ -0,0 +1,107 @@
+// Built with avx512f enabled, so this must not include Common.h or anything else
+// with inline code shared with the rest of the library
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "FingerprintLanes.h"
+
+#ifdef __AVX512F__
+
+#include <immintrin.h>
+#include "FingerprintLanes.hpp"
+
+namespace {
+
+// 16 lanes of 32 bit words, the boolean functions are single ternary logic ops
+struct Avx512
+{
+	typedef __m512i Vec;
+	static const size_t LANES = 16;
+
+	static Vec Load(const uint32_t *words) { return _mm512_loadu_si512(words); }
+	static void Store(uint32_t *words, Vec v) { _mm512_storeu_si512(words, v); }
+	static Vec Set1(uint32_t word) { return _mm512_set1_epi32(static_cast<int>(word)); }
+
+	static Vec Add(Vec a, Vec b) { return _mm512_add_epi32(a, b); }
+	static Vec Xor(Vec a, Vec b) { return _mm512_xor_si512(a, b); }
+
+	template<int N>
+	static Vec Rotl(Vec v) { return _mm512_rol_epi32(v, N); }
+
+	static Vec Md5F(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0xca); }
+	static Vec Md5G(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0xe4); }
+	static Vec Md5H(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0x96); }
+	static Vec Md5I(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0x39); }
+
+	static Vec Sha1Ch(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0xca); }
+	static Vec Sha1Parity(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0x96); }
+	static Vec Sha1Maj(Vec b, Vec c, Vec d) { return _mm512_ternarylogic_epi32(b, c, d, 0xe8); }
+
+	// Byte shuffles need avx512bw, two rotates and a select only need avx512f
+	static Vec ByteSwap(Vec v)
+	{
+		return _mm512_ternarylogic_epi32(_mm512_set1_epi32(0x00ff00ff), _mm512_rol_epi32(v, 8), _mm512_rol_epi32(v, 24), 0xca);
+	}
+
+	/**
+	 * LoadWords - Transposes one block per lane into 16 vectors, vector i holds
+	 * word i of every lane's block
+	 */
+	static void LoadWords(const uint8_t *const *blocks, Vec words[16])
+	{
+		Vec r[16], t[16];
+		for(int l = 0; l < 16; l++)
+			r[l] = _mm512_loadu_si512(blocks[l]);
+
+		// Transpose the 4x4 words within each 128 bit lane
+		for(int i = 0; i < 16; i += 2)
+		{
+			t[i] = _mm512_unpacklo_epi32(r[i], r[i + 1]);
+			t[i + 1] = _mm512_unpackhi_epi32(r[i], r[i + 1]);
+		}
+
+		for(int i = 0; i < 16; i += 4)
+		{
+			r[i] = _mm512_unpacklo_epi64(t[i], t[i + 2]);
+			r[i + 1] = _mm512_unpackhi_epi64(t[i], t[i + 2]);
+			r[i + 2] = _mm512_unpacklo_epi64(t[i + 1], t[i + 3]);
+			r[i + 3] = _mm512_unpackhi_epi64(t[i + 1], t[i + 3]);
+		}
+
+		// Then the 4x4 128 bit lanes across each group of rows, r[4 * g + c] holds
+		// word 4 * lane + c of rows 4 * g to 4 * g + 3
+		for(int c = 0; c < 4; c++)
+		{
+			auto v0 = _mm512_shuffle_i32x4(r[c], r[4 + c], 0x44);
+			auto v1 = _mm512_shuffle_i32x4(r[c], r[4 + c], 0xee);
+			auto v2 = _mm512_shuffle_i32x4(r[8 + c], r[12 + c], 0x44);
+			auto v3 = _mm512_shuffle_i32x4(r[8 + c], r[12 + c], 0xee);
+
+			words[c] = _mm512_shuffle_i32x4(v0, v2, 0x88);
+			words[4 + c] = _mm512_shuffle_i32x4(v0, v2, 0xdd);
+			words[8 + c] = _mm512_shuffle_i32x4(v1, v3, 0x88);
+			words[12 + c] = _mm512_shuffle_i32x4(v1, v3, 0xdd);
+		}
+	}
+};
+
+}
+
+#endif
+
+namespace Copy {
+	namespace FingerprintLanes {
+
+bool HashAvx512(const uint8_t *const *data, const size_t *sizes, size_t count, uint8_t *digests)
+{
+#ifdef __AVX512F__
+	HashLanes<Avx512>(data, sizes, count, digests);
+	return true;
+#else
+	return false;
+#endif
+}
+
+	}
+}
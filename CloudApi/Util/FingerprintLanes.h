@@ -0,0 +1,16 @@
+#pragma once
+
+namespace Copy {
+	namespace FingerprintLanes {
+
+/**
+ * Multi-buffer fingerprint backends, each hashes count buffers side by side in
+ * SIMD lanes and writes count 36 byte md5+sha1 digests to digests. They return
+ * false when the backend wasn't built for this target, the caller must check the
+ * cpu supports it before calling
+ */
+bool HashAvx2(const uint8_t *const *data, const size_t *sizes, size_t count, uint8_t *digests);
+bool HashAvx512(const uint8_t *const *data, const size_t *sizes, size_t count, uint8_t *digests);
+
+	}
+}
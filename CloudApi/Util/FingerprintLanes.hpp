@@ -0,0 +1,305 @@
+#pragma once
+
+/*
+ * Multi-buffer md5+sha1, every SIMD lane hashes a different buffer. This is only
+ * included by the backend translation units and kept in an anonymous namespace, so
+ * each copy is built with, and only ever run under, that unit's target flags.
+ * V supplies the vector type and operations for a backend
+ */
+
+namespace Copy {
+	namespace FingerprintLanes {
+		namespace {
+
+const uint32_t s_md5K[64] =
+{
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+const uint32_t s_md5Init[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+const uint32_t s_sha1Init[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+const size_t BLOCK_SIZE = 64;
+
+#define MD5_STEP(f, a, b, c, d, i, g, s) \
+	a = V::Add(b, V::template Rotl<s>(V::Add(V::Add(a, V::f(b, c, d)), V::Add(w[g], V::Set1(s_md5K[i])))))
+
+/**
+ * Md5Compress - Runs one block per lane through md5, w holds the block's
+ * little endian words
+ */
+template<typename V>
+void Md5Compress(typename V::Vec state[4], const typename V::Vec w[16])
+{
+	auto a = state[0], b = state[1], c = state[2], d = state[3];
+
+	for(int i = 0; i < 16; i += 4)
+	{
+		MD5_STEP(Md5F, a, b, c, d, i, i, 7);
+		MD5_STEP(Md5F, d, a, b, c, i + 1, i + 1, 12);
+		MD5_STEP(Md5F, c, d, a, b, i + 2, i + 2, 17);
+		MD5_STEP(Md5F, b, c, d, a, i + 3, i + 3, 22);
+	}
+
+	for(int i = 16; i < 32; i += 4)
+	{
+		MD5_STEP(Md5G, a, b, c, d, i, (5 * i + 1) & 15, 5);
+		MD5_STEP(Md5G, d, a, b, c, i + 1, (5 * i + 6) & 15, 9);
+		MD5_STEP(Md5G, c, d, a, b, i + 2, (5 * i + 11) & 15, 14);
+		MD5_STEP(Md5G, b, c, d, a, i + 3, (5 * i + 16) & 15, 20);
+	}
+
+	for(int i = 32; i < 48; i += 4)
+	{
+		MD5_STEP(Md5H, a, b, c, d, i, (3 * i + 5) & 15, 4);
+		MD5_STEP(Md5H, d, a, b, c, i + 1, (3 * i + 8) & 15, 11);
+		MD5_STEP(Md5H, c, d, a, b, i + 2, (3 * i + 11) & 15, 16);
+		MD5_STEP(Md5H, b, c, d, a, i + 3, (3 * i + 14) & 15, 23);
+	}
+
+	for(int i = 48; i < 64; i += 4)
+	{
+		MD5_STEP(Md5I, a, b, c, d, i, (7 * i) & 15, 6);
+		MD5_STEP(Md5I, d, a, b, c, i + 1, (7 * i + 7) & 15, 10);
+		MD5_STEP(Md5I, c, d, a, b, i + 2, (7 * i + 14) & 15, 15);
+		MD5_STEP(Md5I, b, c, d, a, i + 3, (7 * i + 21) & 15, 21);
+	}
+
+	state[0] = V::Add(state[0], a);
+	state[1] = V::Add(state[1], b);
+	state[2] = V::Add(state[2], c);
+	state[3] = V::Add(state[3], d);
+}
+
+#undef MD5_STEP
+
+#define SHA1_STEP(f, k, t) \
+	{ \
+		if(t >= 16) \
+			w[t & 15] = V::template Rotl<1>(V::Xor(V::Xor(w[(t + 13) & 15], w[(t + 8) & 15]), V::Xor(w[(t + 2) & 15], w[t & 15]))); \
+		auto temp = V::Add(V::Add(V::template Rotl<5>(a), V::f(b, c, d)), V::Add(V::Add(e, V::Set1(k)), w[t & 15])); \
+		e = d; \
+		d = c; \
+		c = V::template Rotl<30>(b); \
+		b = a; \
+		a = temp; \
+	}
+
+/**
+ * Sha1Compress - Runs one block per lane through sha1, w holds the block's
+ * big endian words and is used as the message schedule
+ */
+template<typename V>
+void Sha1Compress(typename V::Vec state[5], typename V::Vec w[16])
+{
+	auto a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+	for(int t = 0; t < 20; t++)
+		SHA1_STEP(Sha1Ch, 0x5a827999, t)
+	for(int t = 20; t < 40; t++)
+		SHA1_STEP(Sha1Parity, 0x6ed9eba1, t)
+	for(int t = 40; t < 60; t++)
+		SHA1_STEP(Sha1Maj, 0x8f1bbcdc, t)
+	for(int t = 60; t < 80; t++)
+		SHA1_STEP(Sha1Parity, 0xca62c1d6, t)
+
+	state[0] = V::Add(state[0], a);
+	state[1] = V::Add(state[1], b);
+	state[2] = V::Add(state[2], c);
+	state[3] = V::Add(state[3], d);
+	state[4] = V::Add(state[4], e);
+}
+
+#undef SHA1_STEP
+
+/**
+ * Compress - Feeds one block per lane to both digests, sha1Blocks is only set
+ * when a lane's padding differs between the two (the length is stored little
+ * endian for md5 and big endian for sha1)
+ */
+template<typename V>
+void Compress(typename V::Vec md5[4], typename V::Vec sha1[5],
+	const uint8_t *const *md5Blocks, const uint8_t *const *sha1Blocks)
+{
+	typename V::Vec w[16];
+
+	V::LoadWords(md5Blocks, w);
+	Md5Compress<V>(md5, w);
+
+	if(sha1Blocks)
+		V::LoadWords(sha1Blocks, w);
+
+	for(int i = 0; i < 16; i++)
+		w[i] = V::ByteSwap(w[i]);
+
+	Sha1Compress<V>(sha1, w);
+}
+
+// A buffer being hashed in a lane
+struct Lane
+{
+	bool active;
+	size_t part;
+	const uint8_t *next;			// Next full block of the buffer
+	size_t dataBlocks;				// Full blocks left in the buffer
+	size_t tailBlocks;				// Padded blocks left after those
+	size_t tailOffset;
+	uint8_t md5Tail[BLOCK_SIZE * 2];
+	uint8_t sha1Tail[BLOCK_SIZE * 2];
+};
+
+/**
+ * StartLane - Points a lane at a buffer, the bytes after its last full block are
+ * copied out and padded with each digest's length encoding
+ */
+void StartLane(Lane &lane, size_t part, const uint8_t *data, size_t size)
+{
+	auto fullBlocks = size / BLOCK_SIZE;
+	auto remainder = size - fullBlocks * BLOCK_SIZE;
+	auto tailSize = remainder + 1 + 8 <= BLOCK_SIZE ? BLOCK_SIZE : BLOCK_SIZE * 2;
+
+	memset(lane.md5Tail, 0, tailSize);
+	if(remainder)
+		memcpy(lane.md5Tail, data + fullBlocks * BLOCK_SIZE, remainder);
+	lane.md5Tail[remainder] = 0x80;
+
+	memcpy(lane.sha1Tail, lane.md5Tail, tailSize);
+
+	uint64_t bits = static_cast<uint64_t>(size) * 8;
+	for(int i = 0; i < 8; i++)
+	{
+		lane.md5Tail[tailSize - 8 + i] = static_cast<uint8_t>(bits >> (i * 8));
+		lane.sha1Tail[tailSize - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+	}
+
+	lane.active = true;
+	lane.part = part;
+	lane.next = data;
+	lane.dataBlocks = fullBlocks;
+	lane.tailBlocks = tailSize / BLOCK_SIZE;
+	lane.tailOffset = 0;
+}
+
+/**
+ * HashLanes - Hashes count buffers, a lane picks up the next buffer as soon as
+ * its current one is done
+ */
+template<typename V>
+void HashLanes(const uint8_t *const *data, const size_t *sizes, size_t count, uint8_t *digests)
+{
+	typedef typename V::Vec Vec;
+	const size_t LANES = V::LANES;
+
+	// Lanes with nothing to do hash this and their result is dropped
+	static const uint8_t s_idleBlock[BLOCK_SIZE] = {};
+
+	Lane lanes[LANES];
+	uint32_t md5State[4][LANES];
+	uint32_t sha1State[5][LANES];
+
+	for(size_t l = 0; l < LANES; l++)
+		lanes[l].active = false;
+
+	size_t nextPart = 0;
+	while(true)
+	{
+		// Refill idle lanes, then run until the first lane finishes
+		size_t run = 0;
+		for(size_t l = 0; l < LANES; l++)
+		{
+			auto &lane = lanes[l];
+			if(!lane.active && nextPart < count)
+			{
+				StartLane(lane, nextPart, data[nextPart], sizes[nextPart]);
+				nextPart++;
+
+				for(int i = 0; i < 4; i++)
+					md5State[i][l] = s_md5Init[i];
+				for(int i = 0; i < 5; i++)
+					sha1State[i][l] = s_sha1Init[i];
+			}
+
+			auto left = lane.dataBlocks + lane.tailBlocks;
+			if(lane.active && (!run || left < run))
+				run = left;
+		}
+
+		if(!run)
+			break;
+
+		Vec md5[4], sha1[5];
+		for(int i = 0; i < 4; i++)
+			md5[i] = V::Load(md5State[i]);
+		for(int i = 0; i < 5; i++)
+			sha1[i] = V::Load(sha1State[i]);
+
+		const uint8_t *md5Blocks[LANES];
+		const uint8_t *sha1Blocks[LANES];
+
+		for(size_t step = 0; step < run; step++)
+		{
+			bool padding = false;
+
+			for(size_t l = 0; l < LANES; l++)
+			{
+				auto &lane = lanes[l];
+				if(!lane.active)
+					md5Blocks[l] = sha1Blocks[l] = s_idleBlock;
+				else if(lane.dataBlocks)
+				{
+					md5Blocks[l] = sha1Blocks[l] = lane.next;
+					lane.next += BLOCK_SIZE;
+					lane.dataBlocks--;
+				}
+				else
+				{
+					md5Blocks[l] = lane.md5Tail + lane.tailOffset;
+					sha1Blocks[l] = lane.sha1Tail + lane.tailOffset;
+					lane.tailOffset += BLOCK_SIZE;
+					lane.tailBlocks--;
+					padding = true;
+				}
+			}
+
+			Compress<V>(md5, sha1, md5Blocks, padding ? sha1Blocks : nullptr);
+		}
+
+		for(int i = 0; i < 4; i++)
+			V::Store(md5State[i], md5[i]);
+		for(int i = 0; i < 5; i++)
+			V::Store(sha1State[i], sha1[i]);
+
+		// Md5 words are little endian, sha1 words big endian
+		for(size_t l = 0; l < LANES; l++)
+		{
+			auto &lane = lanes[l];
+			if(!lane.active || lane.dataBlocks || lane.tailBlocks)
+				continue;
+
+			auto digest = digests + lane.part * 36;
+			for(int i = 0; i < 4; i++)
+			{
+				for(int j = 0; j < 4; j++)
+					digest[i * 4 + j] = static_cast<uint8_t>(md5State[i][l] >> (j * 8));
+			}
+			for(int i = 0; i < 5; i++)
+			{
+				for(int j = 0; j < 4; j++)
+					digest[16 + i * 4 + j] = static_cast<uint8_t>(sha1State[i][l] >> (24 - j * 8));
+			}
+
+			lane.active = false;
+		}
+	}
+}
+
+		}
+	}
+}
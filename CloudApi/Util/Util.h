@@ -2,6 +2,11 @@
 
 namespace Copy {
 
+	inline bool IsDigit(char chr)
+	{
+		return chr >= '0' && chr <= '9';
+	}
+
 	inline std::pair<std::string, std::string> SplitString(std::string s, const std::string &delim) 
 	{
 		auto position = s.find(delim);
@@ -11,7 +16,7 @@ namespace Copy {
 		std::pair<std::string, std::string> result;
 
 		result.second = s.substr(position + delim.size());
-		s.resize(s.size() - position + delim.size());
+		s.resize(position);
 		result.first = s;
 
 		return result;
@@ -62,26 +67,35 @@ namespace Copy {
 	 * CreateFingerprint - Fingerprints a chunk of data,
 	 * a fingerprint is an md5+sha1
 	 */
-	inline std::string CreateFingerprint(const Data &data)
+	inline Fingerprint CreateFingerprint(const Data &data)
 	{
-		std::string result;
-
-		MD5_CTX md5Ctx;
-		MD5_Init(&md5Ctx);
-		MD5_Update(&md5Ctx, data.Cast<uint8_t>(), data.Size());
-		Data md5digest(16);
-		MD5_Final(md5digest.Cast<uint8_t>(0, 16), &md5Ctx);
-		result += HexDump(md5digest);
+		FingerprintContext context;
+		context.Update(data.Cast<uint8_t>(), data.Size());
+		return context.Final();
+	}
 
-		SHA_CTX sha1Ctx;
-		SHA1_Init(&sha1Ctx);
-		SHA1_Update(&sha1Ctx, data.Cast<uint8_t>(), data.Size());
-		Data sha1digest(20);
-		SHA1_Final(sha1digest.Cast<uint8_t>(0, 20), &sha1Ctx);
+	/**
+	 * CreateFingerprints - Fingerprints a batch of chunks, several are hashed
+	 * at once when the cpu has wide enough SIMD
+	 */
+	inline std::vector<Fingerprint> CreateFingerprints(const Data *buffers, size_t count)
+	{
+		std::vector<const uint8_t *> data(count);
+		std::vector<size_t> sizes(count);
+		for(size_t i = 0; i < count; i++)
+		{
+			data[i] = buffers[i].Cast<uint8_t>();
+			sizes[i] = buffers[i].Size();
+		}
 
-		result += HexDump(sha1digest);
+		std::vector<Fingerprint> fingerprints(count);
+		CreateFingerprints(data.data(), sizes.data(), count, fingerprints.data());
+		return fingerprints;
+	}
 
-		return result;
+	inline std::vector<Fingerprint> CreateFingerprints(const std::vector<Data> &buffers)
+	{
+		return CreateFingerprints(buffers.data(), buffers.size());
 	}
 
 	/**
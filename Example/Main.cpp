@@ -38,108 +38,43 @@ static void DoGet(CloudApi &cloudApi, program_options::variables_map &vm)
 
 	std::cout << "Downloading " << cloudPath << " to " << filePath << std::endl;
 
-	// List the file to get its part list
-	CloudApi::ListConfig config;
-	config.path = cloudPath;
-	config.includeParts = true;
-
-	auto result = cloudApi.ListPath(config);
-
-	// Fetch the parts and write them to the target file
-	std::ofstream file;
-	file.open(filePath, std::ios::binary | std::ofstream::trunc);
-	if(!file.is_open())
-		throw std::logic_error(std::string("Failed to open ") + filePath);
-
-	uint64_t offset = 0;
-	for(auto &part : result.root.parts)
-	{
-		cloudApi.GetPart(part);
-
-		// And write it out
-		file.seekp(offset);
-        if(static_cast<uint64_t>(file.tellp()) != offset)
-        {
-            std::cout << "Failed to seek to offset " << offset << std::endl;
-            return;
-        }
-		file.write(part.data.Cast<char>(), part.data.Size());
-		offset += part.data.Size();
-	}
+	// Parts are fetched over several connections and written straight to their
+	// offsets, the target only appears once it's complete
+	Transfer::DownloadEngine engine(cloudApi);
+	engine.DownloadFile(cloudPath, filePath);
 
 	std::cout << "Successfully downloaded " << cloudPath << " to " << filePath << std::endl;
-
-	file.close();
 }
 
 static void DoSend(CloudApi &cloudApi, program_options::variables_map &vm)
 {
-	std::ifstream file;
 	auto filePath = vm["send"].as<std::string>();
 	auto cloudPath = vm["target"].as<std::string>();
 
 	std::cout << "Sending " << filePath << " to " << cloudPath << std::endl;
 
-	file.open(filePath, std::ios::binary);
-	if(!file.is_open())
-		throw std::logic_error(std::string("Failed to open ") + filePath);
-	
-	std::vector<CloudApi::PartInfo> parts;
-	std::vector<CloudApi::PartInfo> partBatch;
+	// Reading, chunking, hashing, dedupe and sending all run at once
+	Transfer::UploadPipeline pipeline(cloudApi);
+	auto parts = pipeline.Upload(filePath, cloudPath);
 
-	// This function will send up a batch of parts, move them to the pain part array,
-	// and free their data
-	auto sendPartBatch = [&]()
+	auto &stats = pipeline.GetStats();
+	std::cout << "Sent " << stats.send.items << " of " << parts.size() << " part(s) in " << stats.elapsedSeconds << "s" << std::endl;
+
+	auto printStage = [&](const char *name, const Transfer::UploadPipeline::StageStats &stage)
 		{
-			std::cout << "Sending " << partBatch.size() << " part(s)" << std::endl;
-
-			cloudApi.SendNeededParts(partBatch);
-			
-			// Clear their data and transfer back to main part bucket
-			for(auto &part : partBatch)
-			{
-				part.data.Release();
-				parts.push_back(std::move(part));
-			}
-
-			partBatch.clear();
+			std::cout << "  " << name << ": " << std::fixed << std::setprecision(1) <<
+				stage.Utilization(stats.elapsedSeconds) * 100 << "% busy, " <<
+				stage.stalledSeconds << "s stalled" << std::endl;
 		};
 
-	// Read in 1MB chunks, and send the parts along the way
-	uint64_t offset = 0;
-	while(1)
-	{
-		CloudApi::PartInfo part;
-
-		// Read as much as we can
-		part.data.Resize(1024 * 1024);
-		file.seekg(offset, std::ios::beg);
-		file.read(part.data.Cast<char>(), part.data.Size());
-
-		part.data.Resize(file.gcount());
-
-		if(part.data.IsEmpty())
-			break;
-
-		// Prepare the part
-		part.fingerprint = CreateFingerprint(part.data);
-		part.offset = offset;
-        part.size = part.data.Size();
-		offset += part.data.Size();
-
-		// Add it to our batch
-		partBatch.push_back(std::move(part));
-
-		// Send 5 up at a time
-		if(partBatch.size() == 5)
-			sendPartBatch();
-	}
-
-	// Send up any stragglers
-	sendPartBatch();
+	printStage("read", stats.read);
+	printStage("chunk", stats.chunk);
+	printStage("hash", stats.hash);
+	printStage("dedupe", stats.dedupe);
+	printStage("send", stats.send);
 
-	// And now create the file
-	cloudApi.CreateFile(cloudPath, parts);
+	auto buffers = BufferPool::Get().GetStats();
+	std::cout << "  buffers: " << buffers.allocations << " allocated, " << buffers.reuses << " reused" << std::endl;
 }
 
 int main(int argc, const char *argv[])
@@ -0,0 +1,160 @@
+#include "CloudApi/Common.h"
+
+using namespace Copy;
+
+/**
+ * Parses a generated 10,000 child list_objects reply with ParseJsonDocument
+ * and ParseListReply while counting operator new. Every allocation has to be
+ * one the result owns (the children vector, each child's path and parts
+ * vector) apart from a few dozen that don't grow with the children, so a copy
+ * of any array or object in the reply, which costs allocations per child,
+ * fails it. Children carry fields nothing reads, arrays and objects among
+ * them, so skipping those is covered too
+ */
+namespace {
+
+static const size_t CHILD_COUNT = 10000;
+
+// Allocations outside the result allowed per parse: the document and lists
+// that double as the reply grows, about 30 here. A copy of any container
+// costs one or more per child
+static const uint64_t FIXED_ALLOCATIONS = 64;
+
+std::atomic<uint64_t> s_allocations(0);
+
+class ListApi : public CloudApi
+{
+public:
+	ListApi() : CloudApi(Config()) {}
+
+	using CloudApi::ParseJsonDocument;
+	using CloudApi::ParseListReply;
+};
+
+/**
+ * MakeListing - Every path is too long for any string's small buffer, so each
+ * child's path is exactly one allocation
+ */
+std::string MakeListing(size_t children)
+{
+	std::ostringstream reply;
+	reply << "{\"jsonrpc\":\"2.0\",\"id\":\"0\",\"result\":{\"list_watermark\":\"" << children << "\",\"more_items\":\"0\","
+		"\"object\":{\"path\":\"/listing\",\"type\":\"dir\"},\"children\":[";
+
+	for(size_t i = 0; i < children; i++)
+	{
+		auto dir = i % 4 == 0;
+
+		reply << (i ? "," : "") << "{\"path\":\"/listing/reports/" << (dir ? "folder_" : "file_") << std::setw(6) << std::setfill('0') << i << "\","
+			<< "\"type\":\"" << (dir ? "dir" : "file") << "\",\"object_id\":\"" << i + 1 << "\",\"modified_time\":" << 1400000000 + i << ","
+			<< "\"share_id\":\"0\",\"public_link\":null,\"stub\":{\"a\":[1,2,{\"b\":\"unused\"}],\"c\":true}";
+
+		if(dir)
+			reply << ",\"children_count\":\"" << i % 50 << "\"}";
+		else
+		{
+			reply << ",\"size\":\"2097152\",\"revisions\":[{\"revision_id\":\"1\",\"parts\":[";
+			for(uint32_t part = 0; part < 2; part++)
+			{
+				reply << (part ? "," : "") << "{\"fingerprint\":\"" << std::setw(Fingerprint::HEX_SIZE) << std::setfill('a') << i
+					<< "\",\"offset\":\"" << part * 1048576 << "\",\"size\":\"1048576\"}";
+			}
+			reply << "]},{\"revision_id\":\"0\",\"parts\":[]}]}";
+		}
+	}
+
+	reply << "]}}";
+	return reply.str();
+}
+
+/**
+ * Owned - Allocations the result holds on to
+ */
+uint64_t Owned(const CloudApi::ListResult &result)
+{
+	uint64_t owned = result.children.empty() ? 0 : 1;
+	for(auto &child : result.children)
+	{
+		owned++;
+		if(!child.parts.empty())
+			owned++;
+	}
+
+	return owned;
+}
+
+void Check(bool condition, const std::string &message)
+{
+	if(!condition)
+		throw std::logic_error(message);
+}
+
+}
+
+// Counts every allocation the test makes
+void *operator new(size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	if(auto memory = malloc(size ? size : 1))
+		return memory;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void *memory) NOEXCEPT
+{
+	free(memory);
+}
+
+int main()
+{
+	try
+	{
+		ListApi api;
+		Data reply(MakeListing(CHILD_COUNT));
+
+		uint64_t allocations = 0;
+		CloudApi::ListResult result;
+		{
+			auto before = s_allocations.load();
+
+			std::map<std::string, std::string> headerFields;
+			auto document = api.ParseJsonDocument(reply, headerFields);
+
+			CloudApi::ListConfig config;
+			result = api.ParseListReply(config, document->GetRoot().At("result"));
+
+			allocations = s_allocations.load() - before;
+		}
+
+		Check(result.root.path == "/listing", "Root wasn't read");
+		Check(result.children.size() == CHILD_COUNT, "Read " + std::to_string(result.children.size()) + " children");
+		Check(result.index == CHILD_COUNT, "Watermark wasn't read");
+
+		for(size_t i = 0; i < CHILD_COUNT; i++)
+		{
+			auto &child = result.children[i];
+			auto dir = i % 4 == 0;
+
+			Check(child.type == (dir ? "dir" : "file") && child.id == i + 1 && child.modifiedTime == 1400000000 + i,
+				"Child " + std::to_string(i) + " was misread");
+			Check(dir ? child.childCount == i % 50 : child.size == 2097152 && child.parts.size() == 2 && child.parts[1].offset == 1048576,
+				"Child " + std::to_string(i) + " was misread");
+		}
+
+		auto owned = Owned(result);
+		std::cout << CHILD_COUNT << " children, " << allocations << " allocations, " << owned << " owned by the result" << std::endl;
+
+		Check(allocations >= owned, "Fewer allocations than the result owns, the counter isn't working");
+		Check(allocations - owned <= FIXED_ALLOCATIONS, std::to_string(allocations - owned) + " allocations the result doesn't own, "
+			"more than the " + std::to_string(FIXED_ALLOCATIONS) + " allowed. Something in the reply was copied");
+	}
+	catch(const std::exception &e)
+	{
+		std::cerr << "FAILED: " << e.what() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Passed" << std::endl;
+	return 0;
+}